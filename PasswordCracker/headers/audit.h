@@ -0,0 +1,100 @@
+/**
+ * @file audit.h
+ * @author Luke Early
+ * Header file for audit.c
+ */
+
+#ifndef _AUDIT_H_
+#define _AUDIT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pool.h"
+#include "targets.h"
+#include "results.h"
+#include "engine.h"
+
+/** A password found in an earlier audit. */
+typedef struct {
+  // Fingerprint of the cracked target.
+  uint64_t target;
+
+  // The password.
+  Password pass;
+} AuditHit;
+
+/**
+ * What an earlier audit covered: every word in one set was tried
+ * against every target in another, and these are the passwords it
+ * found.  Words and targets are kept as sorted fingerprints.
+ */
+typedef struct {
+  // Fingerprints of the words tried.
+  uint64_t *words;
+  long long wordCount;
+
+  // Fingerprints of the targets they were tried against.
+  uint64_t *targets;
+  long long targetCount;
+
+  // Passwords found.
+  AuditHit *hits;
+  long long hitCount;
+} AuditState;
+
+/**
+ * Reads the state of an earlier audit.  A file that doesn't exist
+ * gives an empty state, as for a first audit.
+ * 
+ * @param name name of the state file
+ * @return pointer to the state, or NULL if the file isn't a valid state
+ */
+AuditState *loadAuditState( char const *name );
+
+/**
+ * Writes an audit state to a file, replacing the old file only once
+ * the new one is complete.
+ * 
+ * @param name name of the state file
+ * @param state state to write
+ * @return true if the state was written
+ */
+bool saveAuditState( char const *name, AuditState const *state );
+
+/**
+ * Makes the state recording that every dictionary word was tried
+ * against every target, with the given results.
+ * 
+ * @param dict dictionary words
+ * @param store targets
+ * @param results every password found for the targets with the words
+ * @return pointer to the newly created state
+ */
+AuditState *makeAuditState( WordPool const *dict, TargetStore const *store, Results const *results );
+
+/**
+ * Frees the memory previously allocated to the given state.
+ * 
+ * @param state state to free
+ */
+void freeAuditState( AuditState *state );
+
+/**
+ * Cracks the targets with the dictionary, doing only the work an
+ * earlier audit didn't.  New words are tried against every target,
+ * and old words only against new targets.  Passwords the earlier
+ * audit found with words still in the dictionary are reported again,
+ * so the results are the same as for a full run.
+ * 
+ * @param dict dictionary words
+ * @param store targets to crack
+ * @param old state of the earlier audit
+ * @param results where matches are reported
+ * @param filter candidates tried so far, or NULL to hash repeats too
+ * @param opts settings for the run
+ * @param stats counters for the run
+ */
+void crackIncremental( WordPool const *dict, TargetStore const *store, AuditState const *old,
+                       Results *results, BloomFilter *filter, Options const *opts, Stats *stats );
+
+#endif
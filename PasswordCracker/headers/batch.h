@@ -0,0 +1,75 @@
+/**
+ * @file batch.h
+ * @author Luke Early
+ * Header file for batch.c
+ */
+
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include <stdbool.h>
+#include "magic.h"
+#include "password.h"
+
+/** Number of candidate passwords carried by one pipeline batch. */
+#define BATCH_WORDS 64
+
+/** A group of candidate passwords handed to a hashing worker. */
+typedef struct {
+  // Candidate passwords in this batch, each zero-padded to its slot.
+  Password *words;
+
+  // Length of each candidate.
+  byte *lens;
+
+  // Position of each candidate among all of the candidates.
+  long long *index;
+
+  // Number of candidates in the batch, and room for how many.
+  int count;
+  int cap;
+} Batch;
+
+/**
+ * Function type for a test of whether a candidate should stay in a
+ * batch.  It's given the candidate's zero-padded slot and length.
+ */
+typedef bool (*KeepFunction)( void *ctx, Password const word, int len );
+
+/**
+ * Dynamically allocates an empty batch.
+ * 
+ * @param cap number of candidates the batch can hold
+ * @return pointer to the newly created batch
+ */
+Batch *makeBatch( int cap );
+
+/**
+ * Frees the memory previously allocated to the given batch.
+ * 
+ * @param batch batch to free
+ */
+void freeBatch( Batch *batch );
+
+/**
+ * Adds a candidate to the end of a batch that has room for it.
+ * 
+ * @param batch batch to add to
+ * @param word whole zero-padded slot holding the candidate
+ * @param len length of the candidate
+ * @param index position of the candidate among all of the candidates
+ */
+void addCandidate( Batch *batch, Password const word, int len, long long index );
+
+/**
+ * Removes the candidates a test rejects from a batch, keeping the
+ * order of the rest.
+ * 
+ * @param batch batch to filter
+ * @param keep test deciding whether each candidate stays
+ * @param ctx whatever the test needs
+ * @return number of candidates removed
+ */
+int filterBatch( Batch *batch, KeepFunction keep, void *ctx );
+
+#endif
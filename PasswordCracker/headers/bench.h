@@ -0,0 +1,28 @@
+/**
+ * @file bench.h
+ * @author Luke Early
+ * Header file for bench.c
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/** Salt the benchmark passwords are hashed with. */
+#define BENCH_SALT "benchslt"
+
+/**
+ * Times every MD5 backend in this build on the same md5crypt
+ * workload, on one thread, and prints each one's hashes per second.
+ * The backends must all produce the same digests; the backend in use
+ * before is chosen again afterwards.
+ * 
+ * @param count number of passwords each backend hashes
+ * @param fp stream to print the results to
+ * @return false if the backends' digests differ
+ */
+bool benchMd5Backends( int count, FILE *fp );
+
+#endif
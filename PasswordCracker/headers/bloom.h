@@ -0,0 +1,86 @@
+/**
+ * @file bloom.h
+ * @author Luke Early
+ * Header file for bloom.c
+ */
+
+#ifndef _BLOOM_H_
+#define _BLOOM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "batch.h"
+
+/** Bytes in a block of the filter, one cache line. */
+#define BLOOM_BLOCK_BYTES 64
+
+/** Number of bits set in a block for each candidate. */
+#define BLOOM_PROBES 7
+
+/** A block of the filter, aligned to a cache line. */
+typedef struct {
+  uint64_t bits[ BLOOM_BLOCK_BYTES / sizeof( uint64_t ) ];
+} BloomBlock;
+
+/**
+ * A blocked Bloom filter remembering the candidates already tried.
+ * Each candidate's bits all fall in a single cache-line block, so a
+ * check costs one cache miss.  Checks may run from any thread.
+ */
+typedef struct {
+  // The blocks of bits.
+  BloomBlock *blocks;
+
+  // Number of blocks.
+  long long blockCount;
+} BloomFilter;
+
+/**
+ * Hashes a run of bytes down to 64 well-mixed bits.
+ * 
+ * @param data bytes to hash
+ * @param len number of bytes
+ * @return the hash
+ */
+uint64_t hashBytes( void const *data, size_t len );
+
+/**
+ * Dynamically allocates an empty filter using about the given amount
+ * of memory.
+ * 
+ * @param bytes memory budget for the filter, at least one block
+ * @return pointer to the newly created filter
+ */
+BloomFilter *makeBloomFilter( size_t bytes );
+
+/**
+ * Frees the memory previously allocated to the given filter.
+ * 
+ * @param bf filter to free
+ */
+void freeBloomFilter( BloomFilter *bf );
+
+/**
+ * Adds a candidate to the filter, reporting whether it was there
+ * already.  Now and then, a candidate never added before is reported
+ * as seen; how often depends on how full the filter is.
+ * 
+ * @param bf filter to check and add to
+ * @param str the candidate
+ * @param len length of the candidate
+ * @return true if the candidate was seen before
+ */
+bool bloomTestAndSet( BloomFilter *bf, char const *str, int len );
+
+/**
+ * Removes the candidates already seen from a batch, keeping the
+ * order of the rest, and remembers the ones kept.
+ * 
+ * @param bf filter of candidates seen so far
+ * @param batch batch to filter
+ * @return number of candidates removed
+ */
+int dropRepeats( BloomFilter *bf, Batch *batch );
+
+#endif
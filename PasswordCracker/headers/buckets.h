@@ -0,0 +1,61 @@
+/**
+ * @file buckets.h
+ * @author Luke Early
+ * Header file for buckets.c
+ */
+
+#ifndef _BUCKETS_H_
+#define _BUCKETS_H_
+
+#include "pool.h"
+
+/** Number of possible word lengths, from 0 up to PW_LIMIT. */
+#define LENGTH_COUNT ( PW_LIMIT + 1 )
+
+/** A word list grouped by word length. */
+typedef struct {
+  // The words themselves.
+  WordPool const *words;
+
+  // Word indices, shortest words first and in list order within a length.
+  long long *byLen;
+
+  // Where the words of each length start in byLen, plus the end.
+  long long bucketStart[ LENGTH_COUNT + 1 ];
+} LengthBuckets;
+
+/**
+ * Groups the words of a list by length with a counting sort.
+ * 
+ * @param lb buckets to fill in
+ * @param words words to group, which must outlive the buckets
+ */
+void bucketWords( LengthBuckets *lb, WordPool const *words );
+
+/**
+ * Frees the memory held by the given buckets.
+ * 
+ * @param lb buckets to free
+ */
+void freeBuckets( LengthBuckets *lb );
+
+/**
+ * Returns the number of words of the given length.
+ * 
+ * @param lb grouped words
+ * @param len word length
+ * @return number of words that long
+ */
+long long bucketSize( LengthBuckets const *lb, int len );
+
+/**
+ * Returns the i-th word of the given length.
+ * 
+ * @param lb grouped words
+ * @param len word length
+ * @param i index of the word among those of its length
+ * @return the word's slot
+ */
+char const *bucketWord( LengthBuckets const *lb, int len, long long i );
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * @file bulkhash.h
+ * @author Luke Early
+ * Header file for bulkhash.c
+ */
+
+#ifndef _BULKHASH_H_
+#define _BULKHASH_H_
+
+#include <stdio.h>
+#include "stats.h"
+
+/** Number of lines read, hashed and written together. */
+#define HASH_ROUND 4096
+
+/** Number of lines a worker takes at a time. */
+#define HASH_TILE 64
+
+/** Size of the output buffer, in bytes. */
+#define HASH_OUTPUT_BUFFER ( 1 << 16 )
+
+/**
+ * Hashes every line of the input and writes a "$1$salt$hash" line
+ * for each, in input order.  Each line is a word to hash with the
+ * given salt or, without one, a word and a salt separated by a
+ * space.  Lines are taken in rounds, each hashed by all the workers
+ * at once.  The output is fully buffered, so nothing may have been
+ * written to it yet.  If a line is invalid, exit unsuccessfully.
+ * 
+ * @param in stream of words
+ * @param out stream the hashes are written to
+ * @param salt salt to hash every word with, or NULL if each line has one
+ * @param threads number of hashing workers
+ * @param stats counters for the run
+ */
+void hashStream( FILE *in, FILE *out, char const *salt, int threads, Stats *stats );
+
+#endif
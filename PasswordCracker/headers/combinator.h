@@ -0,0 +1,26 @@
+/**
+ * @file combinator.h
+ * @author Luke Early
+ * Header file for combinator.c
+ */
+
+#ifndef _COMBINATOR_H_
+#define _COMBINATOR_H_
+
+#include "keyspace.h"
+#include "pool.h"
+
+/**
+ * Makes a keyspace of every word of the left list followed by every
+ * word of the right list, leaving out the pairs too long for a
+ * password.  Both lists are grouped by word length, and the keyspace
+ * only covers the pairs of lengths that fit, so the rest are never
+ * visited.
+ * 
+ * @param left words that come first, which must outlive the keyspace
+ * @param right words that come second, which must outlive the keyspace
+ * @return pointer to the newly created keyspace
+ */
+Keyspace *makeCombinatorKeyspace( WordPool const *left, WordPool const *right );
+
+#endif
@@ -0,0 +1,47 @@
+/**
+ * @file daemon.h
+ * @author Luke Early
+ * Header file for daemon.c
+ */
+
+#ifndef _DAEMON_H_
+#define _DAEMON_H_
+
+#include "options.h"
+
+/** Connections that may wait to be accepted by the daemon. */
+#define DAEMON_BACKLOG 16
+
+/**
+ * Loads the dictionary once and serves cracking jobs on a UNIX
+ * socket until told to shut down.  A warm pool of workers takes
+ * tiles of dictionary words from whichever queued job has the
+ * highest priority, oldest first among equals.  Each job keeps the
+ * dictionary it started with, so a reload never disturbs jobs
+ * already running.
+ * 
+ * Clients send one command per line:
+ *   JOB PRI        followed by shadow lines and a line holding "."
+ *   FILE PRI PATH  crack the shadow file at PATH
+ *   CANCEL ID      stop a queued or running job
+ *   RELOAD         read the dictionary file again
+ *   SHUTDOWN       cancel every job and stop the daemon
+ * A job is answered with "QUEUED ID", a "name : password" line for
+ * every password found, then "DONE ID" or "CANCELLED ID".  Problems
+ * are answered with a line starting "ERROR".  A job whose client
+ * hangs up before it is done is cancelled.
+ * 
+ * @param opts options naming the socket and dictionary
+ */
+void runDaemon( Options const *opts );
+
+/**
+ * Connects to the daemon at the socket named in the options, sends
+ * it all of standard input and copies what it sends back to
+ * standard output.
+ * 
+ * @param opts options naming the socket
+ */
+void connectDaemon( Options const *opts );
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * @file dictionary.h
+ * @author Luke Early
+ * Header file for dictionary.c
+ */
+
+#ifndef _DICTIONARY_H_
+#define _DICTIONARY_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "pool.h"
+
+/** Dictionary file name that selects standard input. */
+#define STDIN_DICT_NAME "-"
+
+/** Default maximum number of words we can have in the dictionary. */
+#define DLIST_LIMIT 1000
+
+/** Outcome of loading a dictionary. */
+typedef enum {
+  DICT_OK,
+  DICT_INVALID_WORD,
+  DICT_TOO_MANY
+} DictStatus;
+
+/**
+ * Opens the named dictionary file for reading.  The name "-"
+ * selects standard input, so a generator can be piped straight
+ * into the program.
+ * 
+ * @param name dictionary file name, or "-" for standard input
+ * @return open stream, or NULL if the file could not be opened
+ */
+FILE *openDictionary( char const *name );
+
+/**
+ * Reads in a single line of input from dictionary file stream.
+ * 
+ * Stores it in str param.  At the end of the dictionary, str is
+ * set to the empty string.
+ * 
+ * @param fp pointer to input stream
+ * @param str string to store it in
+ * @return false if the line is not a valid dictionary word
+ */
+bool readDictWord( FILE *fp, char *str );
+
+/**
+ * Reads in a single line of input from dictionary file stream.
+ * 
+ * Stores it in str param.  At the end of the dictionary, str is
+ * set to the empty string.
+ * 
+ * @param fp pointer to input stream
+ * @param str string to store it in
+ */
+void readDictLine( FILE *fp, char *str );
+
+/**
+ * Loads every word of the dictionary into the given pool, stopping
+ * at the first problem.
+ * 
+ * @param fp pointer to input stream
+ * @param pool pool to add the words to
+ * @param limit maximum number of words, 0 for no limit
+ * @return DICT_OK, or what was wrong with the dictionary
+ */
+DictStatus loadDictionary( FILE *fp, WordPool *pool, long long limit );
+
+/**
+ * Reads every word of the dictionary into the given pool.  If there
+ * are more than limit words, exit unsuccessfully.
+ * 
+ * @param fp pointer to input stream
+ * @param pool pool to add the words to
+ * @param limit maximum number of words, 0 for no limit
+ */
+void readDictionary( FILE *fp, WordPool *pool, long long limit );
+
+/**
+ * Describes a problem reported by loadDictionary().
+ * 
+ * @param status status to describe
+ * @return message for the user
+ */
+char const *dictStatusMessage( DictStatus status );
+
+#endif
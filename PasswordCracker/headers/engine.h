@@ -0,0 +1,59 @@
+/**
+ * @file engine.h
+ * @author Luke Early
+ * Header file for engine.c
+ */
+
+#ifndef _ENGINE_H_
+#define _ENGINE_H_
+
+#include <stdbool.h>
+#include "keyspace.h"
+#include "bloom.h"
+#include "policy.h"
+#include "targets.h"
+#include "results.h"
+#include "options.h"
+#include "stats.h"
+
+/** Default number of words in a tile: 256 16-byte slots fill 4KB of L1. */
+#define DEFAULT_TILE_WORDS 256
+
+/** Default number of salt groups in a tile. */
+#define DEFAULT_TILE_SALTS 16
+
+/**
+ * Cracks the given targets with every candidate of a keyspace.
+ * 
+ * The candidates x salt groups work is cut into tiles of
+ * opts->tileWords candidates by opts->tileSalts salt groups, which
+ * the workers take in turn.  Within a tile, the prepared candidates
+ * and salts stay in cache while every pair of them is hashed.
+ * 
+ * With opts->tierCount tiers, the keyspace is run in pieces of the
+ * given sizes, plus one for whatever is left.  Each tier finishes
+ * against every salt group before the next starts, each target is
+ * reported once, and fully cracked groups are dropped between tiers.
+ * 
+ * Given only some of the targets, salt groups without any are skipped
+ * and hits on the rest aren't reported.
+ * 
+ * Candidates that break the policy are dropped first.  With a
+ * filter, candidates seen before are dropped next.
+ * Each tile then spans every salt group, so that every candidate
+ * goes through the filter just once.
+ * 
+ * @param ks candidate passwords
+ * @param store targets to crack
+ * @param only which targets to crack, or NULL for all of them
+ * @param results where matches are reported
+ * @param policy policy candidates must meet, or NULL to try them all
+ * @param filter candidates tried so far, or NULL to hash repeats too
+ * @param opts settings for the run
+ * @param stats counters for the run
+ */
+void crackKeyspace( Keyspace const *ks, TargetStore const *store, bool const *only,
+                    Results *results, Policy const *policy, BloomFilter *filter,
+                    Options const *opts, Stats *stats );
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * @file fileutil.h
+ * @author Luke Early
+ * Header file for fileutil.c
+ */
+
+#ifndef _FILEUTIL_H_
+#define _FILEUTIL_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/** Suffix for the file a new version is written to before it is renamed. */
+#define TEMP_SUFFIX ".tmp"
+
+/**
+ * Writes the contents of a file to an open stream.
+ * 
+ * @param fp stream to write to
+ * @param ctx what to write
+ * @return true if everything was written
+ */
+typedef bool (*FileWriter)( FILE *fp, void const *ctx );
+
+/**
+ * Replaces the named file with what the writer produces.  The new
+ * contents go to the name plus TEMP_SUFFIX, which is renamed over
+ * the old file only once it is complete, so a failed or interrupted
+ * write leaves the old file as it was.
+ * 
+ * @param name name of the file to replace
+ * @param write function writing the new contents
+ * @param ctx passed to write
+ * @return true if the file was replaced
+ */
+bool replaceFile( char const *name, FileWriter write, void const *ctx );
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file groups.h
+ * @author Luke Early
+ * Header file for groups.c
+ */
+
+#ifndef _GROUPS_H_
+#define _GROUPS_H_
+
+#include <stdbool.h>
+#include "password.h"
+#include "targets.h"
+#include "rawmd5.h"
+#include "shacrypt.h"
+
+/** A salt group made ready for cracking in whatever format it uses. */
+typedef struct {
+  // How the group's targets were hashed, a HashFormat.
+  int format;
+
+  // Prepared salt, for md5crypt groups.
+  PreparedSalt crypt;
+
+  // Prepared salt, for raw MD5 groups.
+  RawSalt raw;
+
+  // Prepared setting, for SHA-crypt groups.
+  ShaSalt sha;
+} PreparedGroup;
+
+/**
+ * Prepares every salt group of a store for cracking.
+ * 
+ * @param store targets, finished
+ * @return array of prepared groups, one for each salt group
+ */
+PreparedGroup *prepareGroups( TargetStore const *store );
+
+/**
+ * Copies an array of prepared groups, with everything they point to.
+ * Memory is first touched by the calling thread.
+ * 
+ * @param groups the prepared groups
+ * @param count number of groups
+ * @return the copy, to be freed with freeGroups()
+ */
+PreparedGroup *copyGroups( PreparedGroup const *groups, int count );
+
+/**
+ * Frees an array of prepared groups.
+ * 
+ * @param groups the prepared groups
+ * @param count number of groups
+ */
+void freeGroups( PreparedGroup *groups, int count );
+
+/**
+ * Hashes a password the way a salt group's targets were hashed.
+ * 
+ * @param pg prepared group
+ * @param pw prepared password
+ * @param hash where the hash is stored
+ * @return false if the hash was given up early because no target
+ *         of the group can match
+ */
+bool hashGroup( PreparedGroup const *pg, PreparedWord const *pw, byte hash[ HASH_SIZE ] );
+
+/**
+ * Hashes a run of passwords together the way a salt group's targets
+ * were hashed, if the group's format is faster that way.  SHA-crypt
+ * groups hash passwords of the same length SHA_LANES at a time.
+ * 
+ * @param pg prepared group
+ * @param words prepared passwords
+ * @param count number of passwords
+ * @param hashes where the hash of each password is stored
+ * @return false if the group's format hashes one password at a time,
+ *         in which case nothing was hashed
+ */
+bool hashGroupBatch( PreparedGroup const *pg, PreparedWord const *words, int count,
+                     byte hashes[][ HASH_SIZE ] );
+
+#endif
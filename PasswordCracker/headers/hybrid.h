@@ -0,0 +1,28 @@
+/**
+ * @file hybrid.h
+ * @author Luke Early
+ * Header file for hybrid.c
+ */
+
+#ifndef _HYBRID_H_
+#define _HYBRID_H_
+
+#include <stdbool.h>
+#include "keyspace.h"
+#include "pool.h"
+
+/**
+ * Makes a keyspace of every dictionary word joined with every string
+ * of a mask, such as "batman" with "?d?d?d?d" giving "batman0000" up
+ * to "batman9999".  Position i is word i / M with mask string i % M,
+ * where M is the size of the mask's keyspace.  Words too long to take
+ * the mask are skipped.
+ * 
+ * @param dict dictionary words, which must outlive the keyspace
+ * @param maskStr mask string
+ * @param prefix put the mask before the word instead of after it
+ * @return pointer to the newly created keyspace, or NULL if the mask is invalid
+ */
+Keyspace *makeHybridKeyspace( WordPool const *dict, char const *maskStr, bool prefix );
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * @file keyspace.h
+ * @author Luke Early
+ * Header file for keyspace.c
+ */
+
+#ifndef _KEYSPACE_H_
+#define _KEYSPACE_H_
+
+#include "batch.h"
+#include "pool.h"
+
+/** Type name for keyspace struct */
+typedef struct KeyspaceStruct Keyspace;
+
+/**
+ * Function type that adds the candidates at positions start up to,
+ * but not including, end to a batch with room for end - start more.
+ * Positions that don't make a usable candidate are skipped.
+ */
+typedef void (*FillFunction)( Keyspace const *ks, long long start, long long end, Batch *out );
+
+/** Function type that frees a keyspace's state. */
+typedef void (*CleanupFunction)( void *state );
+
+/**
+ * A source of candidate passwords in which every candidate has a
+ * position, from 0 up to size - 1.  Any range of positions can be
+ * produced on its own, so the work can be split among threads
+ * without them having to agree on anything but the positions.
+ */
+struct KeyspaceStruct {
+  // Number of positions in the keyspace.
+  long long size;
+
+  // Produces the candidates for a range of positions.
+  FillFunction fill;
+
+  // Frees state, or NULL if there's nothing to free.
+  CleanupFunction cleanup;
+
+  // Whatever fill needs to produce candidates.
+  void *state;
+};
+
+/**
+ * Makes a keyspace holding the words of a dictionary, in order.
+ * 
+ * @param dict dictionary words, which must outlive the keyspace
+ * @return pointer to the newly created keyspace
+ */
+Keyspace *makeDictKeyspace( WordPool const *dict );
+
+/**
+ * Makes a keyspace holding some of the words of a dictionary.  Each
+ * keeps its position in the dictionary, so results come out in the
+ * same order as with the whole dictionary.
+ * 
+ * @param dict dictionary words, which must outlive the keyspace
+ * @param picks dictionary positions of the words, in increasing
+ *              order, which must outlive the keyspace
+ * @param count number of words picked
+ * @return pointer to the newly created keyspace
+ */
+Keyspace *makeSubsetKeyspace( WordPool const *dict, long long const *picks, long long count );
+
+/**
+ * Frees the memory previously allocated to the given keyspace.
+ * 
+ * @param ks keyspace to free
+ */
+void freeKeyspace( Keyspace *ks );
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ * @file markov.h
+ * @author Luke Early
+ * Header file for markov.c
+ */
+
+#ifndef _MARKOV_H_
+#define _MARKOV_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "keyspace.h"
+#include "pool.h"
+
+/** First character the statistics cover, a space. */
+#define MARKOV_FIRST_CHAR ' '
+
+/** Number of characters the statistics cover, space through tilde. */
+#define MARKOV_CHARS 95
+
+/** Number of contexts for a character: the start of the word, or any covered character. */
+#define MARKOV_CONTEXTS ( MARKOV_CHARS + 1 )
+
+/** Default number of most likely characters tried at each position. */
+#define DEFAULT_MARKOV_THRESHOLD 8
+
+/** Default length of the longest candidate generated. */
+#define DEFAULT_MARKOV_LENGTH 6
+
+/**
+ * How often each character follows each other character, at each
+ * position of a word.  counts[ p ][ 0 ][ c ] counts words starting
+ * with c, and counts[ p ][ 1 + b ][ c ] counts c at position p right
+ * after b, with characters numbered from MARKOV_FIRST_CHAR.
+ */
+typedef struct {
+  uint32_t counts[ PW_LIMIT ][ MARKOV_CONTEXTS ][ MARKOV_CHARS ];
+} MarkovStats;
+
+/**
+ * Adds the transitions of every word in a dictionary to the
+ * statistics.  Words with characters the statistics don't cover are
+ * left out.
+ * 
+ * @param stats statistics to add to, which should start out zeroed
+ * @param words words to learn from
+ */
+void trainMarkov( MarkovStats *stats, WordPool const *words );
+
+/**
+ * Writes statistics to a file, replacing it only once the whole file
+ * is written.
+ * 
+ * @param name name of the file
+ * @param stats statistics to write
+ * @return true if the whole file was written
+ */
+bool saveMarkovStats( char const *name, MarkovStats const *stats );
+
+/**
+ * Reads statistics written by saveMarkovStats().
+ * 
+ * @param name name of the file
+ * @param stats statistics to fill in
+ * @return true if the file held valid statistics
+ */
+bool loadMarkovStats( char const *name, MarkovStats *stats );
+
+/**
+ * Makes a keyspace of the likely strings of lengths 1 up to maxLen.
+ * At each position, only the threshold characters most likely to
+ * follow the previous one are tried.  Every candidate has a rank at
+ * each position, and candidates come in order of their total rank,
+ * so the likeliest strings of every length come first.
+ * 
+ * @param stats statistics to generate from
+ * @param threshold number of characters tried at each position
+ * @param maxLen length of the longest candidates
+ * @return pointer to the newly created keyspace, or NULL if it
+ *         would have too many positions to number
+ */
+Keyspace *makeMarkovKeyspace( MarkovStats const *stats, int threshold, int maxLen );
+
+#endif
@@ -0,0 +1,64 @@
+/**
+ * @file mask.h
+ * @author Luke Early
+ * Header file for mask.c
+ */
+
+#ifndef _MASK_H_
+#define _MASK_H_
+
+#include <stdbool.h>
+#include "password.h"
+
+/**
+ * A mask describes a run of characters, position by position.  In
+ * the mask string, ?l stands for a lowercase letter, ?u an uppercase
+ * letter, ?d a digit, ?s a symbol or space, ?a any of those, and ??
+ * a question mark.  Any other character stands for itself.
+ */
+typedef struct {
+  // Number of positions in the mask.
+  int len;
+
+  // Characters allowed at each position, and how many there are.
+  char const *sets[ PW_LIMIT ];
+  int sizes[ PW_LIMIT ];
+
+  // Storage for the sets of positions holding a single literal character.
+  char literals[ PW_LIMIT ][ 2 ];
+
+  // Number of strings the mask describes.
+  long long size;
+} Mask;
+
+/**
+ * Parses a mask string.
+ * 
+ * @param str mask string
+ * @param mask mask to fill in
+ * @return true if str is a valid mask no longer than PW_LIMIT
+ */
+bool parseMask( char const *str, Mask *mask );
+
+/**
+ * Writes the string at the given position of the mask's keyspace,
+ * and the digits that identify it, for use with nextMask().
+ * 
+ * @param mask mask to expand
+ * @param pos position, from 0 to mask->size - 1
+ * @param digits index into each position's set of characters
+ * @param out where the mask->len characters are written
+ */
+void seekMask( Mask const *mask, long long pos, int digits[ PW_LIMIT ], char *out );
+
+/**
+ * Steps to the next string of the mask's keyspace, like an odometer,
+ * rewriting only the characters that change.
+ * 
+ * @param mask mask to expand
+ * @param digits digits of the current string, updated
+ * @param out the current string, updated
+ */
+void nextMask( Mask const *mask, int digits[ PW_LIMIT ], char *out );
+
+#endif
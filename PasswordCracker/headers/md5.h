@@ -7,6 +7,7 @@
 #ifndef _MD5_H_
 #define _MD5_H_
 
+#include <stdbool.h>
 #include "block.h"
 
 /** Number of bytes in a MD5 hash */
@@ -66,6 +67,15 @@
 /** value to pad block data with */
 #define BLOCK_DATA_PADDING 0x00
 
+/** Name of the in-tree MD5 backend */
+#define MD5_BACKEND_INTREE "intree"
+
+/** Name of the MD5 backend served by OpenSSL's libcrypto, built with OPENSSL=1 */
+#define MD5_BACKEND_OPENSSL "openssl"
+
+/** Function type for an MD5 backend's compression of one block. */
+typedef void (*Md5Transform)( word state[ 4 ], byte const data[ BLOCK_SIZE ] );
+
 /** Function type for the f functions in the md5 algorithm. */
 typedef word (*FFunction)( word, word, word );
 
@@ -216,8 +226,8 @@ void md5Iteration( word M[ BLOCK_WORDS ], word *A, word *B, word *C, word *D, in
 void padBlock( Block *block );
 
 /**
- * Pads given input block, computes the MD5 hash with helper functions, 
- * stores the results in a given hash array.
+ * Pads given input block, computes the MD5 hash with the chosen
+ * backend, stores the results in a given hash array.
  * 
  * @param block block of data
  * @param hash list of hashes
@@ -225,9 +235,28 @@ void padBlock( Block *block );
 void md5Hash( Block *block, byte hash[ HASH_SIZE ] );
 
 /**
- * Pads given input block, computes the MD5 hash with helper functions, 
- * stores the results in a given hash array.
+ * Chooses the backend md5Hash() compresses blocks with.  This must
+ * be done before any hashing threads start.
+ * 
+ * @param name MD5_BACKEND_INTREE or MD5_BACKEND_OPENSSL
+ * @return false if there is no backend of that name in this build
  */
-void md5Hash( Block *block, byte hash[ HASH_SIZE ] );
+bool setMd5Backend( char const *name );
+
+/**
+ * Returns the name of the backend md5Hash() is using.
+ * 
+ * @return name of the backend
+ */
+char const *md5BackendName( void );
+
+/**
+ * Returns the name of one of the backends in this build, for listing
+ * them all.
+ * 
+ * @param i index of the backend
+ * @return the backend's name, or NULL if there are fewer than i + 1
+ */
+char const *md5BackendAt( int i );
 
 #endif
@@ -0,0 +1,80 @@
+/**
+ * @file numa.h
+ * @author Luke Early
+ * Header file for numa.c
+ */
+
+#ifndef _NUMA_H_
+#define _NUMA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "workers.h"
+
+/** Most NUMA nodes that are used. */
+#define MAX_NODES 64
+
+/** The NUMA nodes of the host, and the CPUs of each. */
+typedef struct {
+  // Number of nodes, and the kernel's number for each.
+  int count;
+  int ids[ MAX_NODES ];
+
+  // CPUs of each node.
+  int *cpus[ MAX_NODES ];
+  int cpuCount[ MAX_NODES ];
+
+  // Node of each CPU, as an index into ids, or -1 for CPUs of none.
+  int cpuNode[ MAX_AFFINITY ];
+} NumaTopology;
+
+/**
+ * Reads the host's NUMA nodes from /sys/devices/system/node and makes
+ * them the ones workers are placed on.  A host without NUMA has one
+ * node.
+ * 
+ * @return false if the nodes could not be read
+ */
+bool enableNuma( void );
+
+/**
+ * Returns the NUMA nodes workers are placed on.
+ * 
+ * @return the nodes, or NULL if NUMA placement is off
+ */
+NumaTopology const *numaTopology( void );
+
+/**
+ * Fills in worker limits that pin the workers to the CPUs of every
+ * node in turn, so worker i runs on node i modulo the node count as
+ * long as there are CPUs of that node left.
+ * 
+ * @param limits limits to fill in the CPUs of
+ */
+void numaWorkerLimits( WorkerLimits *limits );
+
+/**
+ * Returns the node the calling thread is running on.
+ * 
+ * @return index of the node in the topology, 0 if NUMA placement is off
+ */
+int currentNode( void );
+
+/**
+ * Limits the calling thread to the CPUs of one node, so memory it
+ * touches first is allocated there.
+ * 
+ * @param node index of the node in the topology
+ */
+void bindToNode( int node );
+
+/**
+ * Spreads the pages of a block of memory evenly over the nodes, for
+ * large data every worker reads.  Pages already in place are moved.
+ * 
+ * @param addr start of the block
+ * @param len size of the block in bytes
+ */
+void interleaveMemory( void *addr, size_t len );
+
+#endif
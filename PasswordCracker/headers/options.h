@@ -0,0 +1,164 @@
+/**
+ * @file options.h
+ * @author Luke Early
+ * Header file for options.c
+ */
+
+#ifndef _OPTIONS_H_
+#define _OPTIONS_H_
+
+#include <stdbool.h>
+
+/** Largest number of tier sizes that can be given. */
+#define MAX_TIERS 16
+
+/** Largest number of shadow files that can be named on the command line. */
+#define MAX_SHADOWS 64
+
+/**
+ * Settings for one run of the program, collected from the
+ * command line.
+ */
+typedef struct {
+  /** Name of the dictionary file, "-" for standard input. */
+  char const *dictName;
+
+  /** Chain dictionary words together PRINCE-style. */
+  bool prince;
+
+  /** Largest number of words in a PRINCE chain. */
+  int princeElems;
+
+  /** Name of the word list joined after each dictionary word, or NULL. */
+  char const *combineName;
+
+  /** Name of a Markov statistics file to generate candidates from, or NULL. */
+  char const *markovName;
+
+  /** Name of a Markov statistics file to train from the dictionary, or NULL. */
+  char const *markovTrain;
+
+  /** Number of most likely characters tried at each position of a Markov candidate. */
+  int markovThreshold;
+
+  /** Length of the longest Markov candidate. */
+  int markovLength;
+
+  /** Name of a file of words to hash instead of cracking, "-" for standard input, or NULL. */
+  char const *hashName;
+
+  /** Salt to hash every word with, or NULL if each line names its own. */
+  char const *hashSalt;
+
+  /** Name of a salt index file to build from the dictionary, or NULL. */
+  char const *buildIndex;
+
+  /** Salt the index is built for. */
+  char const *indexSalt;
+
+  /** Name of a salt index file to answer targets with its salt from, or NULL. */
+  char const *indexName;
+
+  /** Names of the shadow files, cracked together in one pass. */
+  char const *shadowNames[ MAX_SHADOWS ];
+  int shadowCount;
+
+  /** Name of a file listing more shadow files, one per line, or NULL. */
+  char const *manifestName;
+
+  /** Stream the dictionary through the reader/worker pipeline. */
+  bool pipeline;
+
+  /** Number of hashing worker threads, 0 for one per online CPU. */
+  int threads;
+
+  /** Mask added to the end of each dictionary word, or NULL. */
+  char const *hybridSuffix;
+
+  /** Mask added to the start of each dictionary word, or NULL. */
+  char const *hybridPrefix;
+
+  /** Number of words in a tile of the words x salt groups work. */
+  int tileWords;
+
+  /** Number of salt groups in a tile of the words x salt groups work. */
+  int tileSalts;
+
+  /** Sizes of the tiers the keyspace is run in, before the rest of it. */
+  long long tiers[ MAX_TIERS ];
+  int tierCount;
+
+  /** Password policy candidates must meet, or NULL to try them all. */
+  char const *policy;
+
+  /** Memory for the filter dropping repeated candidates, in MiB; 0 for no filter. */
+  int dedupeMB;
+
+  /** Name of the audit state file for incremental re-audits, or NULL. */
+  char const *stateName;
+
+  /** Socket to serve cracking jobs on, keeping the dictionary loaded, or NULL. */
+  char const *daemonName;
+
+  /** Socket of a running daemon to pass standard input to, or NULL. */
+  char const *connectName;
+
+  /** Print statistics about the run to standard error at the end. */
+  bool stats;
+
+  /** Maximum number of dictionary words to load, 0 for no limit. */
+  long long maxWords;
+
+  /** Name of a shared-memory dictionary to attach to or publish, or NULL. */
+  char const *shmName;
+
+  /** Leave the shared dictionary in place after the last process detaches. */
+  bool shmKeep;
+
+  /** Name of the MD5 backend to hash with, or NULL for the default. */
+  char const *md5Backend;
+
+  /** Number of md5crypt hashes to time each MD5 backend on instead of cracking, or 0. */
+  int benchCount;
+
+  /** Take the settings left at their defaults from this host's tuning. */
+  bool autotune;
+
+  /** Name of the tuning cache file, or NULL for one in the home directory. */
+  char const *tuneName;
+
+  /** Print an estimate of the run's work, time and memory instead of cracking. */
+  bool plan;
+
+  /** Percent of the time each worker may spend hashing. */
+  int maxCpu;
+
+  /** List of CPUs to pin the workers to, such as "0-3,8", or NULL. */
+  char const *affinity;
+
+  /** Niceness to run the workers at. */
+  int nice;
+
+  /** Place the workers, and the data they read, on every NUMA node in turn. */
+  bool numa;
+
+  /** File to write a Chrome trace of the run's stages to, or NULL. */
+  char const *traceName;
+} Options;
+
+/**
+ * Parses the command line into the given options.  Options start
+ * with "--" and may appear anywhere before the file names.  With
+ * --combine or --markov, the candidates don't come from a dictionary
+ * and only the shadow file names are left; with --markov-train, only
+ * the dictionary file name is, as with --build-index and --daemon; with --connect, no
+ * file names are given, as with --hash and --benchmark.  Any unknown option or missing file
+ * name prints a usage message and exits unsuccessfully.
+ * 
+ * @param argc number of command-line arguments
+ * @param argv command-line arguments
+ * @param opts options to fill in
+ */
+void parseOptions( int argc, char *argv[], Options *opts );
+
+#endif
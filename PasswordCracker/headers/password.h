@@ -7,13 +7,22 @@
 #ifndef _PASSWORD_H_
 #define _PASSWORD_H_
 
+#include <stdbool.h>
+#include "md5.h"
+
 /** Required length of the salt string. */
 #define SALT_LENGTH 8
 
+/** Characters a salt may be made of. */
+#define SALT_CHARS "./0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+
 /** Maximum length of a password.  Just to simplify our program; passwords
     aren't really required to be this short. */
 #define PW_LIMIT 15
 
+/** Type for representing a word in the dictionary. */
+typedef char Password[ PW_LIMIT + 1 ];
+
 /** Maximum length of a password hash string created by hashPassword() */
 #define PW_HASH_LIMIT 22
 
@@ -64,6 +73,35 @@
 /** Saves all bits, clears two most significant */
 #define MASK_FOR_BITS 0x3F
 
+/** Length of the "$1$" string mixed into the first intermediate hash */
+#define MD5_MAGIC_LENGTH 3
+
+/** Number of characters in each full set of encoded letters */
+#define LETTERS_IN_SET 4
+
+/** Number of letters that encode the final, lone byte */
+#define LETTERS_IN_LAST_SET 2
+
+/** A salt string with its length worked out ahead of time. */
+typedef struct {
+  char str[ SALT_LENGTH + 1 ];
+  int len;
+} PreparedSalt;
+
+/** A password with its length worked out ahead of time. */
+typedef struct {
+  char const *str;
+  int len;
+} PreparedWord;
+
+/**
+ * Converts a 16-byte hash to a string of printable characters from a given set.
+ * 
+ * @param hash 16-byte hash to translate
+ * @param result translation of 16-byte hash
+ */
+void hashToString( byte hash[ HASH_SIZE ], char result[ PW_HASH_LIMIT + 1 ] );
+
 /**
  * Generates a 16-byte hash given a password and salt string.
  * 
@@ -73,4 +111,52 @@
  */
 void hashPassword( char const pass[], char const salt[ SALT_LENGTH + 1 ], char result[ PW_HASH_LIMIT + 1 ] );
 
+/**
+ * Generates the 16-byte hash for a password and salt string, without
+ * converting it to printable characters.
+ * 
+ * @param pass password to hash
+ * @param salt salt string used to hash the given password
+ * @param hash 16-byte hash generated from MD5 hash algo
+ */
+void hashPasswordRaw( char const pass[], char const salt[ SALT_LENGTH + 1 ], byte hash[ HASH_SIZE ] );
+
+/**
+ * Checks that a string can be used as a salt: no longer than
+ * SALT_LENGTH, and made only of SALT_CHARS.
+ * 
+ * @param salt string to check
+ * @return true if it is a valid salt
+ */
+bool isValidSalt( char const *salt );
+
+/**
+ * Fills in a prepared salt, working out its length once.
+ * 
+ * @param ps prepared salt to fill in
+ * @param salt salt string
+ */
+void prepareSalt( PreparedSalt *ps, char const salt[ SALT_LENGTH + 1 ] );
+
+/**
+ * Generates the 16-byte hash for a prepared password and salt.  This
+ * is the inner loop of cracking, so it works on blocks on the stack
+ * and never has to measure the password or salt.
+ * 
+ * @param pw prepared password
+ * @param ps prepared salt
+ * @param hash 16-byte hash generated from MD5 hash algo
+ */
+void hashPrepared( PreparedWord const *pw, PreparedSalt const *ps, byte hash[ HASH_SIZE ] );
+
+/**
+ * Converts a password hash string, as made by hashPassword(), back
+ * into the 16-byte hash it encodes.
+ * 
+ * @param str password hash string
+ * @param hash where the 16-byte hash is stored
+ * @return true if str is a valid hash string
+ */
+bool stringToHash( char const str[], byte hash[ HASH_SIZE ] );
+
 #endif
@@ -0,0 +1,39 @@
+/**
+ * @file pipeline.h
+ * @author Luke Early
+ * Header file for pipeline.c
+ */
+
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+#include <stdio.h>
+#include "targets.h"
+#include "results.h"
+#include "stats.h"
+#include "bloom.h"
+#include "policy.h"
+
+/** Number of batches circulating between the reader and the workers. */
+#define PIPELINE_DEPTH 64
+
+/**
+ * Cracks the given targets by streaming the dictionary through a
+ * reader thread and a set of hashing workers.  The reader fills
+ * fixed-size batches and hands them to the workers through a
+ * bounded ring, so reading overlaps hashing and memory use does
+ * not grow with the size of the dictionary.  Matches are added to
+ * results as soon as they are found.
+ * 
+ * @param fp dictionary stream
+ * @param store targets to crack
+ * @param results where matches are reported
+ * @param threads number of hashing workers
+ * @param policy policy words must meet, or NULL to try them all
+ * @param filter words hashed so far, or NULL to hash repeats too
+ * @param stats counters for the run
+ */
+void crackPipelined( FILE *fp, TargetStore const *store, Results *results, int threads,
+                     Policy const *policy, BloomFilter *filter, Stats *stats );
+
+#endif
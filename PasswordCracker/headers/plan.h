@@ -0,0 +1,52 @@
+/**
+ * @file plan.h
+ * @author Luke Early
+ * Header file for plan.c
+ */
+
+#ifndef _PLAN_H_
+#define _PLAN_H_
+
+#include <stdio.h>
+#include "options.h"
+#include "keyspace.h"
+#include "targets.h"
+#include "pool.h"
+
+/** How long each hash format is timed for, in milliseconds. */
+#define PLAN_TRIAL_MS 200
+
+/** Number of passwords hashed between looks at the clock. */
+#define PLAN_TRIAL_WORDS 16
+
+/** Length of the longest duration formatDuration() writes. */
+#define DURATION_LIMIT 31
+
+/**
+ * Writes a duration the way a person would read it, such as
+ * "3d 04h 05m" or "12.5s".
+ * 
+ * @param secs duration in seconds
+ * @param buf where the text is stored
+ */
+void formatDuration( double secs, char buf[ DURATION_LIMIT + 1 ] );
+
+/**
+ * Prints what a cracking run would take instead of running it: the
+ * salt groups and candidates, the hashes that makes, how long they
+ * would take with different numbers of workers and how much memory
+ * the run needs.  The speed of each hash format is measured on one of
+ * its groups, except that md5crypt's is taken from this host's
+ * tuning under --autotune.
+ * 
+ * @param ks candidates the run would try
+ * @param store targets
+ * @param dict dictionary words, or NULL
+ * @param right second word list of a combinator run, or NULL
+ * @param opts options for the run
+ * @param fp stream to print the plan to
+ */
+void printPlan( Keyspace const *ks, TargetStore const *store, WordPool const *dict,
+                WordPool const *right, Options const *opts, FILE *fp );
+
+#endif
@@ -0,0 +1,82 @@
+/**
+ * @file policy.h
+ * @author Luke Early
+ * Header file for policy.c
+ */
+
+#ifndef _POLICY_H_
+#define _POLICY_H_
+
+#include <stdbool.h>
+#include "batch.h"
+#include "password.h"
+
+/** Class flag for lowercase letters; the other flags follow it in order. */
+#define CLASS_LOWER 0x1
+
+/** Class flag for uppercase letters. */
+#define CLASS_UPPER 0x2
+
+/** Class flag for digits. */
+#define CLASS_DIGIT 0x4
+
+/** Class flag for everything else. */
+#define CLASS_SYMBOL 0x8
+
+/** Largest number of forbidden characters a policy can list. */
+#define FORBID_LIMIT 16
+
+/**
+ * The rules a target system puts on passwords.  A candidate that
+ * breaks them can't be anyone's password there.
+ */
+typedef struct {
+  // Shortest and longest allowed lengths.
+  int minLen;
+  int maxLen;
+
+  // Classes every password must use, as CLASS_ flags.
+  int required;
+
+  // Number of different classes every password must use.
+  int minClasses;
+
+  // Characters no password may hold.
+  char forbid[ FORBID_LIMIT ];
+  int forbidCount;
+} Policy;
+
+/**
+ * Parses a policy given as a comma-separated list of rules:
+ * min=N and max=N for the allowed lengths; lower, upper, digit and
+ * symbol for classes that must be used; classes=N for how many
+ * different classes must be used; and forbid=CHARS for characters
+ * that may not be used.
+ * 
+ * @param str policy string
+ * @param policy policy to fill in
+ * @return true if str is a valid policy
+ */
+bool parsePolicy( char const *str, Policy *policy );
+
+/**
+ * Reports whether a candidate meets a policy.
+ * 
+ * @param policy policy to check against
+ * @param word the candidate's whole zero-padded slot
+ * @param len length of the candidate
+ * @return true if the candidate meets the policy
+ */
+bool meetsPolicy( Policy const *policy, Password const word, int len );
+
+/**
+ * Removes the candidates that break a policy from a batch, keeping
+ * the order of the rest.
+ * 
+ * @param policy policy to check against
+ * @param batch batch to filter
+ * @return number of candidates removed
+ */
+int dropViolations( Policy const *policy, Batch *batch );
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * @file pool.h
+ * @author Luke Early
+ * Header file for pool.c
+ */
+
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "magic.h"
+#include "password.h"
+
+/**
+ * Compact store for a list of words.  Every word sits in its own
+ * fixed-size, NUL-padded slot of one contiguous array, so word i is
+ * at slots[ i ] and walking the list is a linear scan of memory.  The
+ * lens array holds the length of each word alongside, so they never
+ * need to be recomputed.  A pool takes exactly
+ * sizeof( Password ) + 1 bytes per word, plus spare capacity.
+ */
+typedef struct {
+  // Fixed-size slot for each word.
+  Password *slots;
+
+  // Length of each word.
+  byte *lens;
+
+  // Number of words in the pool.
+  long long count;
+
+  // Number of words there is room for.
+  long long cap;
+
+  // False if the slots belong to someone else, such as a shared segment.
+  bool ownsSlots;
+} WordPool;
+
+/**
+ * Dynamically allocates an empty pool.
+ * 
+ * @return pointer to the newly created pool
+ */
+WordPool *makeWordPool();
+
+/**
+ * Makes a pool that reads words from slots stored elsewhere.  The
+ * slots are not copied and are not freed with the pool.
+ * 
+ * @param slots existing array of word slots
+ * @param count number of words in slots
+ * @return pointer to the newly created pool
+ */
+WordPool *viewWordPool( Password const *slots, long long count );
+
+/**
+ * Frees the memory previously allocated to the given pool.
+ * 
+ * @param pool pool to free
+ */
+void freeWordPool( WordPool *pool );
+
+/**
+ * Adds a copy of the given word to the end of the pool.
+ * 
+ * @param pool pool to add to
+ * @param word word to add, no longer than PW_LIMIT
+ */
+void appendWord( WordPool *pool, char const *word );
+
+/**
+ * Returns the number of bytes of memory the pool's words occupy.
+ * 
+ * @param pool pool to measure
+ * @return bytes used by slots and lengths
+ */
+size_t wordPoolBytes( WordPool const *pool );
+
+#endif
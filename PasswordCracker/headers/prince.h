@@ -0,0 +1,31 @@
+/**
+ * @file prince.h
+ * @author Luke Early
+ * Header file for prince.c
+ */
+
+#ifndef _PRINCE_H_
+#define _PRINCE_H_
+
+#include "keyspace.h"
+#include "pool.h"
+
+/** Default largest number of words chained into one candidate. */
+#define DEFAULT_PRINCE_ELEMS 3
+
+/**
+ * Makes a PRINCE keyspace: every chain of 1 up to maxElems dictionary
+ * words, possibly repeating, that fits in a password.  Chains are
+ * grouped by the lengths of their words, such as 4+3+1, and each such
+ * group covers every combination of words with those lengths.  Groups
+ * with fewer words come first, and among those the smaller groups,
+ * so quick chains finish before the large ones begin.
+ * 
+ * @param dict dictionary words, which must outlive the keyspace
+ * @param maxElems largest number of words in a chain
+ * @return pointer to the newly created keyspace, or NULL if it
+ *         would have too many positions to number
+ */
+Keyspace *makePrinceKeyspace( WordPool const *dict, int maxElems );
+
+#endif
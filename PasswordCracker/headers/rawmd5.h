@@ -0,0 +1,75 @@
+/**
+ * @file rawmd5.h
+ * @author Luke Early
+ * Header file for rawmd5.c
+ */
+
+#ifndef _RAWMD5_H_
+#define _RAWMD5_H_
+
+#include <stdbool.h>
+#include "password.h"
+#include "targets.h"
+
+/** Number of MD5 steps run before a candidate is checked against its targets. */
+#define RAW_CHECK_STEPS 60
+
+/**
+ * A raw MD5 salt group made ready for cracking: the salt's part of
+ * the message block, the state after the steps that only use the
+ * salt, and what the targets' digests say the state must be after
+ * RAW_CHECK_STEPS steps.
+ */
+typedef struct {
+  // Message words holding the salt, zero after it.
+  word block[ BLOCK_WORDS ];
+  int saltLen;
+
+  // Number of steps that only read salt words, and the state after them.
+  int midSteps;
+  word mid[ 4 ];
+
+  // Sorted values of b after RAW_CHECK_STEPS steps, one for each valid target.
+  word *checks;
+  int checkCount;
+} RawSalt;
+
+/**
+ * Prepares a raw MD5 salt group for cracking.
+ * 
+ * @param rs raw salt to fill in
+ * @param store targets
+ * @param group salt group of the store to prepare
+ */
+void prepareRawSalt( RawSalt *rs, TargetStore const *store, int group );
+
+/**
+ * Frees the memory held by a prepared raw salt.
+ * 
+ * @param rs raw salt to free
+ */
+void freeRawSalt( RawSalt *rs );
+
+/**
+ * Hashes a password with a prepared raw MD5 salt.  The hash stops
+ * after RAW_CHECK_STEPS steps unless the state could still lead to
+ * one of the group's digests, so most candidates cost less than a
+ * full MD5.
+ * 
+ * @param rs prepared raw salt
+ * @param pw prepared password
+ * @param hash where md5( salt . password ) is stored, if it is finished
+ * @return false if no target of the group can match
+ */
+bool rawHash( RawSalt const *rs, PreparedWord const *pw, byte hash[ HASH_SIZE ] );
+
+/**
+ * Hashes salt and password with the plain MD5 code, the slow way.
+ * 
+ * @param salt salt string
+ * @param pass password
+ * @param hash where md5( salt . password ) is stored
+ */
+void rawHashSlow( char const *salt, char const *pass, byte hash[ HASH_SIZE ] );
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * @file results.h
+ * @author Luke Early
+ * Header file for results.c
+ */
+
+#ifndef _RESULTS_H_
+#define _RESULTS_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "password.h"
+#include "targets.h"
+
+/** A password found for one of the targets. */
+typedef struct {
+  // Index of the cracked target.
+  int target;
+
+  // Position of the password among the candidates.
+  long long word;
+
+  // The password itself.
+  Password pass;
+} Hit;
+
+/**
+ * Passwords found so far.  Hits may be added from any thread.  They
+ * are either printed the moment they are added, or kept and printed
+ * together at the end in target order.
+ */
+typedef struct {
+  // Store the targets came from.
+  TargetStore const *store;
+
+  // Print hits as they are added instead of keeping them.
+  bool stream;
+
+  // Where hits are printed, standard output unless changed.
+  FILE *out;
+
+  // Hits kept for printing later.
+  Hit *hits;
+  int count;
+  int cap;
+
+  // Guards the hits array and the output stream.
+  pthread_mutex_t lock;
+} Results;
+
+/**
+ * Dynamically allocates an empty set of results.
+ * 
+ * @param store store the targets come from
+ * @param stream print each hit as soon as it is added
+ * @return pointer to the newly created results
+ */
+Results *makeResults( TargetStore const *store, bool stream );
+
+/**
+ * Frees the memory previously allocated to the given results.
+ * 
+ * @param results results to free
+ */
+void freeResults( Results *results );
+
+/**
+ * Records that the given password matches the given target.
+ * 
+ * @param results results to add to
+ * @param target index of the cracked target
+ * @param word position of the password among the candidates
+ * @param pass the password
+ */
+void addHit( Results *results, int target, long long word, char const *pass );
+
+/**
+ * Prints every kept hit, ordered by target and then by candidate
+ * position, as "user : password" lines.
+ * 
+ * @param results results to print
+ */
+void printResults( Results *results );
+
+#endif
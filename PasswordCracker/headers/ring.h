@@ -0,0 +1,80 @@
+/**
+ * @file ring.h
+ * @author Luke Early
+ * Header file for ring.c
+ */
+
+#ifndef _RING_H_
+#define _RING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Size of a cache line, used to keep the two ring indices apart. */
+#define CACHE_LINE_SIZE 64
+
+/** One slot of the ring, tagged with the sequence number of its turn. */
+typedef struct {
+  // Sequence number telling producers and consumers whose turn it is.
+  size_t seq;
+
+  // Item stored in the slot.
+  void *item;
+} RingCell;
+
+/**
+ * Bounded, lock-free queue of pointers that any number of threads
+ * may push to and pop from at the same time.
+ */
+typedef struct {
+  // Array of capacity cells.
+  RingCell *cells;
+
+  // Capacity minus one; the capacity is a power of two.
+  size_t mask;
+
+  // Position of the next push, on its own cache line.
+  char padHead[ CACHE_LINE_SIZE ];
+  size_t head;
+
+  // Position of the next pop, on its own cache line.
+  char padTail[ CACHE_LINE_SIZE ];
+  size_t tail;
+  char padEnd[ CACHE_LINE_SIZE ];
+} Ring;
+
+/**
+ * Dynamically allocates an empty ring able to hold at least
+ * capacity items.
+ * 
+ * @param capacity minimum number of items the ring can hold
+ * @return pointer to the newly created ring
+ */
+Ring *makeRing( size_t capacity );
+
+/**
+ * Frees the memory previously allocated to the given ring.
+ * 
+ * @param ring ring to free
+ */
+void freeRing( Ring *ring );
+
+/**
+ * Adds an item to the ring without blocking.
+ * 
+ * @param ring ring to add to
+ * @param item item to add
+ * @return true if the item was added, false if the ring is full
+ */
+bool ringPush( Ring *ring, void *item );
+
+/**
+ * Removes the oldest item from the ring without blocking.
+ * 
+ * @param ring ring to remove from
+ * @param item where the removed item is stored
+ * @return true if an item was removed, false if the ring is empty
+ */
+bool ringPop( Ring *ring, void **item );
+
+#endif
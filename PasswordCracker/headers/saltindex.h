@@ -0,0 +1,114 @@
+/**
+ * @file saltindex.h
+ * @author Luke Early
+ * Header file for saltindex.c
+ */
+
+#ifndef _SALTINDEX_H_
+#define _SALTINDEX_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "password.h"
+#include "pool.h"
+#include "targets.h"
+#include "results.h"
+#include "policy.h"
+
+/** Start of an index file. */
+typedef struct {
+  // Identifies the file as a salt index, "SIX2" read as bytes.
+  uint32_t magic;
+
+  // Salt every digest was made with, NUL padded.
+  char salt[ SALT_LENGTH + 3 ];
+
+  // Number of words, and so of digests.
+  uint64_t wordCount;
+
+  // Fingerprint of the dictionary the words came from.
+  uint64_t dictPrint;
+} SaltIndexHeader;
+
+/** One digest of the index, with the word that hashes to it. */
+typedef struct {
+  // Hash of the word with the index's salt.
+  byte digest[ HASH_SIZE ];
+
+  // Position of the word in the dictionary.
+  uint32_t word;
+} SaltIndexEntry;
+
+/**
+ * An index file mapped into this process.  Its entries are sorted
+ * by digest.  The words themselves aren't kept, since the index can
+ * only be used with the dictionary it was built from.
+ */
+typedef struct {
+  // Start of the mapping.
+  SaltIndexHeader const *hdr;
+
+  // Digests, sorted.
+  SaltIndexEntry const *entries;
+
+  // Size of the mapping in bytes.
+  size_t mapLen;
+} SaltIndex;
+
+/**
+ * Returns a fingerprint of the words of a dictionary, so an index
+ * can only be used with the dictionary it was built from.
+ * 
+ * @param dict dictionary words
+ * @return the dictionary's fingerprint
+ */
+uint64_t dictPrint( WordPool const *dict );
+
+/**
+ * Hashes every dictionary word with the given salt and writes the
+ * sorted digests, with the position of each one's word, to the named
+ * file.
+ * 
+ * @param name index file name
+ * @param salt salt to hash with
+ * @param dict dictionary words
+ * @param threads number of hashing workers
+ * @return true if the file was written
+ */
+bool buildSaltIndex( char const *name, char const *salt, WordPool const *dict, int threads );
+
+/**
+ * Maps the named index file into memory.
+ * 
+ * @param name index file name
+ * @return the index, or NULL if the file is missing or not a valid index
+ */
+SaltIndex *openSaltIndex( char const *name );
+
+/**
+ * Unmaps an index and frees its memory.
+ * 
+ * @param index index to close
+ */
+void closeSaltIndex( SaltIndex *index );
+
+/**
+ * Answers every wanted target that uses the index's salt by looking
+ * its digest up, instead of hashing the dictionary again.  Targets
+ * answered are cleared in wanted, so the rest of the run can skip
+ * them.
+ * 
+ * @param index the index
+ * @param dict dictionary words, the ones the index was built from
+ * @param store targets
+ * @param wanted which targets are still to be cracked
+ * @param results where matches are reported
+ * @param policy policy words must meet, or NULL to allow them all
+ * @param firstOnly report only the first matching word of a target
+ * @return number of targets answered
+ */
+int lookupSaltIndex( SaltIndex const *index, WordPool const *dict, TargetStore const *store,
+                     bool *wanted, Results *results, Policy const *policy, bool firstOnly );
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @file sha2.h
+ * @author Luke Early
+ * Header file for sha2.c
+ */
+
+#ifndef _SHA2_H_
+#define _SHA2_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "magic.h"
+
+/** Number of bytes in a SHA-256 hash */
+#define SHA256_DIGEST 32
+
+/** Number of bytes in a SHA-256 block */
+#define SHA256_BLOCK 64
+
+/** Number of bytes in a SHA-512 hash */
+#define SHA512_DIGEST 64
+
+/** Number of bytes in a SHA-512 block */
+#define SHA512_BLOCK 128
+
+/** Number of messages hashed side by side by the multi-buffer functions */
+#define SHA_LANES 4
+
+/** Room for each padded message given to the multi-buffer functions */
+#define SHA_LANE_BYTES 128
+
+/** State of a SHA-256 hash being computed. */
+typedef struct {
+  // Chaining values.
+  word h[ 8 ];
+
+  // Bytes waiting for a full block, and how many there are.
+  byte buf[ SHA256_BLOCK ];
+  int len;
+
+  // Number of bytes hashed so far.
+  uint64_t total;
+} Sha256;
+
+/** State of a SHA-512 hash being computed. */
+typedef struct {
+  // Chaining values.
+  uint64_t h[ 8 ];
+
+  // Bytes waiting for a full block, and how many there are.
+  byte buf[ SHA512_BLOCK ];
+  int len;
+
+  // Number of bytes hashed so far.
+  uint64_t total;
+} Sha512;
+
+/**
+ * Starts a SHA-256 hash.
+ * 
+ * @param ctx hash state to start
+ */
+void sha256Init( Sha256 *ctx );
+
+/**
+ * Adds bytes to a SHA-256 hash.
+ * 
+ * @param ctx hash state
+ * @param src bytes to add
+ * @param n number of bytes
+ */
+void sha256Update( Sha256 *ctx, void const *src, size_t n );
+
+/**
+ * Pads and finishes a SHA-256 hash.
+ * 
+ * @param ctx hash state
+ * @param digest where the SHA256_DIGEST byte hash is stored
+ */
+void sha256Final( Sha256 *ctx, byte digest[ SHA256_DIGEST ] );
+
+/**
+ * Starts a SHA-512 hash.
+ * 
+ * @param ctx hash state to start
+ */
+void sha512Init( Sha512 *ctx );
+
+/**
+ * Adds bytes to a SHA-512 hash.
+ * 
+ * @param ctx hash state
+ * @param src bytes to add
+ * @param n number of bytes
+ */
+void sha512Update( Sha512 *ctx, void const *src, size_t n );
+
+/**
+ * Pads and finishes a SHA-512 hash.
+ * 
+ * @param ctx hash state
+ * @param digest where the SHA512_DIGEST byte hash is stored
+ */
+void sha512Final( Sha512 *ctx, byte digest[ SHA512_DIGEST ] );
+
+/**
+ * Hashes SHA_LANES messages at once, one in each lane of a vector.
+ * The messages must already be padded and all take the same number
+ * of blocks.
+ * 
+ * @param msgs padded messages
+ * @param blocks number of SHA256_BLOCK byte blocks in each message
+ * @param digests where the hashes are stored, in the first
+ *                SHA256_DIGEST bytes of each row
+ */
+void sha256Lanes( byte msgs[ SHA_LANES ][ SHA_LANE_BYTES ], int blocks,
+                  byte digests[ SHA_LANES ][ SHA512_DIGEST ] );
+
+/**
+ * Hashes SHA_LANES messages at once, one in each lane of a vector.
+ * The messages must already be padded and all take the same number
+ * of blocks.
+ * 
+ * @param msgs padded messages
+ * @param blocks number of SHA512_BLOCK byte blocks in each message
+ * @param digests where the hashes are stored
+ */
+void sha512Lanes( byte msgs[ SHA_LANES ][ SHA_LANE_BYTES ], int blocks,
+                  byte digests[ SHA_LANES ][ SHA512_DIGEST ] );
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * @file shacrypt.h
+ * @author Luke Early
+ * Header file for shacrypt.c
+ */
+
+#ifndef _SHACRYPT_H_
+#define _SHACRYPT_H_
+
+#include <stdbool.h>
+#include "sha2.h"
+
+/** Longest salt SHA-crypt uses */
+#define SHA_SALT_MAX 16
+
+/** Rounds used when the setting doesn't give any */
+#define SHA_ROUNDS_DEFAULT 5000
+
+/** Fewest rounds allowed; fewer are raised to this */
+#define SHA_ROUNDS_MIN 1000
+
+/** Most rounds allowed; more are lowered to this */
+#define SHA_ROUNDS_MAX 999999999
+
+/** Longest printable hash, for SHA-512 */
+#define SHA_HASH_LIMIT 86
+
+/** Longest password SHA-crypt messages are sized for */
+#define SHA_PASS_MAX 15
+
+/** A SHA-crypt setting, "[rounds=N$]salt", worked out once. */
+typedef struct {
+  // Bytes in the hash, SHA256_DIGEST or SHA512_DIGEST.
+  int digestLen;
+
+  // Number of rounds.
+  long rounds;
+
+  // Salt, at most SHA_SALT_MAX characters.
+  char salt[ SHA_SALT_MAX + 1 ];
+  int saltLen;
+} ShaSalt;
+
+/**
+ * Parses a SHA-crypt setting, the part of a hash between the "$5$"
+ * or "$6$" and the final '$'.
+ * 
+ * @param ss where the setting is stored
+ * @param digestLen SHA256_DIGEST for "$5$" or SHA512_DIGEST for "$6$"
+ * @param setting "salt" or "rounds=N$salt"
+ * @return true if the setting is valid
+ */
+bool parseShaSetting( ShaSalt *ss, int digestLen, char const *setting );
+
+/**
+ * Converts a printable SHA-crypt hash back into the digest it encodes.
+ * 
+ * @param digestLen SHA256_DIGEST or SHA512_DIGEST
+ * @param str printable hash
+ * @param digest where the digest is stored
+ * @return true if str is a valid hash of that length
+ */
+bool shaStringToHash( int digestLen, char const *str, byte digest[ SHA512_DIGEST ] );
+
+/**
+ * Converts a SHA-crypt digest to its printable form.
+ * 
+ * @param digestLen SHA256_DIGEST or SHA512_DIGEST
+ * @param digest the digest
+ * @param result printable hash
+ */
+void shaHashToString( int digestLen, byte const digest[ SHA512_DIGEST ], char result[ SHA_HASH_LIMIT + 1 ] );
+
+/**
+ * Computes the SHA-crypt digest of one password, the plain way.
+ * 
+ * @param ss prepared setting
+ * @param pass password
+ * @param len length of the password, at most SHA_PASS_MAX
+ * @param digest where the digest is stored
+ */
+void shaCrypt( ShaSalt const *ss, char const *pass, int len, byte digest[ SHA512_DIGEST ] );
+
+/**
+ * Computes the SHA-crypt digests of SHA_LANES passwords of the same
+ * length at once.  Every round hashes a message of the same length
+ * for each of them, so the rounds run on all the lanes together.
+ * 
+ * @param ss prepared setting
+ * @param pass passwords, which may repeat
+ * @param len length of every password, at most SHA_PASS_MAX
+ * @param digests where the digests are stored
+ */
+void shaCryptLanes( ShaSalt const *ss, char const *pass[ SHA_LANES ], int len,
+                    byte digests[ SHA_LANES ][ SHA512_DIGEST ] );
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * @file shadow.h
+ * @author Luke Early
+ * Header file for shadow.c
+ */
+
+#ifndef _SHADOW_H_
+#define _SHADOW_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "targets.h"
+
+/** Maximum username length */
+#define USERNAME_LIMIT 32
+
+/** Shadow files to be cracked together in one pass. */
+typedef struct {
+  // Name of each file.
+  char **names;
+
+  // Number of files, and room for how many.
+  int count;
+  int cap;
+} ShadowSet;
+
+/**
+ * Parses a single line of input from shadow file.
+ * 
+ * Adds the user it describes to the given target store, unless the
+ * entry is invalid.  If a source is given, the user is named
+ * "source:name" so it can be told apart from users of other files.
+ * 
+ * @param store store to add the user to
+ * @param fp pointer to input stream
+ * @param source name of the file the entry came from, or NULL
+ * @return true if the entry was valid
+ */
+bool parseUser( TargetStore *store, FILE *fp, char const *source );
+
+/**
+ * Reads in a single line of input from shadow file.
+ * 
+ * Adds the user it describes to the given target store.
+ * 
+ * @param store store to add the user to
+ * @param fp pointer to input stream
+ */
+void readUserFromFile( TargetStore *store, FILE *fp );
+
+/**
+ * Parses every entry of the shadow file into a new target store,
+ * grouped by salt.
+ * 
+ * @param fp pointer to input stream
+ * @return store holding the users, or NULL if an entry was invalid
+ */
+TargetStore *parseShadowFile( FILE *fp );
+
+/**
+ * Reads every entry of the shadow file into a new target store,
+ * grouped by salt.
+ * 
+ * @param fp pointer to input stream
+ * @return store holding the users
+ */
+TargetStore *readShadowFile( FILE *fp );
+
+/**
+ * Collects the shadow files to crack together: the named ones, then
+ * those listed in the manifest, one per line.  If any of them can't
+ * be opened, exit unsuccessfully.
+ * 
+ * @param names shadow file names
+ * @param count number of names
+ * @param manifest name of a file listing more shadow files, or NULL
+ * @return the set of shadow files
+ */
+ShadowSet *openShadowFiles( char const *const *names, int count, char const *manifest );
+
+/**
+ * Reads every entry of every file in the set into one target store,
+ * so users of all the files are grouped by salt together.  When
+ * there is more than one file, each user is named "file:name".
+ * 
+ * @param set the shadow files
+ * @return store holding the users
+ */
+TargetStore *readShadowSet( ShadowSet const *set );
+
+/**
+ * Frees the memory previously allocated to the given set.
+ * 
+ * @param set set to free
+ */
+void freeShadowSet( ShadowSet *set );
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file shmdict.h
+ * @author Luke Early
+ * Header file for shmdict.c
+ */
+
+#ifndef _SHMDICT_H_
+#define _SHMDICT_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "password.h"
+#include "pool.h"
+
+/** Longest shared-memory object name we accept. */
+#define SHM_NAME_LIMIT 255
+
+/** Reference count of a segment that is being removed. */
+#define SHM_DICT_DEAD -1
+
+/**
+ * Header at the start of a shared dictionary segment.  The words
+ * follow on the next page as an array of fixed-size slots, so word
+ * i is found at index i without any further lookup.
+ */
+typedef struct {
+  // Identifies the segment as one of ours, and its layout version.
+  unsigned int magic;
+
+  // Set once the publisher has finished writing the words.
+  int ready;
+
+  // Number of processes currently attached, or SHM_DICT_DEAD once the
+  // last one has detached and is removing the segment.
+  int refs;
+
+  // Number of words in the segment.
+  long long wordCount;
+
+  // Most words the publisher would read from the file.
+  long long maxWords;
+
+  // Identity of the dictionary file the words were read from.
+  unsigned long long fileDev;
+  unsigned long long fileIno;
+  long long fileSize;
+  long long fileMtime;
+} ShmDictHeader;
+
+/** A dictionary segment mapped into this process. */
+typedef struct {
+  // Name of the shared-memory object.
+  char name[ SHM_NAME_LIMIT + 1 ];
+
+  // Start of the mapping.
+  ShmDictHeader *hdr;
+
+  // Words in the segment, read-only.
+  Password const *words;
+
+  // Size of the mapping in bytes.
+  size_t mapLen;
+} SharedDict;
+
+/**
+ * Attaches to the named shared dictionary, if another process has
+ * already published one built from the same file with the same
+ * limit on its words.
+ * 
+ * @param name shared-memory object name
+ * @param fp open dictionary stream, used to identify the file
+ * @param maxWords most words to read from the file
+ * @return the mapped dictionary, or NULL if there isn't a usable one
+ */
+SharedDict *attachSharedDict( char const *name, FILE *fp, long long maxWords );
+
+/**
+ * Publishes the given words under the given name so later processes
+ * can attach to them.  Nothing is published if the name is already
+ * taken.
+ * 
+ * @param name shared-memory object name
+ * @param fp open dictionary stream, used to identify the file
+ * @param pool words read from the dictionary
+ * @param maxWords most words that were read from the file
+ * @return the mapped dictionary, or NULL if it couldn't be published
+ */
+SharedDict *publishSharedDict( char const *name, FILE *fp, WordPool const *pool,
+                               long long maxWords );
+
+/**
+ * Detaches from a shared dictionary.  The last process to detach
+ * removes the segment unless keep is set.
+ * 
+ * @param dict dictionary to detach from
+ * @param keep leave the segment in place for future runs
+ */
+void detachSharedDict( SharedDict *dict, bool keep );
+
+#endif
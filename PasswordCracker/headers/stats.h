@@ -0,0 +1,99 @@
+/**
+ * @file stats.h
+ * @author Luke Early
+ * Header file for stats.c
+ */
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+#include "numa.h"
+
+/**
+ * Counters describing a run, reported with --stats.  Counters that
+ * workers update while hashing are changed with countStat(), so any
+ * thread may add to them.
+ */
+typedef struct {
+  // When the run started.
+  struct timespec start;
+
+  // Number of candidate passwords considered.
+  long long candidates;
+
+  // Number of accounts being cracked, and distinct salts among them.
+  int targets;
+  int saltGroups;
+
+  // Number of hashing worker threads.
+  int threads;
+
+  // Size of a tile of the words x salt groups work, and how many there were.
+  int tileWords;
+  int tileSalts;
+  long long tiles;
+
+  // Whether this is a re-audit, and the words and targets an earlier audit covered.
+  bool audit;
+  long long oldWords;
+  int oldTargets;
+
+  // Whether a password policy was applied, and how many candidates broke it.
+  bool policy;
+  long long violations;
+
+  // Whether repeated candidates were dropped, and how many were.
+  bool dedupe;
+  long long repeats;
+
+  // Number of tiers run, and salt groups fully cracked by the end of one.
+  int tiers;
+  int groupsDone;
+
+  // Targets answered from a salt index instead of by hashing.
+  int indexed;
+
+  // Number of password hashes computed.
+  long long hashes;
+
+  // NUMA nodes the workers were placed on, if any, and the hashes computed on each.
+  int nodes;
+  int nodeIds[ MAX_NODES ];
+  long long nodeHashes[ MAX_NODES ];
+} Stats;
+
+/**
+ * Clears all counters and starts the run's clock.
+ * 
+ * @param stats stats to initialize
+ */
+void initStats( Stats *stats );
+
+/**
+ * Adds to one of the counters; safe to call from any thread.
+ * 
+ * @param counter counter to add to
+ * @param n amount to add
+ */
+void countStat( long long *counter, long long n );
+
+/**
+ * Returns the number of seconds since the run started.
+ * 
+ * @param stats stats for the run
+ * @return elapsed wall-clock time in seconds
+ */
+double elapsedSeconds( Stats const *stats );
+
+/**
+ * Prints a report of the counters.
+ * 
+ * @param stats stats to report
+ * @param fp stream to print to
+ */
+void printStats( Stats const *stats, FILE *fp );
+
+#endif
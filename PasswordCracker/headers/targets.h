@@ -0,0 +1,212 @@
+/**
+ * @file targets.h
+ * @author Luke Early
+ * Header file for targets.c
+ */
+
+#ifndef _TARGETS_H_
+#define _TARGETS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "magic.h"
+#include "md5.h"
+#include "password.h"
+
+/** Longest salt of any hash format, a SHA-crypt "rounds=N$salt". */
+#define SALT_LIMIT 33
+
+/** Longest raw MD5 salt. */
+#define RAW_SALT_LIMIT 20
+
+/** Number of hex digits in a raw MD5 hash. */
+#define RAW_HEX_LENGTH ( 2 * HASH_SIZE )
+
+/** Type for a salt string in the salt table. */
+typedef char Salt[ SALT_LIMIT + 1 ];
+
+/** How a target's password was hashed. */
+typedef enum {
+  // md5crypt, "$1$salt$hash".
+  FORMAT_MD5CRYPT,
+
+  // md5( salt . password ), "$raw-md5$hex" or "$raw-md5$salt$hex".
+  FORMAT_RAW_MD5,
+
+  // SHA-crypt, "$5$[rounds=N$]salt$hash" and "$6$[rounds=N$]salt$hash".
+  FORMAT_SHA256CRYPT,
+  FORMAT_SHA512CRYPT
+} HashFormat;
+
+/**
+ * Store for the accounts we are trying to crack, kept as parallel
+ * arrays rather than one record per account.  Target i has the
+ * binary hash digests[ i ], uses the salt salts[ saltIds[ i ] ] and
+ * is named names + nameOffsets[ i ].  Each distinct salt appears
+ * once in the salt table for each hash format it is used with, and
+ * saltFormats[ g ] tells how the targets using salt g were hashed.
+ * 
+ * Once finishTargets() has been called, the targets can also be
+ * walked one salt group at a time: group g holds the targets
+ * order[ groupStart[ g ] ] up to order[ groupStart[ g + 1 ] - 1 ],
+ * all of which use salt g, sorted by digest.  groupDigests[ k ] is
+ * the digest of order[ k ], so each group's digests sit together in
+ * memory and can be searched by bisection.
+ */
+typedef struct {
+  // Number of targets, and room for how many.
+  int count;
+  int cap;
+
+  // 16-byte binary hash of each target.
+  byte (*digests)[ HASH_SIZE ];
+
+  // Index of each target's salt in the salt table.
+  int *saltIds;
+
+  // Offset of each target's username in the names pool.
+  int *nameOffsets;
+
+  // False for targets whose hash string could never be matched.
+  bool *valid;
+
+  // Usernames, each terminated by a NUL, end to end.
+  char *names;
+  int namesLen;
+  int namesCap;
+
+  // Table of distinct salts, in order of first appearance.
+  Salt *salts;
+  byte *saltFormats;
+  int saltCount;
+  int saltCap;
+
+  // Hash table from salt to salt id, -1 for an empty bucket.
+  int *saltIndex;
+  int saltIndexCap;
+
+  // Targets grouped by salt, filled in by finishTargets().
+  int *order;
+  int *groupStart;
+
+  // Digest of each target in order[], sorted within each group.
+  byte (*groupDigests)[ HASH_SIZE ];
+} TargetStore;
+
+/**
+ * Dynamically allocates an empty target store.
+ * 
+ * @return pointer to the newly created store
+ */
+TargetStore *makeTargets();
+
+/**
+ * Frees the memory previously allocated to the given store.
+ * 
+ * @param store store to free
+ */
+void freeTargets( TargetStore *store );
+
+/**
+ * Adds an account to the store.
+ * 
+ * @param store store to add to
+ * @param name username
+ * @param salt salt string
+ * @param hash password hash string, as made by hashPassword()
+ * @return index of the new target
+ */
+int addTarget( TargetStore *store, char const *name, char const *salt, char const *hash );
+
+/**
+ * Adds an account with a raw MD5 hash to the store.
+ * 
+ * @param store store to add to
+ * @param name username
+ * @param salt salt put in front of the password, up to RAW_SALT_LIMIT characters
+ * @param hex hash of the salted password, as 32 hex digits
+ * @return index of the new target
+ */
+int addRawTarget( TargetStore *store, char const *name, char const *salt, char const *hex );
+
+/**
+ * Adds an account with a SHA-crypt hash to the store.  Only the
+ * first HASH_SIZE bytes of the digest are kept and compared.
+ * 
+ * @param store store to add to
+ * @param name username
+ * @param format FORMAT_SHA256CRYPT or FORMAT_SHA512CRYPT
+ * @param setting valid setting, "salt" or "rounds=N$salt"
+ * @param hash printable hash
+ * @return index of the new target
+ */
+int addShaTarget( TargetStore *store, char const *name, int format, char const *setting, char const *hash );
+
+/**
+ * Returns the number of bytes in the digests of a SHA-crypt format.
+ * 
+ * @param format FORMAT_SHA256CRYPT or FORMAT_SHA512CRYPT
+ * @return SHA256_DIGEST or SHA512_DIGEST
+ */
+int shaDigestLength( int format );
+
+/**
+ * Groups the targets by salt and sorts each group by digest.  Call
+ * once after the last target is added; targets with the same digest
+ * keep the order they were added.
+ * 
+ * @param store store to group
+ */
+void finishTargets( TargetStore *store );
+
+/**
+ * Makes a copy of the parts of a finished store that cracking reads
+ * for every hash: the digests, which targets are valid and the
+ * grouping by salt.  The rest is shared with the original, which
+ * must outlive the copy.  Memory is first touched by the calling
+ * thread.
+ * 
+ * @param store targets, finished
+ * @return the copy
+ */
+TargetStore *copyDigestIndex( TargetStore const *store );
+
+/**
+ * Frees a copy made by copyDigestIndex().
+ * 
+ * @param copy the copy
+ */
+void freeDigestIndex( TargetStore *copy );
+
+/**
+ * Looks for targets in a salt group whose hash matches the given one.
+ * Starting from the beginning of the group, the group's sorted
+ * digests are bisected; starting from just after a match, only the
+ * next position can hold another.
+ * 
+ * @param store store holding the targets
+ * @param group salt group to search
+ * @param hash 16-byte hash to look for
+ * @param from start of the group, or the position after the last match
+ * @return position in order[] of the next match, or -1 if there isn't one
+ */
+int findInGroup( TargetStore const *store, int group, byte const hash[ HASH_SIZE ], int from );
+
+/**
+ * Returns the username of the given target.
+ * 
+ * @param store store holding the target
+ * @param target index of the target
+ * @return the target's username
+ */
+char const *targetName( TargetStore const *store, int target );
+
+/**
+ * Returns the number of bytes of memory the store occupies.
+ * 
+ * @param store store to measure
+ * @return bytes used by all of the store's arrays
+ */
+size_t targetBytes( TargetStore const *store );
+
+#endif
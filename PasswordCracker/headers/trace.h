@@ -0,0 +1,49 @@
+/**
+ * @file trace.h
+ * @author Luke Early
+ * Header file for trace.c
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdbool.h>
+
+/** Number of events a thread's trace buffer starts with room for. */
+#define INIT_TRACE_CAP 1024
+
+/** Length of the longest thread name in a trace. */
+#define TRACE_NAME_LIMIT 31
+
+/**
+ * Starts recording spans, to be written to the named file in Chrome
+ * trace_event JSON when the program exits.
+ * 
+ * @param name file the trace is written to
+ */
+void startTrace( char const *name );
+
+/**
+ * Names the calling thread in the trace.
+ * 
+ * @param name name of the thread
+ */
+void traceThreadName( char const *name );
+
+/**
+ * Returns the time a span starts at, for traceEnd().
+ * 
+ * @return the time in nanoseconds, or 0 if nothing is being traced
+ */
+long long traceBegin( void );
+
+/**
+ * Records a span of the calling thread, from the given start to now,
+ * in the thread's own buffer.
+ * 
+ * @param name name of the span, which must outlive the program
+ * @param start what traceBegin() returned at the start of the span
+ */
+void traceEnd( char const *name, long long start );
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file tune.h
+ * @author Luke Early
+ * Header file for tune.c
+ */
+
+#ifndef _TUNE_H_
+#define _TUNE_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "options.h"
+
+/** Length of the longest CPU model name kept in a host key. */
+#define TUNE_MODEL_LIMIT 127
+
+/** Length of the longest MD5 backend name kept in a tuning. */
+#define TUNE_NAME_LIMIT 15
+
+/** Length of the longest line of a tuning cache file. */
+#define TUNE_LINE_LIMIT 255
+
+/** Name of the tuning cache file in the home directory. */
+#define TUNE_FILE_NAME ".crack-tune"
+
+/** How long each configuration is timed for, in milliseconds. */
+#define TUNE_TRIAL_MS 200
+
+/** Identifies the kind of host a tuning is good for. */
+typedef struct {
+  // CPU model, as /proc/cpuinfo names it.
+  char model[ TUNE_MODEL_LIMIT + 1 ];
+
+  // Number of online CPUs.
+  int cpus;
+
+  // Number of physical cores among them.
+  int cores;
+} HostKey;
+
+/** Settings found to run fastest on a host. */
+typedef struct {
+  // Number of workers and MD5 backend.
+  int threads;
+  char backend[ TUNE_NAME_LIMIT + 1 ];
+
+  // md5crypt hashes per second each worker managed with these settings.
+  double rate;
+} Tuning;
+
+/**
+ * Works out the key of the host this is running on.
+ * 
+ * @param key where the key is stored
+ */
+void hostKey( HostKey *key );
+
+/**
+ * Finds the tuning saved for a host in a cache file.
+ * 
+ * @param name cache file name
+ * @param key host to look for
+ * @param tuning where the tuning is stored, if there is one
+ * @return true if the file has a tuning for the host
+ */
+bool loadTuning( char const *name, HostKey const *key, Tuning *tuning );
+
+/**
+ * Saves the tuning for a host in a cache file, replacing any tuning
+ * it already has for that host and keeping those of other hosts.
+ * 
+ * @param name cache file name
+ * @param key host the tuning is for
+ * @param tuning settings to save
+ * @return true if the file was written
+ */
+bool saveTuning( char const *name, HostKey const *key, Tuning const *tuning );
+
+/**
+ * Times short md5crypt trials over the MD5 backends and then the
+ * worker counts, the second stage keeping the winner of the first,
+ * and stores the fastest settings.
+ * 
+ * @param key host being tuned
+ * @param tuning where the fastest settings are stored
+ * @param log stream progress is reported on, or NULL
+ */
+void runTrials( HostKey const *key, Tuning *tuning, FILE *log );
+
+/**
+ * Finds this host's tuning in the cache file the options name.
+ * 
+ * @param opts options naming the cache file
+ * @param tuning where the tuning is stored, if there is one
+ * @return true if the cache has a tuning for this host
+ */
+bool cachedTuning( Options const *opts, Tuning *tuning );
+
+/**
+ * Fills in the settings the command line left at their defaults from
+ * this host's cached tuning, measuring and caching one first if there
+ * isn't any.
+ * 
+ * @param opts options to tune
+ * @param log stream the settings used are reported on, or NULL
+ */
+void autotune( Options *opts, FILE *log );
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * @file workers.h
+ * @author Luke Early
+ * Header file for workers.c
+ */
+
+#ifndef _WORKERS_H_
+#define _WORKERS_H_
+
+#include <stdbool.h>
+
+/** Most CPUs an affinity list can name. */
+#define MAX_AFFINITY 1024
+
+/** Percent of the time a worker with no limit may be busy. */
+#define FULL_CPU 100
+
+/** Highest niceness workers can be given. */
+#define MAX_NICE 19
+
+/** Function type for the body of a worker thread. */
+typedef void (*WorkerFunction)( int id, void *ctx );
+
+/** Limits on how much of the host the workers may take. */
+typedef struct {
+  // Percent of the time each worker may spend hashing, 100 for no limit.
+  int maxCpu;
+
+  // CPUs the workers are pinned to in turn, none to leave them free.
+  int cpus[ MAX_AFFINITY ];
+  int cpuCount;
+
+  // Niceness workers run at, 0 to leave it alone.
+  int nice;
+} WorkerLimits;
+
+/**
+ * Parses a list of CPUs such as "0-3,8,10-11".
+ * 
+ * @param str the list
+ * @param limits where the CPUs are stored
+ * @return false if the list is not valid
+ */
+bool parseCpuList( char const *str, WorkerLimits *limits );
+
+/**
+ * Sets the limits every worker started afterwards runs under.  A
+ * positive niceness also gives the whole process the lowest
+ * best-effort I/O priority, so its reading yields to other services.
+ * 
+ * @param newLimits the limits
+ */
+void setWorkerLimits( WorkerLimits const *newLimits );
+
+/**
+ * Returns the number of CPUs the process's cgroup CPU quota is worth,
+ * rounded up.
+ * 
+ * @return CPUs of quota, or 0 if there is no quota
+ */
+int cpuQuota( void );
+
+/**
+ * Returns the number of worker threads to use.
+ * 
+ * @param requested count asked for on the command line, 0 for the default
+ * @return requested if it is positive, otherwise one per CPU the
+ *         process may run on, as the affinity list, the CPU mask and
+ *         the cgroup quota allow
+ */
+int workerCount( int requested );
+
+/**
+ * Sleeps long enough, if there is a --max-cpu limit, to bring the
+ * calling worker's time hashing since it last called down to the
+ * limit.  Workers call this between tiles or batches of work.
+ */
+void throttleWorker( void );
+
+/**
+ * Runs fn on count threads at once and waits for all of them to
+ * finish.  Each thread is passed its id, from 0 to count - 1, and
+ * the shared ctx pointer.  Each thread is pinned and reniced as the
+ * worker limits say.
+ * 
+ * @param count number of threads
+ * @param fn function run by each thread
+ * @param ctx state shared by every thread
+ */
+void runWorkers( int count, WorkerFunction fn, void *ctx );
+
+#endif
@@ -0,0 +1,438 @@
+/**
+ * @file audit.c
+ * @author Luke Early
+ * Implements incremental re-audits, which remember what an earlier
+ * run already covered so the next one only does the difference.
+ * 
+ * The state says that every word in one set was tried against every
+ * target in another.  Given this week's dictionary and shadow file,
+ * the old words need only be tried against targets that are new or
+ * whose hash changed, while the new words are tried against all of
+ * them.  Afterward, this week's words and targets become the state.
+ */
+
+#include "audit.h"
+#include "fileutil.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+/** Marks a file as holding an audit state, "AUD1" read as bytes. */
+#define AUDIT_MAGIC 0x31445541
+
+/** A dictionary word's fingerprint, and where it is in the dictionary. */
+typedef struct {
+  uint64_t print;
+  long long pos;
+} WordPrint;
+
+/**
+ * Returns the fingerprint of a dictionary word.
+ * 
+ * @param dict dictionary words
+ * @param w position of the word
+ * @return the word's fingerprint
+ */
+static uint64_t wordPrint( WordPool const *dict, long long w )
+{
+  return hashBytes( dict->slots[ w ], dict->lens[ w ] );
+}
+
+/**
+ * Returns the fingerprint of a target, made from its salt and hash,
+ * so a changed password gives a new target.
+ * 
+ * @param store targets
+ * @param k index of the target
+ * @return the target's fingerprint
+ */
+static uint64_t targetPrint( TargetStore const *store, int k )
+{
+  byte buf[ 1 + SALT_LIMIT + 1 + HASH_SIZE ];
+  int g = store->saltIds[ k ];
+  int at = 0;
+  int saltLen = SALT_LENGTH;
+
+  // md5crypt targets keep the layout older state files were written with
+  memset( buf, 0, sizeof( buf ) );
+  if ( store->saltFormats[ g ] != FORMAT_MD5CRYPT ) {
+    buf[ at++ ] = store->saltFormats[ g ];
+    saltLen = SALT_LIMIT;
+  }
+  strncpy( (char *) buf + at, store->salts[ g ], saltLen );
+  memcpy( buf + at + saltLen + 1, store->digests[ k ], HASH_SIZE );
+
+  return hashBytes( buf, at + saltLen + 1 + HASH_SIZE );
+}
+
+/**
+ * Orders fingerprints.
+ * 
+ * @param a first fingerprint
+ * @param b second fingerprint
+ * @return negative, zero, or positive as a comes before, with, or after b
+ */
+static int comparePrints( void const *a, void const *b )
+{
+  uint64_t pa = *(uint64_t const *)a;
+  uint64_t pb = *(uint64_t const *)b;
+
+  return pa < pb ? -1 : pa > pb;
+}
+
+/**
+ * Orders dictionary words by fingerprint, then position.
+ * 
+ * @param a first word
+ * @param b second word
+ * @return negative, zero, or positive as a comes before, with, or after b
+ */
+static int compareWordPrints( void const *a, void const *b )
+{
+  WordPrint const *wa = (WordPrint const *)a;
+  WordPrint const *wb = (WordPrint const *)b;
+
+  if ( wa->print != wb->print ) {
+    return wa->print < wb->print ? -1 : 1;
+  }
+  return wa->pos < wb->pos ? -1 : wa->pos > wb->pos;
+}
+
+/**
+ * Orders hits by target fingerprint, then password.
+ * 
+ * @param a first hit
+ * @param b second hit
+ * @return negative, zero, or positive as a comes before, with, or after b
+ */
+static int compareAuditHits( void const *a, void const *b )
+{
+  AuditHit const *ha = (AuditHit const *)a;
+  AuditHit const *hb = (AuditHit const *)b;
+
+  if ( ha->target != hb->target ) {
+    return ha->target < hb->target ? -1 : 1;
+  }
+  return strcmp( ha->pass, hb->pass );
+}
+
+/**
+ * Sorts fingerprints and removes the duplicates.
+ * 
+ * @param prints fingerprints to sort
+ * @param count number of fingerprints
+ * @return number left
+ */
+static long long sortPrints( uint64_t *prints, long long count )
+{
+  qsort( prints, count, sizeof( uint64_t ), comparePrints );
+
+  long long kept = 0;
+  for ( long long i = 0; i < count; i++ ) {
+    if ( kept == 0 || prints[ kept - 1 ] != prints[ i ] ) {
+      prints[ kept++ ] = prints[ i ];
+    }
+  }
+
+  return kept;
+}
+
+/**
+ * Reports whether a sorted set of fingerprints holds the given one.
+ * 
+ * @param prints sorted fingerprints
+ * @param count number of fingerprints
+ * @param print fingerprint to look for
+ * @return true if it's there
+ */
+static bool hasPrint( uint64_t const *prints, long long count, uint64_t print )
+{
+  // a first run has no state yet, and so no array to search
+  if ( count == 0 ) {
+    return false;
+  }
+  return bsearch( &print, prints, count, sizeof( uint64_t ), comparePrints ) != NULL;
+}
+
+/**
+ * Reads a count and then that many items from a state file, into a
+ * newly allocated array.
+ * 
+ * @param fp state file
+ * @param size size of an item
+ * @param count where to put the count
+ * @return the items, or NULL if the file ended too soon
+ */
+static void *readItems( FILE *fp, size_t size, long long *count )
+{
+  if ( fread( count, sizeof( long long ), 1, fp ) != 1 || *count < 0 ) {
+    return NULL;
+  }
+
+  void *items = malloc( ( *count > 0 ? *count : 1 ) * size );
+  if ( (long long) fread( items, size, *count, fp ) != *count ) {
+    free( items );
+    return NULL;
+  }
+
+  return items;
+}
+
+/**
+ * Reads the state of an earlier audit.  A file that doesn't exist
+ * gives an empty state, as for a first audit.
+ * 
+ * @param name name of the state file
+ * @return pointer to the state, or NULL if the file isn't a valid state
+ */
+AuditState *loadAuditState( char const *name )
+{
+  AuditState *state = (AuditState *)calloc( 1, sizeof( AuditState ) );
+
+  FILE *fp = fopen( name, "rb" );
+  if ( fp == NULL ) {
+    if ( errno == ENOENT ) {
+      return state;
+    }
+    free( state );
+    return NULL;
+  }
+
+  uint32_t magic;
+  bool ok = fread( &magic, sizeof( magic ), 1, fp ) == 1 && magic == AUDIT_MAGIC &&
+            ( state->words = readItems( fp, sizeof( uint64_t ), &state->wordCount ) ) != NULL &&
+            ( state->targets = readItems( fp, sizeof( uint64_t ), &state->targetCount ) ) != NULL &&
+            ( state->hits = readItems( fp, sizeof( AuditHit ), &state->hitCount ) ) != NULL &&
+            fgetc( fp ) == EOF;
+  fclose( fp );
+
+  if ( !ok ) {
+    freeAuditState( state );
+    return NULL;
+  }
+
+  return state;
+}
+
+/**
+ * Writes an audit state to a stream.
+ * 
+ * @param fp stream to write to
+ * @param ctx the AuditState
+ * @return true if all of it was written
+ */
+static bool writeAuditState( FILE *fp, void const *ctx )
+{
+  AuditState const *state = (AuditState const *)ctx;
+  uint32_t magic = AUDIT_MAGIC;
+
+  return fwrite( &magic, sizeof( magic ), 1, fp ) == 1 &&
+         fwrite( &state->wordCount, sizeof( long long ), 1, fp ) == 1 &&
+         (long long) fwrite( state->words, sizeof( uint64_t ), state->wordCount, fp ) == state->wordCount &&
+         fwrite( &state->targetCount, sizeof( long long ), 1, fp ) == 1 &&
+         (long long) fwrite( state->targets, sizeof( uint64_t ), state->targetCount, fp ) == state->targetCount &&
+         fwrite( &state->hitCount, sizeof( long long ), 1, fp ) == 1 &&
+         (long long) fwrite( state->hits, sizeof( AuditHit ), state->hitCount, fp ) == state->hitCount;
+}
+
+/**
+ * Writes an audit state to a file, replacing the old file only once
+ * the new one is complete.
+ * 
+ * @param name name of the state file
+ * @param state state to write
+ * @return true if the state was written
+ */
+bool saveAuditState( char const *name, AuditState const *state )
+{
+  return replaceFile( name, writeAuditState, state );
+}
+
+/**
+ * Makes the state recording that every dictionary word was tried
+ * against every target, with the given results.
+ * 
+ * @param dict dictionary words
+ * @param store targets
+ * @param results every password found for the targets with the words
+ * @return pointer to the newly created state
+ */
+AuditState *makeAuditState( WordPool const *dict, TargetStore const *store, Results const *results )
+{
+  AuditState *state = (AuditState *)malloc( sizeof( AuditState ) );
+
+  state->words = (uint64_t *)malloc( ( dict->count + 1 ) * sizeof( uint64_t ) );
+  for ( long long w = 0; w < dict->count; w++ ) {
+    state->words[ w ] = wordPrint( dict, w );
+  }
+  state->wordCount = sortPrints( state->words, dict->count );
+
+  state->targets = (uint64_t *)malloc( ( store->count + 1 ) * sizeof( uint64_t ) );
+  for ( int k = 0; k < store->count; k++ ) {
+    state->targets[ k ] = targetPrint( store, k );
+  }
+  state->targetCount = sortPrints( state->targets, store->count );
+
+  /**
+   * Keep each password once per target
+   */
+  state->hits = (AuditHit *)malloc( ( results->count + 1 ) * sizeof( AuditHit ) );
+  for ( int i = 0; i < results->count; i++ ) {
+    state->hits[ i ].target = targetPrint( store, results->hits[ i ].target );
+    memset( state->hits[ i ].pass, 0, sizeof( Password ) );
+    strcpy( state->hits[ i ].pass, results->hits[ i ].pass );
+  }
+  qsort( state->hits, results->count, sizeof( AuditHit ), compareAuditHits );
+
+  state->hitCount = 0;
+  for ( int i = 0; i < results->count; i++ ) {
+    if ( state->hitCount == 0 ||
+         compareAuditHits( &state->hits[ state->hitCount - 1 ], &state->hits[ i ] ) != 0 ) {
+      state->hits[ state->hitCount++ ] = state->hits[ i ];
+    }
+  }
+
+  return state;
+}
+
+/**
+ * Frees the memory previously allocated to the given state.
+ * 
+ * @param state state to free
+ */
+void freeAuditState( AuditState *state )
+{
+  free( state->words );
+  free( state->targets );
+  free( state->hits );
+  free( state );
+}
+
+/**
+ * Reports again the passwords an earlier audit found for the old
+ * targets, at every place the password's word is in the dictionary.
+ * Passwords whose word left the dictionary are dropped.
+ * 
+ * @param dict dictionary words
+ * @param store targets
+ * @param old state of the earlier audit
+ * @param fresh which targets are new
+ * @param results where the passwords are reported
+ */
+static void replayHits( WordPool const *dict, TargetStore const *store, AuditState const *old,
+                        bool const *fresh, Results *results )
+{
+  WordPrint *prints = (WordPrint *)malloc( ( dict->count + 1 ) * sizeof( WordPrint ) );
+  for ( long long w = 0; w < dict->count; w++ ) {
+    prints[ w ].print = wordPrint( dict, w );
+    prints[ w ].pos = w;
+  }
+  qsort( prints, dict->count, sizeof( WordPrint ), compareWordPrints );
+
+  for ( int k = 0; k < store->count; k++ ) {
+    if ( fresh[ k ] ) {
+      continue;
+    }
+
+    /**
+     * Find the target's hits, then each of their words
+     */
+    AuditHit key;
+    key.target = targetPrint( store, k );
+    long long lo = 0;
+    long long hi = old->hitCount;
+    while ( lo < hi ) {
+      long long mid = ( lo + hi ) / 2;
+      if ( old->hits[ mid ].target < key.target ) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+
+    for ( long long h = lo; h < old->hitCount && old->hits[ h ].target == key.target; h++ ) {
+      WordPrint want = { hashBytes( old->hits[ h ].pass, strlen( old->hits[ h ].pass ) ), -1 };
+      long long a = 0;
+      long long b = dict->count;
+      while ( a < b ) {
+        long long mid = ( a + b ) / 2;
+        if ( compareWordPrints( &prints[ mid ], &want ) < 0 ) {
+          a = mid + 1;
+        } else {
+          b = mid;
+        }
+      }
+
+      for ( ; a < dict->count && prints[ a ].print == want.print; a++ ) {
+        addHit( results, k, prints[ a ].pos, dict->slots[ prints[ a ].pos ] );
+      }
+    }
+  }
+
+  free( prints );
+}
+
+/**
+ * Cracks the targets with the dictionary, doing only the work an
+ * earlier audit didn't.  New words are tried against every target,
+ * and old words only against new targets.  Passwords the earlier
+ * audit found with words still in the dictionary are reported again,
+ * so the results are the same as for a full run.
+ * 
+ * @param dict dictionary words
+ * @param store targets to crack
+ * @param old state of the earlier audit
+ * @param results where matches are reported
+ * @param filter candidates tried so far, or NULL to hash repeats too
+ * @param opts settings for the run
+ * @param stats counters for the run
+ */
+void crackIncremental( WordPool const *dict, TargetStore const *store, AuditState const *old,
+                       Results *results, BloomFilter *filter, Options const *opts, Stats *stats )
+{
+  /**
+   * Split the words into new and old, and find the new targets
+   */
+  long long *newWords = (long long *)malloc( ( dict->count + 1 ) * sizeof( long long ) );
+  long long *oldWords = (long long *)malloc( ( dict->count + 1 ) * sizeof( long long ) );
+  long long newCount = 0;
+  long long oldCount = 0;
+  for ( long long w = 0; w < dict->count; w++ ) {
+    if ( hasPrint( old->words, old->wordCount, wordPrint( dict, w ) ) ) {
+      oldWords[ oldCount++ ] = w;
+    } else {
+      newWords[ newCount++ ] = w;
+    }
+  }
+
+  bool *fresh = (bool *)malloc( ( store->count + 1 ) * sizeof( bool ) );
+  int freshCount = 0;
+  for ( int k = 0; k < store->count; k++ ) {
+    fresh[ k ] = !hasPrint( old->targets, old->targetCount, targetPrint( store, k ) );
+    freshCount += fresh[ k ];
+  }
+
+  stats->audit = true;
+  stats->oldWords = oldCount;
+  stats->oldTargets = store->count - freshCount;
+
+  replayHits( dict, store, old, fresh, results );
+
+  /**
+   * New words against every target, then old words against new targets
+   */
+  Keyspace *ks = makeSubsetKeyspace( dict, newWords, newCount );
+  crackKeyspace( ks, store, NULL, results, NULL, filter, opts, stats );
+  freeKeyspace( ks );
+
+  if ( freshCount > 0 && oldCount > 0 ) {
+    ks = makeSubsetKeyspace( dict, oldWords, oldCount );
+    crackKeyspace( ks, store, fresh, results, NULL, filter, opts, stats );
+    freeKeyspace( ks );
+  }
+
+  free( fresh );
+  free( oldWords );
+  free( newWords );
+}
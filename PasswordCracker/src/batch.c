@@ -0,0 +1,89 @@
+/**
+ * @file batch.c
+ * @author Luke Early
+ * Implements the batch of candidate passwords passed between the
+ * stages of cracking.
+ */
+
+#include "batch.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Dynamically allocates an empty batch.
+ * 
+ * @param cap number of candidates the batch can hold
+ * @return pointer to the newly created batch
+ */
+Batch *makeBatch( int cap )
+{
+  Batch *batch = (Batch *)malloc( sizeof( Batch ) );
+
+  batch->words = (Password *)malloc( cap * sizeof( Password ) );
+  batch->lens = (byte *)malloc( cap * sizeof( byte ) );
+  batch->index = (long long *)malloc( cap * sizeof( long long ) );
+  batch->count = 0;
+  batch->cap = cap;
+
+  return batch;
+}
+
+/**
+ * Frees the memory previously allocated to the given batch.
+ * 
+ * @param batch batch to free
+ */
+void freeBatch( Batch *batch )
+{
+  free( batch->words );
+  free( batch->lens );
+  free( batch->index );
+  free( batch );
+}
+
+/**
+ * Adds a candidate to the end of a batch that has room for it.
+ * 
+ * @param batch batch to add to
+ * @param word whole zero-padded slot holding the candidate
+ * @param len length of the candidate
+ * @param index position of the candidate among all of the candidates
+ */
+void addCandidate( Batch *batch, Password const word, int len, long long index )
+{
+  memcpy( batch->words[ batch->count ], word, sizeof( Password ) );
+  batch->lens[ batch->count ] = len;
+  batch->index[ batch->count ] = index;
+  batch->count++;
+}
+
+/**
+ * Removes the candidates a test rejects from a batch, keeping the
+ * order of the rest.
+ * 
+ * @param batch batch to filter
+ * @param keep test deciding whether each candidate stays
+ * @param ctx whatever the test needs
+ * @return number of candidates removed
+ */
+int filterBatch( Batch *batch, KeepFunction keep, void *ctx )
+{
+  int kept = 0;
+
+  for ( int i = 0; i < batch->count; i++ ) {
+    if ( !keep( ctx, batch->words[ i ], batch->lens[ i ] ) ) {
+      continue;
+    }
+
+    if ( kept != i ) {
+      memcpy( batch->words[ kept ], batch->words[ i ], sizeof( Password ) );
+      batch->lens[ kept ] = batch->lens[ i ];
+      batch->index[ kept ] = batch->index[ i ];
+    }
+    kept++;
+  }
+
+  int removed = batch->count - kept;
+  batch->count = kept;
+  return removed;
+}
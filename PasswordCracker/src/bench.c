@@ -0,0 +1,74 @@
+/**
+ * @file bench.c
+ * @author Luke Early
+ * Compares the MD5 backends on the md5crypt workload, so a slower
+ * in-tree kernel, or a library that disagrees with it, shows up.
+ */
+
+#include "bench.h"
+#include "password.h"
+#include "md5.h"
+#include "stats.h"
+#include <string.h>
+
+/**
+ * Hashes count made-up passwords with the current MD5 backend and
+ * folds their digests together.
+ * 
+ * @param count number of passwords to hash
+ * @param fold where the digests are folded, in order
+ */
+static void benchRun( int count, byte fold[ HASH_SIZE ] )
+{
+  PreparedSalt ps;
+  prepareSalt( &ps, BENCH_SALT );
+  memset( fold, 0, HASH_SIZE );
+
+  Password word;
+  byte hash[ HASH_SIZE ];
+  for ( int i = 0; i < count; i++ ) {
+    PreparedWord pw = { word, snprintf( word, sizeof( word ), "bench%d", i ) };
+    hashPrepared( &pw, &ps, hash );
+
+    for ( int j = 0; j < HASH_SIZE; j++ ) {
+      fold[ j ] = fold[ j ] * 31 + hash[ j ];
+    }
+  }
+}
+
+/**
+ * Times every MD5 backend in this build on the same md5crypt
+ * workload, on one thread, and prints each one's hashes per second.
+ * The backends must all produce the same digests; the backend in use
+ * before is chosen again afterwards.
+ * 
+ * @param count number of passwords each backend hashes
+ * @param fp stream to print the results to
+ * @return false if the backends' digests differ
+ */
+bool benchMd5Backends( int count, FILE *fp )
+{
+  char const *current = md5BackendName();
+  byte first[ HASH_SIZE ];
+  byte fold[ HASH_SIZE ];
+  bool agree = true;
+
+  for ( int i = 0; md5BackendAt( i ) != NULL; i++ ) {
+    setMd5Backend( md5BackendAt( i ) );
+
+    Stats timer;
+    initStats( &timer );
+    benchRun( count, i == 0 ? first : fold );
+    double secs = elapsedSeconds( &timer );
+
+    fprintf( fp, "md5 backend %-8s %.0f hashes/s\n", md5BackendAt( i ),
+             secs > 0 ? count / secs : 0.0 );
+    if ( i > 0 && memcmp( first, fold, HASH_SIZE ) != 0 ) {
+      fprintf( fp, "md5 backend %s disagrees with %s\n", md5BackendAt( i ), md5BackendAt( 0 ) );
+      agree = false;
+    }
+  }
+
+  setMd5Backend( current );
+  return agree;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file bloom.c
+ * @author Luke Early
+ * Implements a blocked Bloom filter for dropping candidates that
+ * were already tried.
+ * 
+ * Checking a candidate costs a hash of at most PW_LIMIT bytes and one
+ * cache line, where hashing a repeat would cost a whole md5crypt for
+ * every salt group.
+ */
+
+#include "bloom.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** FNV-1a offset basis for 64-bit hashes. */
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+
+/** FNV-1a prime for 64-bit hashes. */
+#define FNV_PRIME 0x100000001b3ULL
+
+/** Constant to derive the probe bits' hash from the block's. */
+#define PROBE_SEED 0x9e3779b97f4a7c15ULL
+
+/** Number of bits to pick one bit of a block. */
+#define PROBE_BITS 9
+
+/** Mask for a bit's position within a block. */
+#define PROBE_MASK ( ( 1 << PROBE_BITS ) - 1 )
+
+/** Number of bits in a word of a block. */
+#define WORD_BITS 64
+
+/**
+ * Scrambles the bits of a hash so each one depends on all the others.
+ * This is the MurmurHash3 finalizer.
+ * 
+ * @param h hash to scramble
+ * @return scrambled hash
+ */
+static uint64_t mix( uint64_t h )
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  return h;
+}
+
+/**
+ * Hashes a run of bytes down to 64 well-mixed bits.
+ * 
+ * @param data bytes to hash
+ * @param len number of bytes
+ * @return the hash
+ */
+uint64_t hashBytes( void const *data, size_t len )
+{
+  unsigned char const *bytes = (unsigned char const *)data;
+  uint64_t h = FNV_OFFSET;
+
+  for ( size_t i = 0; i < len; i++ ) {
+    h = ( h ^ bytes[ i ] ) * FNV_PRIME;
+  }
+
+  return mix( h ^ len );
+}
+
+/**
+ * Dynamically allocates an empty filter using about the given amount
+ * of memory.
+ * 
+ * @param bytes memory budget for the filter, at least one block
+ * @return pointer to the newly created filter
+ */
+BloomFilter *makeBloomFilter( size_t bytes )
+{
+  BloomFilter *bf = (BloomFilter *)malloc( sizeof( BloomFilter ) );
+
+  bf->blockCount = bytes / sizeof( BloomBlock ) > 0 ? bytes / sizeof( BloomBlock ) : 1;
+
+  void *mem = NULL;
+  if ( posix_memalign( &mem, BLOOM_BLOCK_BYTES, bf->blockCount * sizeof( BloomBlock ) ) != 0 ) {
+    free( bf );
+    return NULL;
+  }
+  bf->blocks = (BloomBlock *)mem;
+  memset( bf->blocks, 0, bf->blockCount * sizeof( BloomBlock ) );
+
+  return bf;
+}
+
+/**
+ * Frees the memory previously allocated to the given filter.
+ * 
+ * @param bf filter to free
+ */
+void freeBloomFilter( BloomFilter *bf )
+{
+  free( bf->blocks );
+  free( bf );
+}
+
+/**
+ * Adds a candidate to the filter, reporting whether it was there
+ * already.  Now and then, a candidate never added before is reported
+ * as seen; how often depends on how full the filter is.
+ * 
+ * @param bf filter to check and add to
+ * @param str the candidate
+ * @param len length of the candidate
+ * @return true if the candidate was seen before
+ */
+bool bloomTestAndSet( BloomFilter *bf, char const *str, int len )
+{
+  uint64_t h = hashBytes( str, len );
+
+  /**
+   * One hash picks the block, and another supplies the bits to set
+   * in it, PROBE_BITS at a time
+   */
+  BloomBlock *block = &bf->blocks[ h % bf->blockCount ];
+  uint64_t probes = mix( h ^ PROBE_SEED );
+  bool seen = true;
+
+  for ( int p = 0; p < BLOOM_PROBES; p++ ) {
+    int bit = ( probes >> ( p * PROBE_BITS ) ) & PROBE_MASK;
+    uint64_t mask = 1ULL << ( bit % WORD_BITS );
+
+    // any thread may be setting bits in the same block
+    uint64_t old = __atomic_fetch_or( &block->bits[ bit / WORD_BITS ], mask, __ATOMIC_RELAXED );
+    if ( ( old & mask ) == 0 ) {
+      seen = false;
+    }
+  }
+
+  return seen;
+}
+
+/**
+ * Keeps a candidate if the filter hasn't seen it, remembering it.
+ * 
+ * @param ctx the filter
+ * @param word the candidate's slot
+ * @param len length of the candidate
+ * @return true if the candidate is new
+ */
+static bool keepNew( void *ctx, Password const word, int len )
+{
+  return !bloomTestAndSet( (BloomFilter *)ctx, word, len );
+}
+
+/**
+ * Removes the candidates already seen from a batch, keeping the
+ * order of the rest, and remembers the ones kept.
+ * 
+ * @param bf filter of candidates seen so far
+ * @param batch batch to filter
+ * @return number of candidates removed
+ */
+int dropRepeats( BloomFilter *bf, Batch *batch )
+{
+  return filterBatch( batch, keepNew, bf );
+}
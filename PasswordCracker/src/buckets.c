@@ -0,0 +1,71 @@
+/**
+ * @file buckets.c
+ * @author Luke Early
+ * Groups the words of a list by length, for the generators that put
+ * words together and need to know up front which lengths fit.
+ */
+
+#include "buckets.h"
+#include <stdlib.h>
+
+/**
+ * Groups the words of a list by length with a counting sort.
+ * 
+ * @param lb buckets to fill in
+ * @param words words to group, which must outlive the buckets
+ */
+void bucketWords( LengthBuckets *lb, WordPool const *words )
+{
+  long long next[ LENGTH_COUNT ] = { 0 };
+
+  for ( long long i = 0; i < words->count; i++ ) {
+    next[ words->lens[ i ] ]++;
+  }
+
+  lb->bucketStart[ 0 ] = 0;
+  for ( int len = 0; len < LENGTH_COUNT; len++ ) {
+    lb->bucketStart[ len + 1 ] = lb->bucketStart[ len ] + next[ len ];
+    next[ len ] = lb->bucketStart[ len ];
+  }
+
+  lb->words = words;
+  lb->byLen = (long long *)malloc( ( words->count > 0 ? words->count : 1 ) * sizeof( long long ) );
+  for ( long long i = 0; i < words->count; i++ ) {
+    lb->byLen[ next[ words->lens[ i ] ]++ ] = i;
+  }
+}
+
+/**
+ * Frees the memory held by the given buckets.
+ * 
+ * @param lb buckets to free
+ */
+void freeBuckets( LengthBuckets *lb )
+{
+  free( lb->byLen );
+}
+
+/**
+ * Returns the number of words of the given length.
+ * 
+ * @param lb grouped words
+ * @param len word length
+ * @return number of words that long
+ */
+long long bucketSize( LengthBuckets const *lb, int len )
+{
+  return lb->bucketStart[ len + 1 ] - lb->bucketStart[ len ];
+}
+
+/**
+ * Returns the i-th word of the given length.
+ * 
+ * @param lb grouped words
+ * @param len word length
+ * @param i index of the word among those of its length
+ * @return the word's slot
+ */
+char const *bucketWord( LengthBuckets const *lb, int len, long long i )
+{
+  return lb->words->slots[ lb->byLen[ lb->bucketStart[ len ] + i ] ];
+}
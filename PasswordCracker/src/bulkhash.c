@@ -0,0 +1,179 @@
+/**
+ * @file bulkhash.c
+ * @author Luke Early
+ * Hashes lists of passwords in bulk, for building test shadow files
+ * and measuring raw hashing speed.
+ */
+
+#include "bulkhash.h"
+#include "password.h"
+#include "batch.h"
+#include "workers.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Characters that may not appear in a password. */
+#define SPACE_CHARS " \t\r\v\f"
+
+/** Buffer for the hashes written out, kept until the program exits. */
+static char outputBuffer[ HASH_OUTPUT_BUFFER ];
+
+/** A round of lines being hashed. */
+typedef struct {
+  // Passwords to hash.
+  Batch *batch;
+
+  // Salt of each password.
+  PreparedSalt *salts;
+
+  // Printable hash of each password.
+  char (*hashes)[ PW_HASH_LIMIT + 1 ];
+
+  // Next password for a worker to take.
+  int next;
+} HashRound;
+
+/**
+ * Worker thread body: takes tiles of the round until none are left.
+ * 
+ * @param id worker number
+ * @param ctx the shared HashRound
+ */
+static void hashWorker( int id, void *ctx )
+{
+  HashRound *round = (HashRound *)ctx;
+  Batch *batch = round->batch;
+  byte hash[ HASH_SIZE ];
+
+  while ( true ) {
+    int start = __atomic_fetch_add( &round->next, HASH_TILE, __ATOMIC_RELAXED );
+    if ( start >= batch->count ) {
+      break;
+    }
+
+    int end = start + HASH_TILE < batch->count ? start + HASH_TILE : batch->count;
+    long long span = traceBegin();
+    for ( int i = start; i < end; i++ ) {
+      PreparedWord pw = { batch->words[ i ], batch->lens[ i ] };
+      hashPrepared( &pw, &round->salts[ i ], hash );
+      hashToString( hash, round->hashes[ i ] );
+    }
+    traceEnd( "hash tile", span );
+    throttleWorker();
+  }
+}
+
+/**
+ * Splits a line of input into its password and salt.
+ * 
+ * @param line the line, without its newline; changed in place
+ * @param salt salt for every line, or NULL if the line has one
+ * @param word where the password is stored
+ * @param ps where the salt is prepared, if the line has one
+ * @return false if the line is not valid
+ */
+static bool parseHashLine( char *line, char const *salt, Password word, PreparedSalt *ps )
+{
+  if ( salt == NULL ) {
+    char *space = strchr( line, ' ' );
+    if ( space == NULL ) {
+      return false;
+    }
+
+    *space = '\0';
+    salt = space + 1;
+    if ( !isValidSalt( salt ) ) {
+      return false;
+    }
+    prepareSalt( ps, salt );
+  }
+
+  size_t len = strlen( line );
+  if ( len == 0 || len > PW_LIMIT || strcspn( line, SPACE_CHARS ) != len ) {
+    return false;
+  }
+
+  memset( word, 0, sizeof( Password ) );
+  strcpy( word, line );
+  return true;
+}
+
+/**
+ * Hashes every line of the input and writes a "$1$salt$hash" line
+ * for each, in input order.  Each line is a word to hash with the
+ * given salt or, without one, a word and a salt separated by a
+ * space.  Lines are taken in rounds, each hashed by all the workers
+ * at once.  The output is fully buffered, so nothing may have been
+ * written to it yet.  If a line is invalid, exit unsuccessfully.
+ * 
+ * @param in stream of words
+ * @param out stream the hashes are written to
+ * @param salt salt to hash every word with, or NULL if each line has one
+ * @param threads number of hashing workers
+ * @param stats counters for the run
+ */
+void hashStream( FILE *in, FILE *out, char const *salt, int threads, Stats *stats )
+{
+  HashRound round;
+  round.batch = makeBatch( HASH_ROUND );
+  round.salts = (PreparedSalt *)malloc( HASH_ROUND * sizeof( PreparedSalt ) );
+  round.hashes = malloc( HASH_ROUND * sizeof( *round.hashes ) );
+  stats->threads = threads;
+
+  PreparedSalt fixed;
+  if ( salt != NULL ) {
+    prepareSalt( &fixed, salt );
+  }
+
+  setvbuf( out, outputBuffer, _IOFBF, sizeof( outputBuffer ) );
+
+  char *line = NULL;
+  size_t cap = 0;
+  long long next = 0;
+  bool more = true;
+
+  while ( more ) {
+    Batch *batch = round.batch;
+    batch->count = 0;
+
+    long long span = traceBegin();
+    ssize_t len;
+    while ( batch->count < batch->cap && ( len = getline( &line, &cap, in ) ) > 0 ) {
+      if ( line[ len - 1 ] == '\n' ) {
+        line[ --len ] = '\0';
+      }
+
+      Password word;
+      PreparedSalt *ps = &round.salts[ batch->count ];
+      if ( !parseHashLine( line, salt, word, ps ) ) {
+        fprintf( stderr, "Invalid hash input line\n" );
+        exit( EXIT_FAILURE );
+      }
+      if ( salt != NULL ) {
+        *ps = fixed;
+      }
+
+      addCandidate( batch, word, strlen( word ), next++ );
+    }
+    more = batch->count == batch->cap;
+    traceEnd( "read lines", span );
+
+    round.next = 0;
+    if ( batch->count > 0 ) {
+      runWorkers( threads, hashWorker, &round );
+    }
+    countStat( &stats->candidates, batch->count );
+    countStat( &stats->hashes, batch->count );
+
+    for ( int i = 0; i < batch->count; i++ ) {
+      fprintf( out, "$1$%s$%s\n", round.salts[ i ].str, round.hashes[ i ] );
+    }
+  }
+
+  fflush( out );
+  free( line );
+  free( round.hashes );
+  free( round.salts );
+  freeBatch( round.batch );
+}
@@ -0,0 +1,153 @@
+/**
+ * @file combinator.c
+ * @author Luke Early
+ * Implements the combinator keyspace, which joins every word of one
+ * list with every word of another.
+ * 
+ * Each list is sorted into buckets by word length.  Only the pairs of
+ * buckets whose lengths add up to at most PW_LIMIT get positions in
+ * the keyspace, so a pair that can't fit costs nothing, no matter how
+ * many words it holds.  Candidates are built in a buffer local to the
+ * filling thread, with the left word copied once for a whole run of
+ * right words.
+ */
+
+#include "combinator.h"
+#include "buckets.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** A pair of word lengths that fit together, and where its positions start. */
+typedef struct {
+  // Length of the left words.
+  int left;
+
+  // Length of the right words.
+  int right;
+
+  // First keyspace position of the pair.
+  long long start;
+} BucketPair;
+
+/** What a combinator keyspace needs to produce its candidates. */
+typedef struct {
+  LengthBuckets left;
+  LengthBuckets right;
+
+  // Pairs of non-empty buckets that fit, plus one marking the end.
+  BucketPair pairs[ LENGTH_COUNT * LENGTH_COUNT + 1 ];
+  int pairCount;
+} CombinatorState;
+
+/**
+ * Adds the combinator candidates at positions start up to end to the
+ * batch.
+ * 
+ * @param ks combinator keyspace
+ * @param start first position
+ * @param end position after the last one
+ * @param out batch to add to
+ */
+static void fillCombinator( Keyspace const *ks, long long start, long long end, Batch *out )
+{
+  CombinatorState const *cs = (CombinatorState const *)ks->state;
+
+  /**
+   * Find the pair of lengths holding the start position
+   */
+  int lo = 0;
+  int hi = cs->pairCount - 1;
+  while ( lo < hi ) {
+    int mid = ( lo + hi + 1 ) / 2;
+    if ( cs->pairs[ mid ].start <= start ) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+
+  long long idx = start;
+  for ( int p = lo; idx < end; p++ ) {
+    BucketPair const *bp = &cs->pairs[ p ];
+    long long rightCount = bucketSize( &cs->right, bp->right );
+    long long pairEnd = cs->pairs[ p + 1 ].start < end ? cs->pairs[ p + 1 ].start : end;
+
+    while ( idx < pairEnd ) {
+      long long l = ( idx - bp->start ) / rightCount;
+      long long r = ( idx - bp->start ) % rightCount;
+      long long runEnd = idx + ( rightCount - r ) < pairEnd ? idx + ( rightCount - r ) : pairEnd;
+
+      /**
+       * Lay out the left word once, then drop each right word in
+       * after it, along with the zeros that pad its slot
+       */
+      Password cand;
+      memcpy( cand, bucketWord( &cs->left, bp->left, l ), bp->left );
+      for ( ; idx < runEnd; idx++, r++ ) {
+        memcpy( cand + bp->left, bucketWord( &cs->right, bp->right, r ),
+                sizeof( Password ) - bp->left );
+        addCandidate( out, cand, bp->left + bp->right, idx );
+      }
+    }
+  }
+}
+
+/**
+ * Frees a combinator keyspace's state.
+ * 
+ * @param state state to free
+ */
+static void freeCombinator( void *state )
+{
+  CombinatorState *cs = (CombinatorState *)state;
+
+  freeBuckets( &cs->left );
+  freeBuckets( &cs->right );
+  free( cs );
+}
+
+/**
+ * Makes a keyspace of every word of the left list followed by every
+ * word of the right list, leaving out the pairs too long for a
+ * password.  Both lists are grouped by word length, and the keyspace
+ * only covers the pairs of lengths that fit, so the rest are never
+ * visited.
+ * 
+ * @param left words that come first, which must outlive the keyspace
+ * @param right words that come second, which must outlive the keyspace
+ * @return pointer to the newly created keyspace
+ */
+Keyspace *makeCombinatorKeyspace( WordPool const *left, WordPool const *right )
+{
+  CombinatorState *cs = (CombinatorState *)malloc( sizeof( CombinatorState ) );
+
+  bucketWords( &cs->left, left );
+  bucketWords( &cs->right, right );
+
+  /**
+   * Lay out the pairs of lengths that fit, one after another
+   */
+  long long size = 0;
+  cs->pairCount = 0;
+  for ( int a = 0; a < LENGTH_COUNT; a++ ) {
+    for ( int b = 0; a + b <= PW_LIMIT; b++ ) {
+      long long count = bucketSize( &cs->left, a ) * bucketSize( &cs->right, b );
+      if ( count > 0 ) {
+        BucketPair *bp = &cs->pairs[ cs->pairCount++ ];
+        bp->left = a;
+        bp->right = b;
+        bp->start = size;
+        size += count;
+      }
+    }
+  }
+  cs->pairs[ cs->pairCount ].start = size;
+
+  Keyspace *ks = (Keyspace *)malloc( sizeof( Keyspace ) );
+  ks->size = size;
+  ks->fill = fillCombinator;
+  ks->cleanup = freeCombinator;
+  ks->state = cs;
+
+  return ks;
+}
@@ -8,306 +8,423 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
-#include <ctype.h>
 
 #include "password.h"
+#include "options.h"
+#include "dictionary.h"
+#include "shadow.h"
+#include "pipeline.h"
+#include "workers.h"
+#include "shmdict.h"
+#include "pool.h"
+#include "targets.h"
+#include "results.h"
+#include "engine.h"
+#include "stats.h"
+#include "keyspace.h"
+#include "hybrid.h"
+#include "combinator.h"
+#include "markov.h"
+#include "prince.h"
+#include "bloom.h"
+#include "policy.h"
+#include "audit.h"
+#include "daemon.h"
+#include "saltindex.h"
+#include "bulkhash.h"
+#include "bench.h"
+#include "md5.h"
+#include "tune.h"
+#include "plan.h"
+#include "numa.h"
+#include "trace.h"
+
+/** Bytes in a mebibyte. */
+#define BYTES_PER_MB ( 1 << 20 )
 
-/** Maximum username length */
-#define USERNAME_LIMIT 32
-
-/** Maximum number of words we can have in the dictionary. */
-#define DLIST_LIMIT 1000
-
-/** Number of required arguments on the command line. */
-#define REQ_ARGS 2
-
-/** initial capacity of a resizable string */
-#define INIT_STR_CAP 5
+/**
+ * Driver function for the program.
+ */
+int main( int argc, char *argv[] )
+{
+  Options opts;
+  parseOptions( argc, argv, &opts );
+  if ( opts.traceName != NULL ) {
+    startTrace( opts.traceName );
+  }
+  long long span;
 
-/** initial capacity of a resizable array */
-#define INIT_ARR_CAP 5
+  if ( opts.md5Backend != NULL && !setMd5Backend( opts.md5Backend ) ) {
+    fprintf( stderr, "MD5 backend %s is not available\n", opts.md5Backend );
+    exit( EXIT_FAILURE );
+  }
+  /**
+   * Keep the workers within their share of the host
+   */
+  WorkerLimits limits;
+  memset( &limits, 0, sizeof( limits ) );
+  limits.maxCpu = opts.maxCpu;
+  limits.nice = opts.nice;
+  if ( opts.affinity != NULL && !parseCpuList( opts.affinity, &limits ) ) {
+    fprintf( stderr, "Invalid CPU list\n" );
+    exit( EXIT_FAILURE );
+  }
+  if ( opts.numa ) {
+    if ( !enableNuma() ) {
+      fprintf( stderr, "NUMA nodes not available\n" );
+      exit( EXIT_FAILURE );
+    }
+    numaWorkerLimits( &limits );
+  }
+  setWorkerLimits( &limits );
 
-/** number of excess shadow file characters */
-#define EXCESS_SHADOW 18
+  if ( opts.autotune ) {
+    autotune( &opts, opts.stats ? stderr : NULL );
+  }
 
-/** length of the MD5 ID */
-#define MD5_ID_HASH_LENGTH 3
+  // serve jobs from clients, or be a client, instead of cracking one file
+  if ( opts.daemonName != NULL ) {
+    runDaemon( &opts );
+    return EXIT_SUCCESS;
+  }
+  if ( opts.connectName != NULL ) {
+    connectDaemon( &opts );
+    return EXIT_SUCCESS;
+  }
 
-/** max number of command line arguments */
-#define MAX_NUMBER_CLA 3
+  Stats stats;
+  initStats( &stats );
 
-/** location of dictionary file name in argv array */
-#define DICTIONARY_FILE_NAME_LOCATION 1
+  /**
+   * Learn Markov statistics from the whole dictionary instead of
+   * cracking anything
+   */
+  if ( opts.markovTrain != NULL ) {
+    FILE *trainFilePtr = openDictionary( opts.dictName );
+    if ( trainFilePtr == NULL ) {
+      perror( opts.dictName );
+      exit( EXIT_FAILURE );
+    }
 
-/** location of shadow file name in argv array */
-#define SHADOW_FILE_NAME_LOCATION 2
+    WordPool *words = makeWordPool();
+    readDictionary( trainFilePtr, words, 0 );
 
-/** factor by which to resize things that are resizeable */
-#define RESIZE_FACTOR 2
+    MarkovStats *markov = (MarkovStats *)calloc( 1, sizeof( MarkovStats ) );
+    trainMarkov( markov, words );
+    if ( !saveMarkovStats( opts.markovTrain, markov ) ) {
+      perror( opts.markovTrain );
+      exit( EXIT_FAILURE );
+    }
 
-/** standard length of dict file name: dictionary-00.txt */
-#define STANDARD_DICT_FILE_LEN 17
+    free( markov );
+    freeWordPool( words );
+    fclose( trainFilePtr );
+    return EXIT_SUCCESS;
+  }
 
-/** standard length of shad file name: shadow-00.txt */
-#define STANDARD_SHAD_FILE_LEN 13
+  /**
+   * Time the MD5 backends instead of cracking anything
+   */
+  if ( opts.benchCount > 0 ) {
+    return benchMd5Backends( opts.benchCount, stdout ) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
 
-/**
- * Struct for users
- */
-struct UserStruct {
-  char userName[ USERNAME_LIMIT + 1 ];
-  char userHash[ PW_HASH_LIMIT + 1 ];
-  char userSalt[ SALT_LENGTH + 1 ];
-  struct UserStruct *next;
-};
+  /**
+   * Just hash the given words instead of cracking anything
+   */
+  if ( opts.hashName != NULL ) {
+    if ( opts.hashSalt != NULL && !isValidSalt( opts.hashSalt ) ) {
+      fprintf( stderr, "Invalid salt\n" );
+      exit( EXIT_FAILURE );
+    }
 
-/** type name for user struct */
-typedef struct UserStruct User;
+    FILE *hashFilePtr = openDictionary( opts.hashName );
+    if ( hashFilePtr == NULL ) {
+      perror( opts.hashName );
+      exit( EXIT_FAILURE );
+    }
 
-/** Type for representing a word in the dictionary. */
-typedef char Password[ PW_LIMIT + 1 ];
+    hashStream( hashFilePtr, stdout, opts.hashSalt, workerCount( opts.threads ), &stats );
+    if ( opts.stats ) {
+      printStats( &stats, stderr );
+    }
 
-/** Print out a usage message and exit unsuccessfully. */
-static void usage()
-{
-  fprintf( stderr, "Usage: crack dictionary-filename shadow-filename\n" );
-  exit( EXIT_FAILURE );
-}
+    fclose( hashFilePtr );
+    return EXIT_SUCCESS;
+  }
 
-/**
- * Reads in a single line of input from dictionary file stream.
- * 
- * Stores it in str param.
- * 
- * @param fp pointer to input stream
- * @param str string to store it in
- */
-void readDictLine( FILE *fp, char *str )
-{
-  int count = 0;
-  int capacity = INIT_STR_CAP;
-  char *dictStr = malloc( INIT_STR_CAP * sizeof( char ) );
-  
-  char currChar;
-  
-  while ( fscanf( fp, "%c", &currChar ) == 1 ) {
-    if ( isspace( currChar ) && currChar != '\n' ) {
-      fprintf( stderr, "Invalid dictionary word\n" );
+  /**
+   * Hash the whole dictionary with one salt, once, for later runs to
+   * look targets up in
+   */
+  if ( opts.buildIndex != NULL ) {
+    FILE *indexDictPtr = openDictionary( opts.dictName );
+    if ( indexDictPtr == NULL ) {
+      perror( opts.dictName );
       exit( EXIT_FAILURE );
     }
 
-    if ( isspace( currChar ) && currChar == '\n' ) {
-      break;
+    WordPool *words = makeWordPool();
+    readDictionary( indexDictPtr, words, opts.maxWords );
+    if ( !buildSaltIndex( opts.buildIndex, opts.indexSalt, words, workerCount( opts.threads ) ) ) {
+      fprintf( stderr, "Can't build salt index %s\n", opts.buildIndex );
+      exit( EXIT_FAILURE );
     }
 
-    // resize string array if exceeds capacity
-    if ( count + 1 >= capacity ) {
-      capacity *= RESIZE_FACTOR;
-      dictStr = realloc( dictStr, capacity*sizeof( char ) );
-    } 
-
-    dictStr[ count ] = currChar;
-    count++;
-  }
-
-  if ( feof( fp ) ) {
-    dictStr = NULL;
-    count = 0;
+    freeWordPool( words );
+    fclose( indexDictPtr );
+    return EXIT_SUCCESS;
   }
 
-  if ( count > 0 ) {
-    dictStr[ count ] = '\0';
+  /**
+   * Ensure files open
+   */
+  FILE *dictFilePtr = NULL;
+  if ( opts.dictName != NULL ) {
+    dictFilePtr = openDictionary( opts.dictName );
   }
 
-  if ( count > PW_LIMIT ) {
-    fprintf( stderr, "Invalid dictionary word\n" );
+  if ( opts.dictName != NULL && dictFilePtr == NULL ) {
+    perror( opts.dictName );
     exit( EXIT_FAILURE );
   }
+  ShadowSet *shadows = openShadowFiles( opts.shadowNames, opts.shadowCount, opts.manifestName );
 
-  if ( dictStr == NULL ) {
-    strcpy( str, "" );
-    free( dictStr );
-  } else {
-    strcpy( str, dictStr );
-    free( dictStr );
-  }
-}
-
-/**
- * Reads in a single line of input from shadow file.
- * 
- * Adds User to the end of the linked list, returns the new head pointer.
- * 
- * @param fp pointer to input stream
- * @param head current head pointer for linked list of Users
- * @return new head pointer
- */
-User * readUserFromFile( User *head, FILE *fp )
-{
-  char nameStr[ USERNAME_LIMIT + 1 ] = "";
-  char saltStr[ SALT_LENGTH + 1 ] = "";
-  char hashStr[ PW_HASH_LIMIT + 1 ] = ""; 
-  char trash[ EXCESS_SHADOW + 1 ] = "";
-  char md5IdHash[ MD5_ID_HASH_LENGTH + 1 ] = "";
-
-  User *newUser = (User *)calloc( 1, sizeof( User ) );
-
-  if ( fscanf( fp, "%[a-zA-Z]:", nameStr ) == 1 ) {
-    nameStr[ strlen( nameStr ) ] = '\0';
-    strncpy( newUser->userName, nameStr, USERNAME_LIMIT );
+  /**
+   * Set up the filters that drop candidates not worth hashing
+   */
+  Policy policy;
+  if ( opts.policy != NULL && !parsePolicy( opts.policy, &policy ) ) {
+    fprintf( stderr, "Invalid policy\n" );
+    exit( EXIT_FAILURE );
   }
+  Policy const *policyPtr = opts.policy != NULL ? &policy : NULL;
 
-  if ( fscanf( fp, "%3c", md5IdHash ) == 1 ) {
-    if ( strncmp( md5IdHash, "$1$", MD5_ID_HASH_LENGTH ) != 0 ) {
-      fprintf( stderr, "Invalid shadow file entry\n" );
+  BloomFilter *filter = NULL;
+  if ( opts.dedupeMB > 0 ) {
+    filter = makeBloomFilter( (size_t) opts.dedupeMB * BYTES_PER_MB );
+    if ( filter == NULL ) {
+      fprintf( stderr, "Not enough memory for the repeat filter\n" );
       exit( EXIT_FAILURE );
     }
   }
 
-  if ( fscanf( fp, "%[a-zA-Z0-9./]$", saltStr ) == 1 ) {
-    if ( strlen( saltStr ) > SALT_LENGTH ) {
-      fprintf( stderr, "Invalid shadow file entry\n" );
-      exit( EXIT_FAILURE );
+  /**
+   * Stream the dictionary past the users instead of loading it
+   */
+  if ( opts.pipeline ) {
+    span = traceBegin();
+    TargetStore *store = readShadowSet( shadows );
+    traceEnd( "parse shadow", span );
+    Results *results = makeResults( store, true );
+    stats.targets = store->count;
+    stats.saltGroups = store->saltCount;
+    crackPipelined( dictFilePtr, store, results, workerCount( opts.threads ), policyPtr, filter,
+                    &stats );
+
+    if ( opts.stats ) {
+      printStats( &stats, stderr );
     }
-    strncpy( newUser->userSalt, saltStr, SALT_LENGTH );
-  }
 
-  if ( fscanf( fp, "%[a-zA-z0-9./]:", hashStr ) == 1 ) {
-    fscanf( fp, "%18c\n", trash );
-    hashStr[ strlen( hashStr ) ] = '\0';
-    strncpy( newUser->userHash, hashStr, PW_HASH_LIMIT );
+    if ( filter != NULL ) {
+      freeBloomFilter( filter );
+    }
+    freeResults( results );
+    freeTargets( store );
+    fclose( dictFilePtr );
+    freeShadowSet( shadows );
+    return EXIT_SUCCESS;
   }
 
-  if ( head == NULL ) {
-    return newUser;
+  /**
+   * Attach to a dictionary another run has already shared
+   */
+  SharedDict *shared = NULL;
+  WordPool *dict = NULL;
+  if ( opts.shmName != NULL ) {
+    shared = attachSharedDict( opts.shmName, dictFilePtr, opts.maxWords );
   }
 
-  User * temp = head;
-
-  while ( temp->next != NULL ) {
-    temp = temp->next;
+  /**
+   * Otherwise read in the dictionary, then publish it and use the
+   * shared copy in place of ours
+   */
+  if ( shared == NULL && dictFilePtr != NULL ) {
+    dict = makeWordPool();
+    span = traceBegin();
+    readDictionary( dictFilePtr, dict, opts.maxWords );
+    traceEnd( "read dictionary", span );
+
+    if ( opts.shmName != NULL ) {
+      shared = publishSharedDict( opts.shmName, dictFilePtr, dict, opts.maxWords );
+      if ( shared != NULL ) {
+        freeWordPool( dict );
+      }
+    }
   }
 
-  temp->next = newUser;
-  return head;
-}
+  if ( shared != NULL ) {
+    dict = viewWordPool( shared->words, shared->hdr->wordCount );
+  }
 
+  // every worker reads the whole dictionary, so no node should hold all of it
+  if ( dict != NULL ) {
+    interleaveMemory( dict->slots, dict->count * sizeof( Password ) );
+  }
 
-/**
- * Driver function for the program.
- */
-int main( int argc, char *argv[] )
-{
   /**
-   * Check for valid file names
-   * 
-   * If valid store, else usage() 
+   * Read in the second word list of a combinator run
    */
-  char *testStr;
-  if ( argc != MAX_NUMBER_CLA ) {
-    usage();
-  } 
-  
-  testStr = strstr( argv[ DICTIONARY_FILE_NAME_LOCATION ], "dictionary" );
-  if ( testStr == NULL ) {
-    usage();
-  }
+  WordPool *right = NULL;
+  if ( opts.combineName != NULL ) {
+    FILE *rightFilePtr = openDictionary( opts.combineName );
+    if ( rightFilePtr == NULL ) {
+      perror( opts.combineName );
+      exit( EXIT_FAILURE );
+    }
 
-  testStr = strstr( argv[ SHADOW_FILE_NAME_LOCATION ], "shadow" );
-  if ( testStr == NULL ) {
-    usage();
+    right = makeWordPool();
+    span = traceBegin();
+    readDictionary( rightFilePtr, right, opts.maxWords );
+    traceEnd( "read dictionary", span );
+    fclose( rightFilePtr );
   }
 
+  span = traceBegin();
+  TargetStore *store = readShadowSet( shadows );
+  traceEnd( "parse shadow", span );
+  Results *results = makeResults( store, false );
+
+  stats.targets = store->count;
+  stats.saltGroups = store->saltCount;
+
   /**
-   * Ensure files open
+   * Choose the candidates: the words themselves, the words extended
+   * with a mask, chains of the words, the words joined with those of
+   * another list, or the likeliest strings under Markov statistics
    */
-  FILE *dictFilePtr = fopen( argv[ DICTIONARY_FILE_NAME_LOCATION ], "r" );
-  FILE *shadowFilePtr = fopen( argv[ SHADOW_FILE_NAME_LOCATION ], "r" );
+  Keyspace *ks;
+  if ( opts.markovName != NULL ) {
+    MarkovStats *markov = (MarkovStats *)malloc( sizeof( MarkovStats ) );
+    if ( !loadMarkovStats( opts.markovName, markov ) ) {
+      fprintf( stderr, "Invalid Markov statistics file\n" );
+      exit( EXIT_FAILURE );
+    }
 
-  if ( dictFilePtr == NULL ) {
-    perror( argv[ DICTIONARY_FILE_NAME_LOCATION ] );
-    exit( EXIT_FAILURE );
-  } else if ( shadowFilePtr == NULL ) {
-    perror( argv[ SHADOW_FILE_NAME_LOCATION ] );
-    exit( EXIT_FAILURE );
+    ks = makeMarkovKeyspace( markov, opts.markovThreshold, opts.markovLength );
+    free( markov );
+    if ( ks == NULL ) {
+      fprintf( stderr, "Too many Markov candidates\n" );
+      exit( EXIT_FAILURE );
+    }
+  } else if ( opts.prince ) {
+    ks = makePrinceKeyspace( dict, opts.princeElems );
+    if ( ks == NULL ) {
+      fprintf( stderr, "Too many PRINCE candidates\n" );
+      exit( EXIT_FAILURE );
+    }
+  } else if ( right != NULL ) {
+    ks = makeCombinatorKeyspace( dict, right );
+  } else if ( opts.hybridSuffix != NULL || opts.hybridPrefix != NULL ) {
+    bool prefix = opts.hybridPrefix != NULL;
+    ks = makeHybridKeyspace( dict, prefix ? opts.hybridPrefix : opts.hybridSuffix, prefix );
+    if ( ks == NULL ) {
+      fprintf( stderr, "Invalid mask\n" );
+      exit( EXIT_FAILURE );
+    }
+  } else {
+    ks = makeDictKeyspace( dict );
   }
 
   /**
-   * Read in the dictionary
+   * Estimate the run instead of making it, or check passwords,
+   * skipping what an earlier audit covered, and record this audit
+   * for the next
    */
-  char **dictArray = (char **)malloc( INIT_ARR_CAP * sizeof( Password ) );
-  int dictArraySize = 0;
-  int dictArrayCap = INIT_ARR_CAP;
+  if ( opts.plan ) {
+    printPlan( ks, store, dict, right, &opts, stdout );
+  } else if ( opts.stateName != NULL ) {
+    AuditState *old = loadAuditState( opts.stateName );
+    if ( old == NULL ) {
+      fprintf( stderr, "Invalid audit state file\n" );
+      exit( EXIT_FAILURE );
+    }
 
-  char *dictLine = (char *)malloc( PW_LIMIT * sizeof( char ) );
-  readDictLine( dictFilePtr, dictLine );
+    crackIncremental( dict, store, old, results, filter, &opts, &stats );
+    span = traceBegin();
+    printResults( results );
+    traceEnd( "print results", span );
 
-  while ( ( strcmp( dictLine, "" ) != 0 ) ) {
-    /**
-     * resize array if need be
-     */
-    if ( dictArraySize + 1 >= dictArrayCap ) {
-      dictArrayCap *= RESIZE_FACTOR;
-      dictArray = (char **)realloc( dictArray, dictArrayCap * sizeof( Password ) );
+    AuditState *state = makeAuditState( dict, store, results );
+    if ( !saveAuditState( opts.stateName, state ) ) {
+      perror( opts.stateName );
+      exit( EXIT_FAILURE );
     }
 
+    freeAuditState( state );
+    freeAuditState( old );
+  } else {
     /**
-     * 1. add next word to dictionary array
-     * 
-     * 2. Read in next line
+     * Answer the users with an indexed salt by lookup, and hash for
+     * the rest
      */
-    dictArray[ dictArraySize++ ] = dictLine;
-    if ( dictArraySize > DLIST_LIMIT ) {
-      fprintf( stderr, "Too many dictionary words\n" );
-      exit( EXIT_FAILURE );
-    }
-    
-    dictLine = (char *)malloc( PW_LIMIT * sizeof( char ) );
-    readDictLine( dictFilePtr, dictLine );
-  }
+    bool *wanted = NULL;
+    if ( opts.indexName != NULL ) {
+      SaltIndex *index = openSaltIndex( opts.indexName );
+      if ( index == NULL ) {
+        fprintf( stderr, "Invalid salt index file\n" );
+        exit( EXIT_FAILURE );
+      }
+      if ( index->hdr->wordCount != (uint64_t) dict->count || index->hdr->dictPrint != dictPrint( dict ) ) {
+        fprintf( stderr, "Salt index was built from a different dictionary\n" );
+        exit( EXIT_FAILURE );
+      }
 
-  User *list = NULL;
-  int userCount = 0;
-  
-  while ( true ) {
-    if ( feof( shadowFilePtr ) ) {
-      break;
+      wanted = (bool *)malloc( ( store->count + 1 ) * sizeof( bool ) );
+      for ( int i = 0; i < store->count; i++ ) {
+        wanted[ i ] = true;
+      }
+      span = traceBegin();
+      stats.indexed = lookupSaltIndex( index, dict, store, wanted, results, policyPtr,
+                                       filter != NULL || opts.tierCount > 0 );
+      traceEnd( "index lookup", span );
+      closeSaltIndex( index );
     }
-    
-    list = readUserFromFile( list, shadowFilePtr );
-    userCount++;
-  }
 
-  /**
-   * Check passwords
-   */
-  for ( User *curr = list; curr; curr = curr->next ) {
-    char hashResult[ PW_HASH_LIMIT + 1 ] = "";
+    crackKeyspace( ks, store, wanted, results, policyPtr, filter, &opts, &stats );
+    span = traceBegin();
+    printResults( results );
+    traceEnd( "print results", span );
+    free( wanted );
+  }
 
-    for ( int j = 0; j < dictArraySize; j++ ) {
-      hashPassword( dictArray[ j ], curr->userSalt, hashResult );
-      if ( strcmp( hashResult, curr->userHash ) == 0 ) {
-        printf( "%s : %s\n", curr->userName, dictArray[ j ] );
-      }
-    }
+  if ( opts.stats ) {
+    printStats( &stats, stderr );
   }
 
   /**
    * free all heap mem and close all file streams
    */
-  for ( int i = 0; i < dictArraySize; i++ ) {
-    free( dictArray[ i ] );
+  if ( dict != NULL ) {
+    freeWordPool( dict );
   }
-
-  for ( User *curr = list; curr; ) {
-    User *temp = curr->next;
-    free( curr );
-    curr = temp;
+  if ( right != NULL ) {
+    freeWordPool( right );
+  }
+  if ( shared != NULL ) {
+    detachSharedDict( shared, opts.shmKeep );
   }
 
-  free( dictLine );
-  free( dictArray );
-  fclose( dictFilePtr );
-  fclose( shadowFilePtr );
+  if ( filter != NULL ) {
+    freeBloomFilter( filter );
+  }
+  freeKeyspace( ks );
+  freeResults( results );
+  freeTargets( store );
+  if ( dictFilePtr != NULL ) {
+    fclose( dictFilePtr );
+  }
+  freeShadowSet( shadows );
 
+  return EXIT_SUCCESS;
 }
@@ -0,0 +1,828 @@
+/**
+ * @file daemon.c
+ * @author Luke Early
+ * Keeps the dictionary and hashing workers ready between runs,
+ * taking cracking jobs from clients over a UNIX socket.
+ */
+
+#include "daemon.h"
+#include "dictionary.h"
+#include "shadow.h"
+#include "password.h"
+#include "pool.h"
+#include "targets.h"
+#include "results.h"
+#include "workers.h"
+#include "trace.h"
+#include "groups.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/** Line that ends the shadow entries of a JOB command. */
+#define JOB_END ".\n"
+
+/** Size of the buffer used to copy between the client and the daemon. */
+#define COPY_BUFFER 4096
+
+/** Milliseconds between checks that the client of a running job is still there. */
+#define HANGUP_POLL_MS 100
+
+/** Nanoseconds in a millisecond and in a second. */
+#define NS_PER_MS 1000000L
+#define NS_PER_SEC 1000000000L
+
+/**
+ * A loaded dictionary, shared by the jobs that started while it was
+ * current.  It is freed once the daemon has moved on to a newer one
+ * and the last of those jobs has finished.
+ */
+typedef struct {
+  // The words.
+  WordPool *pool;
+
+  // Jobs using it, plus one while it is the daemon's current dictionary.
+  int refs;
+} Snapshot;
+
+/** A cracking job sent by a client. */
+typedef struct JobStruct {
+  // Number the client uses to refer to the job.
+  int id;
+
+  // Jobs with a higher priority are worked on first.
+  int priority;
+
+  // Order the job was queued in, to break ties in priority.
+  long long seq;
+
+  // Dictionary the job runs against.
+  Snapshot *dict;
+
+  // Targets to crack, with their salt groups prepared.
+  TargetStore *store;
+  PreparedGroup *salts;
+
+  // Streams hits back to the client.
+  Results *results;
+
+  // Next tile of words to hand out, and the number of tiles.
+  long long nextTile;
+  long long tileCount;
+
+  // Workers hashing a tile of this job right now.
+  int busy;
+
+  // Kept back from the workers until the client knows the job's id.
+  bool held;
+
+  // Set once the job should stop being worked on.
+  bool cancelled;
+
+  // Set once no worker will touch the job again.
+  bool finished;
+
+  // Signalled when the job finishes.
+  pthread_cond_t finishedCond;
+
+  // Next job in the queue.
+  struct JobStruct *next;
+} Job;
+
+/** State shared by the daemon's threads. */
+typedef struct {
+  // Dictionary file, reloaded on request.
+  char const *dictName;
+  long long maxWords;
+
+  // Words per tile of work, and the number of workers.
+  int tileWords;
+  int threads;
+
+  // Listening socket.
+  int listenFd;
+
+  // Guards everything below.
+  pthread_mutex_t lock;
+
+  // Signalled when there may be new work, or the daemon is stopping.
+  pthread_cond_t work;
+
+  // Signalled when a client finishes a command.
+  pthread_cond_t idle;
+
+  // Dictionary new jobs run against.
+  Snapshot *dict;
+
+  // Queued and running jobs.
+  Job *jobs;
+  int nextId;
+  long long nextSeq;
+
+  // Clients in the middle of a command.
+  int busyClients;
+
+  // Set by SHUTDOWN.
+  bool stopping;
+} Server;
+
+/** Arguments handed to a client thread. */
+typedef struct {
+  Server *server;
+  int fd;
+} Client;
+
+/**
+ * The daemon's shared state.  It lives until the process exits, since
+ * idle client threads may still be waiting on it then.
+ */
+static Server server;
+
+/**
+ * Loads the dictionary file into a new snapshot.
+ * 
+ * @param name dictionary file name
+ * @param maxWords maximum number of words, 0 for no limit
+ * @param err where to store a description of any problem
+ * @return the snapshot, or NULL if the dictionary could not be loaded
+ */
+static Snapshot *loadSnapshot( char const *name, long long maxWords, char const **err )
+{
+  FILE *fp = fopen( name, "r" );
+  if ( fp == NULL ) {
+    *err = strerror( errno );
+    return NULL;
+  }
+
+  WordPool *pool = makeWordPool();
+  DictStatus status = loadDictionary( fp, pool, maxWords );
+  fclose( fp );
+
+  if ( status != DICT_OK ) {
+    *err = dictStatusMessage( status );
+    freeWordPool( pool );
+    return NULL;
+  }
+
+  Snapshot *snap = (Snapshot *)malloc( sizeof( Snapshot ) );
+  snap->pool = pool;
+  snap->refs = 1;
+  return snap;
+}
+
+/**
+ * Drops one reference to a snapshot, freeing it with the last one.
+ * Called with the server locked.
+ * 
+ * @param snap snapshot to release
+ */
+static void releaseSnapshot( Snapshot *snap )
+{
+  if ( --snap->refs == 0 ) {
+    freeWordPool( snap->pool );
+    free( snap );
+  }
+}
+
+/**
+ * Marks the job finished if no worker is on it and none will be.
+ * Called with the server locked.
+ * 
+ * @param job job to check
+ */
+static void checkFinished( Job *job )
+{
+  if ( !job->finished && job->busy == 0 &&
+       ( job->cancelled || job->nextTile >= job->tileCount ) ) {
+    job->finished = true;
+    pthread_cond_broadcast( &job->finishedCond );
+  }
+}
+
+/**
+ * Stops a job being worked on.  Workers already on one of its tiles
+ * stop at their next word.  Called with the server locked.
+ * 
+ * @param job job to stop
+ */
+static void stopJob( Job *job )
+{
+  __atomic_store_n( &job->cancelled, true, __ATOMIC_RELAXED );
+  checkFinished( job );
+}
+
+/**
+ * Reports whether the client of a job has gone away: writing to it
+ * has failed, or it has closed its end of the socket.  A client that
+ * has only finished sending, as --connect does once its input runs
+ * out, is still waiting for its answers.
+ * 
+ * @param out stream to the client
+ * @return true if nothing more can reach the client
+ */
+static bool clientGone( FILE *out )
+{
+  struct pollfd pfd = { fileno( out ), 0, 0 };
+  return ferror( out ) || ( poll( &pfd, 1, 0 ) > 0 && ( pfd.revents & ( POLLHUP | POLLERR ) ) );
+}
+
+/**
+ * Finds the job the next tile should come from: the one with the
+ * highest priority that still has tiles to hand out, oldest first.
+ * Called with the server locked.
+ * 
+ * @param srv the server
+ * @return the job, or NULL if there is no work
+ */
+static Job *pickJob( Server *srv )
+{
+  Job *best = NULL;
+
+  for ( Job *job = srv->jobs; job != NULL; job = job->next ) {
+    if ( job->held || job->cancelled || job->nextTile >= job->tileCount ) {
+      continue;
+    }
+    if ( best == NULL || job->priority > best->priority ||
+         ( job->priority == best->priority && job->seq < best->seq ) ) {
+      best = job;
+    }
+  }
+
+  return best;
+}
+
+/**
+ * Hashes one tile of dictionary words against every target of the
+ * job, streaming matches back to its client.  Stops early if the
+ * job is cancelled, and cancels it if a match can't be written.
+ * 
+ * @param srv the server
+ * @param job job the tile belongs to
+ * @param tile index of the tile
+ */
+static void crackTile( Server *srv, Job *job, long long tile )
+{
+  WordPool const *pool = job->dict->pool;
+  TargetStore const *store = job->store;
+  byte hash[ HASH_SIZE ];
+
+  long long start = tile * srv->tileWords;
+  long long end = start + srv->tileWords;
+  if ( end > pool->count ) {
+    end = pool->count;
+  }
+
+  for ( long long i = start; i < end; i++ ) {
+    if ( __atomic_load_n( &job->cancelled, __ATOMIC_RELAXED ) ) {
+      return;
+    }
+
+    PreparedWord pw = { pool->slots[ i ], pool->lens[ i ] };
+    for ( int g = 0; g < store->saltCount; g++ ) {
+      if ( !hashGroup( &job->salts[ g ], &pw, hash ) ) {
+        continue;
+      }
+
+      int k = store->groupStart[ g ];
+      while ( ( k = findInGroup( store, g, hash, k ) ) >= 0 ) {
+        addHit( job->results, store->order[ k ], i, pool->slots[ i ] );
+        if ( ferror( job->results->out ) ) {
+          // nobody is left to read the rest of the job
+          __atomic_store_n( &job->cancelled, true, __ATOMIC_RELAXED );
+        }
+        k++;
+      }
+    }
+  }
+}
+
+/**
+ * Worker thread body: hashes tiles of queued jobs until the daemon
+ * stops, sleeping while there is nothing to do.
+ * 
+ * @param id worker number
+ * @param ctx the server
+ */
+static void daemonWorker( int id, void *ctx )
+{
+  Server *srv = (Server *)ctx;
+
+  pthread_mutex_lock( &srv->lock );
+  while ( true ) {
+    Job *job = pickJob( srv );
+    if ( job == NULL ) {
+      if ( srv->stopping ) {
+        break;
+      }
+      pthread_cond_wait( &srv->work, &srv->lock );
+      continue;
+    }
+
+    long long tile = job->nextTile++;
+    job->busy++;
+    pthread_mutex_unlock( &srv->lock );
+
+    long long span = traceBegin();
+    crackTile( srv, job, tile );
+    traceEnd( "hash tile", span );
+    throttleWorker();
+
+    pthread_mutex_lock( &srv->lock );
+    job->busy--;
+    checkFinished( job );
+  }
+  pthread_mutex_unlock( &srv->lock );
+}
+
+/**
+ * Start routine for the thread that runs the worker pool.
+ * 
+ * @param arg the server
+ * @return always NULL
+ */
+static void *poolMain( void *arg )
+{
+  Server *srv = (Server *)arg;
+
+  runWorkers( srv->threads, daemonWorker, srv );
+  return NULL;
+}
+
+/**
+ * Reads the shadow lines of a JOB command, up to the line holding
+ * only ".", and parses them.
+ * 
+ * @param in stream from the client
+ * @return the targets, or NULL if there were none or one was invalid
+ */
+static TargetStore *readJobTargets( FILE *in )
+{
+  char *text = NULL;
+  size_t textLen = 0;
+  FILE *buf = open_memstream( &text, &textLen );
+
+  char *line = NULL;
+  size_t cap = 0;
+  while ( getline( &line, &cap, in ) > 0 && strcmp( line, JOB_END ) != 0 ) {
+    fputs( line, buf );
+  }
+  free( line );
+  fclose( buf );
+
+  TargetStore *store = NULL;
+  if ( textLen > 0 ) {
+    FILE *fp = fmemopen( text, textLen, "r" );
+    store = parseShadowFile( fp );
+    fclose( fp );
+  }
+
+  free( text );
+  return store;
+}
+
+/**
+ * Queues a job for the given targets and waits for it to finish,
+ * telling the client its id first and how it ended last.  The job
+ * is cancelled if the client hangs up while waiting.
+ * 
+ * @param srv the server
+ * @param out stream to the client
+ * @param priority priority of the job
+ * @param store targets to crack; freed here
+ */
+static void runJob( Server *srv, FILE *out, int priority, TargetStore *store )
+{
+  Job *job = (Job *)calloc( 1, sizeof( Job ) );
+  job->priority = priority;
+  job->store = store;
+  job->salts = prepareGroups( store );
+  job->results = makeResults( store, true );
+  job->results->out = out;
+  job->held = true;
+  pthread_cond_init( &job->finishedCond, NULL );
+
+  pthread_mutex_lock( &srv->lock );
+  job->id = srv->nextId++;
+  job->seq = srv->nextSeq++;
+  job->dict = srv->dict;
+  job->dict->refs++;
+  job->tileCount = ( job->dict->pool->count + srv->tileWords - 1 ) / srv->tileWords;
+  job->cancelled = srv->stopping;
+  job->next = srv->jobs;
+  srv->jobs = job;
+  pthread_mutex_unlock( &srv->lock );
+
+  // the client has the id before any hit, and can cancel from then on
+  fprintf( out, "QUEUED %d\n", job->id );
+  fflush( out );
+
+  pthread_mutex_lock( &srv->lock );
+  job->held = false;
+  pthread_cond_broadcast( &srv->work );
+  checkFinished( job );
+  while ( !job->finished ) {
+    struct timespec deadline;
+    clock_gettime( CLOCK_REALTIME, &deadline );
+    deadline.tv_nsec += HANGUP_POLL_MS * NS_PER_MS;
+    if ( deadline.tv_nsec >= NS_PER_SEC ) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= NS_PER_SEC;
+    }
+
+    if ( pthread_cond_timedwait( &job->finishedCond, &srv->lock, &deadline ) == ETIMEDOUT &&
+         !job->cancelled && clientGone( out ) ) {
+      stopJob( job );
+    }
+  }
+
+  Job **link = &srv->jobs;
+  while ( *link != job ) {
+    link = &( *link )->next;
+  }
+  *link = job->next;
+  releaseSnapshot( job->dict );
+  pthread_mutex_unlock( &srv->lock );
+
+  fprintf( out, "%s %d\n", job->cancelled ? "CANCELLED" : "DONE", job->id );
+
+  pthread_cond_destroy( &job->finishedCond );
+  freeResults( job->results );
+  freeGroups( job->salts, job->store->saltCount );
+  freeTargets( job->store );
+  free( job );
+}
+
+/**
+ * Cancels the job with the given id.
+ * 
+ * @param srv the server
+ * @param id id of the job
+ * @return true if the job was queued or running
+ */
+static bool cancelJob( Server *srv, int id )
+{
+  bool found = false;
+
+  pthread_mutex_lock( &srv->lock );
+  for ( Job *job = srv->jobs; job != NULL; job = job->next ) {
+    if ( job->id == id && !job->finished && !job->cancelled ) {
+      stopJob( job );
+      found = true;
+    }
+  }
+  pthread_mutex_unlock( &srv->lock );
+
+  return found;
+}
+
+/**
+ * Loads the dictionary file again, so that new jobs use the new
+ * words.  Jobs already queued keep the words they started with.
+ * 
+ * @param srv the server
+ * @param out stream to the client
+ */
+static void reloadDictionary( Server *srv, FILE *out )
+{
+  char const *err = NULL;
+  Snapshot *snap = loadSnapshot( srv->dictName, srv->maxWords, &err );
+  if ( snap == NULL ) {
+    fprintf( out, "ERROR %s\n", err );
+    return;
+  }
+
+  pthread_mutex_lock( &srv->lock );
+  Snapshot *old = srv->dict;
+  srv->dict = snap;
+  releaseSnapshot( old );
+  pthread_mutex_unlock( &srv->lock );
+
+  fprintf( out, "RELOADED %lld\n", snap->pool->count );
+}
+
+/**
+ * Cancels every job and stops the workers and the listening socket.
+ * 
+ * @param srv the server
+ */
+static void stopServer( Server *srv )
+{
+  pthread_mutex_lock( &srv->lock );
+  srv->stopping = true;
+  for ( Job *job = srv->jobs; job != NULL; job = job->next ) {
+    stopJob( job );
+  }
+  pthread_cond_broadcast( &srv->work );
+  pthread_mutex_unlock( &srv->lock );
+
+  // wakes the accept() in runDaemon()
+  shutdown( srv->listenFd, SHUT_RDWR );
+}
+
+/**
+ * Carries out one command from a client.
+ * 
+ * @param srv the server
+ * @param line the command, without its newline
+ * @param in stream from the client
+ * @param out stream to the client
+ * @return false if the client asked the daemon to shut down
+ */
+static bool runCommand( Server *srv, char *line, FILE *in, FILE *out )
+{
+  int priority, id, pathStart = 0;
+
+  if ( sscanf( line, "JOB %d", &priority ) == 1 ) {
+    TargetStore *store = readJobTargets( in );
+    if ( store == NULL ) {
+      fprintf( out, "ERROR Invalid shadow file entry\n" );
+    } else {
+      runJob( srv, out, priority, store );
+    }
+  } else if ( sscanf( line, "FILE %d %n", &priority, &pathStart ) == 1 && pathStart > 0 ) {
+    FILE *fp = fopen( line + pathStart, "r" );
+    if ( fp == NULL ) {
+      fprintf( out, "ERROR %s: %s\n", line + pathStart, strerror( errno ) );
+      return true;
+    }
+
+    TargetStore *store = parseShadowFile( fp );
+    fclose( fp );
+    if ( store == NULL ) {
+      fprintf( out, "ERROR Invalid shadow file entry\n" );
+    } else {
+      runJob( srv, out, priority, store );
+    }
+  } else if ( sscanf( line, "CANCEL %d", &id ) == 1 ) {
+    fprintf( out, cancelJob( srv, id ) ? "OK\n" : "UNKNOWN\n" );
+  } else if ( strcmp( line, "RELOAD" ) == 0 ) {
+    reloadDictionary( srv, out );
+  } else if ( strcmp( line, "SHUTDOWN" ) == 0 ) {
+    stopServer( srv );
+    fprintf( out, "OK\n" );
+    return false;
+  } else {
+    fprintf( out, "ERROR Unknown command\n" );
+  }
+
+  return true;
+}
+
+/**
+ * Client thread body: carries out the client's commands until it
+ * hangs up or the daemon stops.
+ * 
+ * @param arg the thread's Client, freed here
+ * @return always NULL
+ */
+static void *clientMain( void *arg )
+{
+  Client *client = (Client *)arg;
+  Server *srv = client->server;
+  FILE *in = fdopen( client->fd, "r" );
+  FILE *out = fdopen( dup( client->fd ), "w" );
+  free( client );
+
+  char *line = NULL;
+  size_t cap = 0;
+  ssize_t len;
+  bool more = true;
+
+  while ( more && ( len = getline( &line, &cap, in ) ) > 0 ) {
+    if ( line[ len - 1 ] == '\n' ) {
+      line[ len - 1 ] = '\0';
+    }
+
+    pthread_mutex_lock( &srv->lock );
+    if ( srv->stopping ) {
+      pthread_mutex_unlock( &srv->lock );
+      break;
+    }
+    srv->busyClients++;
+    pthread_mutex_unlock( &srv->lock );
+
+    more = runCommand( srv, line, in, out );
+    fflush( out );
+
+    pthread_mutex_lock( &srv->lock );
+    srv->busyClients--;
+    pthread_cond_broadcast( &srv->idle );
+    pthread_mutex_unlock( &srv->lock );
+  }
+
+  free( line );
+  fclose( out );
+  fclose( in );
+  return NULL;
+}
+
+/**
+ * Fills in the address of the named UNIX socket.
+ * 
+ * @param name socket path
+ * @param addr address to fill in
+ */
+static void socketAddress( char const *name, struct sockaddr_un *addr )
+{
+  if ( strlen( name ) >= sizeof( addr->sun_path ) ) {
+    fprintf( stderr, "Socket name too long\n" );
+    exit( EXIT_FAILURE );
+  }
+
+  memset( addr, 0, sizeof( struct sockaddr_un ) );
+  addr->sun_family = AF_UNIX;
+  strcpy( addr->sun_path, name );
+}
+
+/**
+ * Creates a listening socket at the given path.  A socket file left
+ * behind by a daemon that is no longer running is replaced.
+ * 
+ * @param name socket path
+ * @return the listening socket
+ */
+static int listenOn( char const *name )
+{
+  struct sockaddr_un addr;
+  socketAddress( name, &addr );
+
+  int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+  if ( fd < 0 ) {
+    perror( "socket" );
+    exit( EXIT_FAILURE );
+  }
+
+  if ( bind( fd, (struct sockaddr *)&addr, sizeof( addr ) ) != 0 && errno == EADDRINUSE ) {
+    int probe = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( connect( probe, (struct sockaddr *)&addr, sizeof( addr ) ) == 0 ) {
+      fprintf( stderr, "A daemon is already running on %s\n", name );
+      exit( EXIT_FAILURE );
+    }
+    close( probe );
+
+    unlink( name );
+    if ( bind( fd, (struct sockaddr *)&addr, sizeof( addr ) ) != 0 ) {
+      perror( name );
+      exit( EXIT_FAILURE );
+    }
+  }
+
+  if ( listen( fd, DAEMON_BACKLOG ) != 0 ) {
+    perror( name );
+    exit( EXIT_FAILURE );
+  }
+
+  return fd;
+}
+
+/**
+ * Loads the dictionary once and serves cracking jobs on a UNIX
+ * socket until told to shut down.  A warm pool of workers takes
+ * tiles of dictionary words from whichever queued job has the
+ * highest priority, oldest first among equals.  Each job keeps the
+ * dictionary it started with, so a reload never disturbs jobs
+ * already running.
+ * 
+ * Clients send one command per line:
+ *   JOB PRI        followed by shadow lines and a line holding "."
+ *   FILE PRI PATH  crack the shadow file at PATH
+ *   CANCEL ID      stop a queued or running job
+ *   RELOAD         read the dictionary file again
+ *   SHUTDOWN       cancel every job and stop the daemon
+ * A job is answered with "QUEUED ID", a "name : password" line for
+ * every password found, then "DONE ID" or "CANCELLED ID".  Problems
+ * are answered with a line starting "ERROR".  A job whose client
+ * hangs up before it is done is cancelled.
+ * 
+ * @param opts options naming the socket and dictionary
+ */
+void runDaemon( Options const *opts )
+{
+  Server *srv = &server;
+
+  // a client hanging up mid-job must not take the daemon with it
+  signal( SIGPIPE, SIG_IGN );
+
+  srv->dictName = opts->dictName;
+  srv->maxWords = opts->maxWords;
+  srv->tileWords = opts->tileWords;
+  srv->threads = workerCount( opts->threads );
+
+  char const *err = NULL;
+  srv->dict = loadSnapshot( srv->dictName, srv->maxWords, &err );
+  if ( srv->dict == NULL ) {
+    fprintf( stderr, "%s: %s\n", srv->dictName, err );
+    exit( EXIT_FAILURE );
+  }
+
+  pthread_mutex_init( &srv->lock, NULL );
+  pthread_cond_init( &srv->work, NULL );
+  pthread_cond_init( &srv->idle, NULL );
+  srv->listenFd = listenOn( opts->daemonName );
+
+  pthread_t pool;
+  if ( pthread_create( &pool, NULL, poolMain, srv ) != 0 ) {
+    perror( "pthread_create" );
+    exit( EXIT_FAILURE );
+  }
+
+  while ( true ) {
+    int fd = accept( srv->listenFd, NULL, NULL );
+    if ( fd < 0 ) {
+      if ( errno == EINTR || errno == ECONNABORTED ) {
+        continue;
+      }
+      break;
+    }
+
+    Client *client = (Client *)malloc( sizeof( Client ) );
+    client->server = srv;
+    client->fd = fd;
+
+    pthread_t thread;
+    if ( pthread_create( &thread, NULL, clientMain, client ) != 0 ) {
+      perror( "pthread_create" );
+      exit( EXIT_FAILURE );
+    }
+    pthread_detach( thread );
+  }
+
+  pthread_join( pool, NULL );
+
+  // let clients finish reporting how their jobs ended
+  pthread_mutex_lock( &srv->lock );
+  while ( srv->busyClients > 0 ) {
+    pthread_cond_wait( &srv->idle, &srv->lock );
+  }
+  pthread_mutex_unlock( &srv->lock );
+
+  close( srv->listenFd );
+  unlink( opts->daemonName );
+}
+
+/**
+ * Start routine for the thread that sends standard input to the
+ * daemon, then tells it nothing more is coming.
+ * 
+ * @param arg pointer to the socket
+ * @return always NULL
+ */
+static void *sendMain( void *arg )
+{
+  int fd = *(int *)arg;
+  char buf[ COPY_BUFFER ];
+  size_t len;
+
+  while ( ( len = fread( buf, 1, sizeof( buf ), stdin ) ) > 0 ) {
+    if ( write( fd, buf, len ) != (ssize_t) len ) {
+      break;
+    }
+  }
+
+  shutdown( fd, SHUT_WR );
+  return NULL;
+}
+
+/**
+ * Connects to the daemon at the socket named in the options, sends
+ * it all of standard input and copies what it sends back to
+ * standard output.
+ * 
+ * @param opts options naming the socket
+ */
+void connectDaemon( Options const *opts )
+{
+  struct sockaddr_un addr;
+  socketAddress( opts->connectName, &addr );
+
+  int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+  if ( fd < 0 || connect( fd, (struct sockaddr *)&addr, sizeof( addr ) ) != 0 ) {
+    perror( opts->connectName );
+    exit( EXIT_FAILURE );
+  }
+
+  pthread_t sender;
+  if ( pthread_create( &sender, NULL, sendMain, &fd ) != 0 ) {
+    perror( "pthread_create" );
+    exit( EXIT_FAILURE );
+  }
+
+  char buf[ COPY_BUFFER ];
+  ssize_t len;
+  while ( ( len = read( fd, buf, sizeof( buf ) ) ) > 0 ) {
+    fwrite( buf, 1, len, stdout );
+    fflush( stdout );
+  }
+
+  // the daemon has hung up, so anything left unsent is not wanted
+  close( fd );
+}
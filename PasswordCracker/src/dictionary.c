@@ -0,0 +1,182 @@
+/**
+ * @file dictionary.c
+ * @author Luke Early
+ * Reads candidate passwords from a dictionary file.
+ */
+
+#include "dictionary.h"
+#include "password.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+
+/** initial capacity of a resizable string */
+#define INIT_STR_CAP 5
+
+/** factor by which to resize things that are resizeable */
+#define RESIZE_FACTOR 2
+
+/**
+ * Opens the named dictionary file for reading.  The name "-"
+ * selects standard input, so a generator can be piped straight
+ * into the program.
+ * 
+ * @param name dictionary file name, or "-" for standard input
+ * @return open stream, or NULL if the file could not be opened
+ */
+FILE *openDictionary( char const *name )
+{
+  if ( strcmp( name, STDIN_DICT_NAME ) == 0 ) {
+    return stdin;
+  }
+
+  return fopen( name, "r" );
+}
+
+/**
+ * Reads in a single line of input from dictionary file stream.
+ * 
+ * Stores it in str param.  At the end of the dictionary, str is
+ * set to the empty string.
+ * 
+ * @param fp pointer to input stream
+ * @param str string to store it in
+ * @return false if the line is not a valid dictionary word
+ */
+bool readDictWord( FILE *fp, char *str )
+{
+  int count = 0;
+  int capacity = INIT_STR_CAP;
+  char *dictStr = malloc( INIT_STR_CAP * sizeof( char ) );
+  
+  char currChar;
+  
+  while ( fscanf( fp, "%c", &currChar ) == 1 ) {
+    if ( isspace( currChar ) && currChar != '\n' ) {
+      free( dictStr );
+      return false;
+    }
+
+    if ( isspace( currChar ) && currChar == '\n' ) {
+      break;
+    }
+
+    // resize string array if exceeds capacity
+    if ( count + 1 >= capacity ) {
+      capacity *= RESIZE_FACTOR;
+      dictStr = realloc( dictStr, capacity*sizeof( char ) );
+    } 
+
+    dictStr[ count ] = currChar;
+    count++;
+  }
+
+  if ( feof( fp ) ) {
+    free( dictStr );
+    dictStr = NULL;
+    count = 0;
+  }
+
+  if ( count > 0 ) {
+    dictStr[ count ] = '\0';
+  }
+
+  if ( count > PW_LIMIT ) {
+    free( dictStr );
+    return false;
+  }
+
+  if ( dictStr == NULL ) {
+    strcpy( str, "" );
+  } else {
+    if ( count == 0 ) {
+      dictStr[ 0 ] = '\0';
+    }
+    strcpy( str, dictStr );
+    free( dictStr );
+  }
+
+  return true;
+}
+
+/**
+ * Reads in a single line of input from dictionary file stream.
+ * 
+ * Stores it in str param.  At the end of the dictionary, str is
+ * set to the empty string.
+ * 
+ * @param fp pointer to input stream
+ * @param str string to store it in
+ */
+void readDictLine( FILE *fp, char *str )
+{
+  if ( !readDictWord( fp, str ) ) {
+    fprintf( stderr, "Invalid dictionary word\n" );
+    exit( EXIT_FAILURE );
+  }
+}
+
+/**
+ * Loads every word of the dictionary into the given pool, stopping
+ * at the first problem.
+ * 
+ * @param fp pointer to input stream
+ * @param pool pool to add the words to
+ * @param limit maximum number of words, 0 for no limit
+ * @return DICT_OK, or what was wrong with the dictionary
+ */
+DictStatus loadDictionary( FILE *fp, WordPool *pool, long long limit )
+{
+  Password dictLine;
+  if ( !readDictWord( fp, dictLine ) ) {
+    return DICT_INVALID_WORD;
+  }
+
+  while ( strcmp( dictLine, "" ) != 0 ) {
+    appendWord( pool, dictLine );
+    if ( limit > 0 && pool->count > limit ) {
+      return DICT_TOO_MANY;
+    }
+
+    if ( !readDictWord( fp, dictLine ) ) {
+      return DICT_INVALID_WORD;
+    }
+  }
+
+  return DICT_OK;
+}
+
+/**
+ * Reads every word of the dictionary into the given pool.  If there
+ * are more than limit words, exit unsuccessfully.
+ * 
+ * @param fp pointer to input stream
+ * @param pool pool to add the words to
+ * @param limit maximum number of words, 0 for no limit
+ */
+void readDictionary( FILE *fp, WordPool *pool, long long limit )
+{
+  DictStatus status = loadDictionary( fp, pool, limit );
+  if ( status != DICT_OK ) {
+    fprintf( stderr, "%s\n", dictStatusMessage( status ) );
+    exit( EXIT_FAILURE );
+  }
+}
+
+/**
+ * Describes a problem reported by loadDictionary().
+ * 
+ * @param status status to describe
+ * @return message for the user
+ */
+char const *dictStatusMessage( DictStatus status )
+{
+  if ( status == DICT_TOO_MANY ) {
+    return "Too many dictionary words";
+  }
+  if ( status == DICT_INVALID_WORD ) {
+    return "Invalid dictionary word";
+  }
+  return "OK";
+}
@@ -0,0 +1,396 @@
+/**
+ * @file engine.c
+ * @author Luke Early
+ * Schedules the hashing of a keyspace of candidates against the
+ * targets.
+ * 
+ * Going target by target rereads every candidate once per target;
+ * going candidate by candidate redoes the setup for every salt on
+ * every candidate.  Instead the work is cut into tiles: a run of
+ * candidates crossed with a run of salt groups.  A worker produces
+ * and prepares the tile's candidates once, then hashes them against
+ * each of the tile's salts while all of it is still in cache.
+ * 
+ * The keyspace can also be run in tiers, for when the candidates
+ * come most likely first.  Every salt group sees all of one tier
+ * before any of the next, and once every account in a group is
+ * cracked, the group is dropped, so an account with a common
+ * password is found early no matter where it sits in the shadow
+ * file.
+ */
+
+#include "engine.h"
+#include "workers.h"
+#include "batch.h"
+#include "bloom.h"
+#include "policy.h"
+#include "groups.h"
+#include "numa.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** State shared by the workers cracking a keyspace. */
+typedef struct {
+  Keyspace const *ks;
+  TargetStore const *store;
+  Results *results;
+  Stats *stats;
+
+  // Policy candidates must meet, or NULL to try them all.
+  Policy const *policy;
+
+  // Candidates tried so far, or NULL to try repeats again.
+  BloomFilter *filter;
+
+  // Which targets to report, or NULL for all of them.
+  bool const *only;
+
+  // Salt groups prepared once for the whole run.
+  PreparedGroup *salts;
+
+  // With NUMA placement, a copy of the salt groups and of the digests
+  // on each node; otherwise NULL.
+  int nodeCount;
+  PreparedGroup **nodeSalts;
+  TargetStore **nodeStores;
+
+  // Tile shape, and the number of tiles along each side of the current tier.
+  int tileWords;
+  int tileSalts;
+  long long wordTiles;
+  long long saltTiles;
+
+  // Keyspace positions of the current tier.
+  long long tierStart;
+  long long tierEnd;
+
+  // Salt groups still being cracked.
+  int *active;
+  int activeCount;
+
+  // When running in tiers, whether each target is cracked, and
+  // the number of targets left in each group; otherwise NULL.
+  bool *cracked;
+  int *groupLeft;
+
+  // Index of the next tile of the tier to hand out.
+  long long nextTile;
+} Engine;
+
+/**
+ * Reports a cracked target.  When running in tiers, only the first
+ * password found for a target is reported, and the target's group
+ * is marked done once its last target is cracked.
+ * 
+ * @param eng the shared Engine
+ * @param group salt group of the target
+ * @param target index of the target
+ * @param word keyspace position of the password
+ * @param pass the password
+ */
+static void reportHit( Engine *eng, int group, int target, long long word, char const *pass )
+{
+  if ( eng->only != NULL && !eng->only[ target ] ) {
+    return;
+  }
+
+  if ( eng->cracked == NULL ) {
+    addHit( eng->results, target, word, pass );
+  } else if ( !__atomic_exchange_n( &eng->cracked[ target ], true, __ATOMIC_RELAXED ) ) {
+    addHit( eng->results, target, word, pass );
+    __atomic_sub_fetch( &eng->groupLeft[ group ], 1, __ATOMIC_RELAXED );
+  }
+}
+
+/**
+ * Hashes every candidate of one tile against every salt group of it.
+ * 
+ * @param eng the shared Engine
+ * @param node NUMA node the worker runs on, 0 without NUMA placement
+ * @param tile index of the tile
+ * @param batch this worker's buffer for tileWords candidates
+ * @param words this worker's buffer for tileWords prepared candidates
+ * @param digests this worker's buffer for tileWords hashes
+ */
+static void crackTile( Engine *eng, int node, long long tile, Batch *batch, PreparedWord *words,
+                       byte digests[][ HASH_SIZE ] )
+{
+  TargetStore const *store = eng->nodeStores != NULL ? eng->nodeStores[ node ] : eng->store;
+  PreparedGroup const *salts = eng->nodeSalts != NULL ? eng->nodeSalts[ node ] : eng->salts;
+
+  long long w0 = eng->tierStart + ( tile / eng->saltTiles ) * eng->tileWords;
+  long long w1 = w0 + eng->tileWords < eng->tierEnd ? w0 + eng->tileWords : eng->tierEnd;
+  int a0 = ( tile % eng->saltTiles ) * eng->tileSalts;
+  int a1 = a0 + eng->tileSalts < eng->activeCount ? a0 + eng->tileSalts : eng->activeCount;
+
+  /**
+   * Produce and prepare the tile's candidates
+   */
+  long long span = traceBegin();
+  batch->count = 0;
+  eng->ks->fill( eng->ks, w0, w1, batch );
+  if ( a0 == 0 ) {
+    countStat( &eng->stats->candidates, batch->count );
+  }
+
+  if ( eng->policy != NULL ) {
+    int rejected = dropViolations( eng->policy, batch );
+    if ( a0 == 0 ) {
+      countStat( &eng->stats->violations, rejected );
+    }
+  }
+
+  // with a filter, tiles span every salt group, so each candidate is checked once
+  if ( eng->filter != NULL ) {
+    countStat( &eng->stats->repeats, dropRepeats( eng->filter, batch ) );
+  }
+
+  for ( int i = 0; i < batch->count; i++ ) {
+    words[ i ].str = batch->words[ i ];
+    words[ i ].len = batch->lens[ i ];
+  }
+  traceEnd( "fill tile", span );
+
+  /**
+   * Hash every candidate against every salt
+   */
+  span = traceBegin();
+  long long hashes = 0;
+  for ( int a = a0; a < a1; a++ ) {
+    int g = eng->active[ a ];
+    bool batched = hashGroupBatch( &salts[ g ], words, batch->count, digests );
+
+    for ( int i = 0; i < batch->count; i++ ) {
+      // the group may have been finished off during this tier
+      if ( eng->groupLeft != NULL && __atomic_load_n( &eng->groupLeft[ g ], __ATOMIC_RELAXED ) == 0 ) {
+        break;
+      }
+
+      byte *hash = digests[ i ];
+      hashes++;
+      if ( !batched && !hashGroup( &salts[ g ], &words[ i ], hash ) ) {
+        continue;
+      }
+
+      int k = store->groupStart[ g ];
+      while ( ( k = findInGroup( store, g, hash, k ) ) >= 0 ) {
+        reportHit( eng, g, store->order[ k ], batch->index[ i ], batch->words[ i ] );
+        k++;
+      }
+    }
+  }
+
+  traceEnd( "hash tile", span );
+
+  countStat( &eng->stats->hashes, hashes );
+  if ( eng->nodeCount > 0 ) {
+    countStat( &eng->stats->nodeHashes[ node ], hashes );
+  }
+}
+
+/**
+ * Worker thread body: takes tiles until there are none left.  The
+ * worker's buffers are allocated and first touched here, on the
+ * worker's own node.
+ * 
+ * @param id worker number
+ * @param ctx the shared Engine
+ */
+static void tileWorker( int id, void *ctx )
+{
+  Engine *eng = (Engine *)ctx;
+  int node = eng->nodeCount > 0 ? currentNode() : 0;
+  long long total = eng->wordTiles * eng->saltTiles;
+  Batch *batch = makeBatch( eng->tileWords );
+  PreparedWord *words = (PreparedWord *)malloc( eng->tileWords * sizeof( PreparedWord ) );
+  byte (*digests)[ HASH_SIZE ] = malloc( eng->tileWords * sizeof( *digests ) );
+
+  long long tile;
+  while ( ( tile = __atomic_fetch_add( &eng->nextTile, 1, __ATOMIC_RELAXED ) ) < total ) {
+    crackTile( eng, node, tile, batch, words, digests );
+    throttleWorker();
+  }
+
+  free( digests );
+  free( words );
+  freeBatch( batch );
+}
+
+/**
+ * Worker thread body: copies the salt groups and digests onto one
+ * NUMA node, from a thread bound to it.
+ * 
+ * @param id index of the node
+ * @param ctx the shared Engine
+ */
+static void replicaWorker( int id, void *ctx )
+{
+  Engine *eng = (Engine *)ctx;
+
+  bindToNode( id );
+  eng->nodeSalts[ id ] = copyGroups( eng->salts, eng->store->saltCount );
+  eng->nodeStores[ id ] = copyDigestIndex( eng->store );
+}
+
+/**
+ * Runs one tier of the keyspace against every salt group still
+ * active, and waits for it to finish.
+ * 
+ * @param eng the shared Engine
+ * @param start first keyspace position of the tier
+ * @param end keyspace position after the tier
+ */
+static void runTier( Engine *eng, long long start, long long end )
+{
+  Stats *stats = eng->stats;
+
+  eng->tierStart = start;
+  eng->tierEnd = end;
+  eng->wordTiles = ( end - start + eng->tileWords - 1 ) / eng->tileWords;
+  eng->saltTiles = ( eng->activeCount + eng->tileSalts - 1 ) / eng->tileSalts;
+  eng->nextTile = 0;
+
+  stats->tiles += eng->wordTiles * eng->saltTiles;
+  runWorkers( stats->threads, tileWorker, eng );
+}
+
+/**
+ * Cracks the given targets with every candidate of a keyspace.
+ * 
+ * The candidates x salt groups work is cut into tiles of
+ * opts->tileWords candidates by opts->tileSalts salt groups, which
+ * the workers take in turn.  Within a tile, the prepared candidates
+ * and salts stay in cache while every pair of them is hashed.
+ * 
+ * With opts->tierCount tiers, the keyspace is run in pieces of the
+ * given sizes, plus one for whatever is left.  Each tier finishes
+ * against every salt group before the next starts, each target is
+ * reported once, and fully cracked groups are dropped between tiers.
+ * 
+ * Given only some of the targets, salt groups without any are skipped
+ * and hits on the rest aren't reported.
+ * 
+ * Candidates that break the policy are dropped first.  With a
+ * filter, candidates seen before are dropped next.
+ * Each tile then spans every salt group, so that every candidate
+ * goes through the filter just once.
+ * 
+ * @param ks candidate passwords
+ * @param store targets to crack
+ * @param only which targets to crack, or NULL for all of them
+ * @param results where matches are reported
+ * @param policy policy candidates must meet, or NULL to try them all
+ * @param filter candidates tried so far, or NULL to hash repeats too
+ * @param opts settings for the run
+ * @param stats counters for the run
+ */
+void crackKeyspace( Keyspace const *ks, TargetStore const *store, bool const *only,
+                    Results *results, Policy const *policy, BloomFilter *filter,
+                    Options const *opts, Stats *stats )
+{
+  Engine eng;
+
+  eng.ks = ks;
+  eng.store = store;
+  eng.results = results;
+  eng.stats = stats;
+  eng.tileWords = opts->tileWords;
+  eng.tileSalts = opts->tileSalts;
+  eng.filter = filter;
+  eng.policy = policy;
+  if ( filter != NULL ) {
+    eng.tileSalts = store->saltCount > 0 ? store->saltCount : 1;
+  }
+
+  eng.salts = prepareGroups( store );
+
+  /**
+   * Give every NUMA node its own copy of what each hash reads
+   */
+  NumaTopology const *numa = numaTopology();
+  eng.nodeCount = 0;
+  eng.nodeSalts = NULL;
+  eng.nodeStores = NULL;
+  if ( numa != NULL ) {
+    eng.nodeCount = numa->count;
+    eng.nodeSalts = (PreparedGroup **)malloc( numa->count * sizeof( PreparedGroup * ) );
+    eng.nodeStores = (TargetStore **)malloc( numa->count * sizeof( TargetStore * ) );
+    runWorkers( numa->count, replicaWorker, &eng );
+
+    stats->nodes = numa->count;
+    memcpy( stats->nodeIds, numa->ids, numa->count * sizeof( int ) );
+  }
+  eng.active = (int *)malloc( ( store->saltCount + 1 ) * sizeof( int ) );
+  eng.activeCount = 0;
+  eng.only = only;
+  for ( int g = 0; g < store->saltCount; g++ ) {
+    // leave out groups without any of the targets wanted
+    bool wanted = only == NULL;
+    for ( int k = store->groupStart[ g ]; k < store->groupStart[ g + 1 ] && !wanted; k++ ) {
+      wanted = only[ store->order[ k ] ];
+    }
+    if ( wanted ) {
+      eng.active[ eng.activeCount++ ] = g;
+    }
+  }
+
+  stats->threads = workerCount( opts->threads );
+  stats->tileWords = eng.tileWords;
+  stats->tileSalts = eng.tileSalts;
+  stats->dedupe = filter != NULL;
+  stats->policy = policy != NULL;
+
+  if ( opts->tierCount == 0 ) {
+    eng.cracked = NULL;
+    eng.groupLeft = NULL;
+    runTier( &eng, 0, ks->size );
+  } else {
+    /**
+     * Track what's left to crack, so finished groups can be dropped
+     */
+    eng.cracked = (bool *)calloc( store->count + 1, sizeof( bool ) );
+    eng.groupLeft = (int *)malloc( ( store->saltCount + 1 ) * sizeof( int ) );
+    for ( int g = 0; g < store->saltCount; g++ ) {
+      eng.groupLeft[ g ] = 0;
+      for ( int k = store->groupStart[ g ]; k < store->groupStart[ g + 1 ]; k++ ) {
+        eng.groupLeft[ g ] += only == NULL || only[ store->order[ k ] ];
+      }
+    }
+
+    long long start = 0;
+    for ( int t = 0; t <= opts->tierCount && start < ks->size && eng.activeCount > 0; t++ ) {
+      long long end = ks->size;
+      if ( t < opts->tierCount && opts->tiers[ t ] < ks->size - start ) {
+        end = start + opts->tiers[ t ];
+      }
+
+      runTier( &eng, start, end );
+      stats->tiers++;
+      start = end;
+
+      int kept = 0;
+      for ( int a = 0; a < eng.activeCount; a++ ) {
+        if ( eng.groupLeft[ eng.active[ a ] ] > 0 ) {
+          eng.active[ kept++ ] = eng.active[ a ];
+        }
+      }
+      stats->groupsDone += eng.activeCount - kept;
+      eng.activeCount = kept;
+    }
+
+    free( eng.cracked );
+    free( eng.groupLeft );
+  }
+
+  for ( int n = 0; n < eng.nodeCount; n++ ) {
+    freeGroups( eng.nodeSalts[ n ], store->saltCount );
+    freeDigestIndex( eng.nodeStores[ n ] );
+  }
+  free( eng.nodeSalts );
+  free( eng.nodeStores );
+
+  free( eng.active );
+  freeGroups( eng.salts, store->saltCount );
+}
@@ -0,0 +1,40 @@
+/**
+ * @file fileutil.c
+ * @author Luke Early
+ * Helpers for the files the cracker keeps between runs.
+ */
+
+#include "fileutil.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Replaces the named file with what the writer produces.  The new
+ * contents go to the name plus TEMP_SUFFIX, which is renamed over
+ * the old file only once it is complete, so a failed or interrupted
+ * write leaves the old file as it was.
+ * 
+ * @param name name of the file to replace
+ * @param write function writing the new contents
+ * @param ctx passed to write
+ * @return true if the file was replaced
+ */
+bool replaceFile( char const *name, FileWriter write, void const *ctx )
+{
+  char *temp = (char *)malloc( strlen( name ) + sizeof( TEMP_SUFFIX ) );
+  strcpy( temp, name );
+  strcat( temp, TEMP_SUFFIX );
+
+  bool ok = false;
+  FILE *fp = fopen( temp, "wb" );
+  if ( fp != NULL ) {
+    ok = write( fp, ctx );
+    ok = fclose( fp ) == 0 && ok && rename( temp, name ) == 0;
+    if ( !ok ) {
+      remove( temp );
+    }
+  }
+
+  free( temp );
+  return ok;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file groups.c
+ * @author Luke Early
+ * Prepares salt groups for cracking and hashes candidates with them,
+ * whatever format the group's targets use.
+ */
+
+#include "groups.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Prepares every salt group of a store for cracking.
+ * 
+ * @param store targets, finished
+ * @return array of prepared groups, one for each salt group
+ */
+PreparedGroup *prepareGroups( TargetStore const *store )
+{
+  PreparedGroup *groups = (PreparedGroup *)malloc( ( store->saltCount + 1 ) * sizeof( PreparedGroup ) );
+
+  for ( int g = 0; g < store->saltCount; g++ ) {
+    groups[ g ].format = store->saltFormats[ g ];
+    if ( groups[ g ].format == FORMAT_RAW_MD5 ) {
+      prepareRawSalt( &groups[ g ].raw, store, g );
+    } else if ( groups[ g ].format != FORMAT_MD5CRYPT ) {
+      parseShaSetting( &groups[ g ].sha, shaDigestLength( groups[ g ].format ), store->salts[ g ] );
+    } else {
+      prepareSalt( &groups[ g ].crypt, store->salts[ g ] );
+    }
+  }
+
+  return groups;
+}
+
+/**
+ * Copies an array of prepared groups, with everything they point to.
+ * Memory is first touched by the calling thread.
+ * 
+ * @param groups the prepared groups
+ * @param count number of groups
+ * @return the copy, to be freed with freeGroups()
+ */
+PreparedGroup *copyGroups( PreparedGroup const *groups, int count )
+{
+  PreparedGroup *copy = (PreparedGroup *)malloc( ( count + 1 ) * sizeof( PreparedGroup ) );
+  memcpy( copy, groups, count * sizeof( PreparedGroup ) );
+
+  for ( int g = 0; g < count; g++ ) {
+    if ( groups[ g ].format == FORMAT_RAW_MD5 ) {
+      RawSalt const *rs = &groups[ g ].raw;
+      copy[ g ].raw.checks = (word *)malloc( ( rs->checkCount + 1 ) * sizeof( word ) );
+      memcpy( copy[ g ].raw.checks, rs->checks, rs->checkCount * sizeof( word ) );
+    }
+  }
+
+  return copy;
+}
+
+/**
+ * Frees an array of prepared groups.
+ * 
+ * @param groups the prepared groups
+ * @param count number of groups
+ */
+void freeGroups( PreparedGroup *groups, int count )
+{
+  for ( int g = 0; g < count; g++ ) {
+    if ( groups[ g ].format == FORMAT_RAW_MD5 ) {
+      freeRawSalt( &groups[ g ].raw );
+    }
+  }
+  free( groups );
+}
+
+/**
+ * Hashes a password the way a salt group's targets were hashed.
+ * 
+ * @param pg prepared group
+ * @param pw prepared password
+ * @param hash where the hash is stored
+ * @return false if the hash was given up early because no target
+ *         of the group can match
+ */
+bool hashGroup( PreparedGroup const *pg, PreparedWord const *pw, byte hash[ HASH_SIZE ] )
+{
+  if ( pg->format == FORMAT_RAW_MD5 ) {
+    return rawHash( &pg->raw, pw, hash );
+  }
+
+  if ( pg->format != FORMAT_MD5CRYPT ) {
+    byte digest[ SHA512_DIGEST ];
+    shaCrypt( &pg->sha, pw->str, pw->len, digest );
+    memcpy( hash, digest, HASH_SIZE );
+    return true;
+  }
+
+  hashPrepared( pw, &pg->crypt, hash );
+  return true;
+}
+
+/**
+ * Hashes a run of passwords together the way a salt group's targets
+ * were hashed, if the group's format is faster that way.  SHA-crypt
+ * groups hash passwords of the same length SHA_LANES at a time.
+ * 
+ * @param pg prepared group
+ * @param words prepared passwords
+ * @param count number of passwords
+ * @param hashes where the hash of each password is stored
+ * @return false if the group's format hashes one password at a time,
+ *         in which case nothing was hashed
+ */
+bool hashGroupBatch( PreparedGroup const *pg, PreparedWord const *words, int count,
+                     byte hashes[][ HASH_SIZE ] )
+{
+  if ( pg->format != FORMAT_SHA256CRYPT && pg->format != FORMAT_SHA512CRYPT ) {
+    return false;
+  }
+
+  byte digests[ SHA_LANES ][ SHA512_DIGEST ];
+  char const *pass[ SHA_LANES ];
+  int who[ SHA_LANES ];
+
+  for ( int len = 0; len <= PW_LIMIT; len++ ) {
+    int lanes = 0;
+    for ( int i = 0; i <= count; i++ ) {
+      if ( i < count && words[ i ].len == len ) {
+        who[ lanes ] = i;
+        pass[ lanes++ ] = words[ i ].str;
+      }
+      if ( lanes == SHA_LANES || ( i == count && lanes > 0 ) ) {
+        // idle lanes just hash the first password again
+        for ( int j = lanes; j < SHA_LANES; j++ ) {
+          pass[ j ] = pass[ 0 ];
+        }
+        shaCryptLanes( &pg->sha, pass, len, digests );
+        for ( int j = 0; j < lanes; j++ ) {
+          memcpy( hashes[ who[ j ] ], digests[ j ], HASH_SIZE );
+        }
+        lanes = 0;
+      }
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file hybrid.c
+ * @author Luke Early
+ * Implements the hybrid keyspace, which extends dictionary words
+ * with a mask prefix or suffix.
+ * 
+ * Candidates are built in a buffer local to the filling thread.  The
+ * word is copied in once, and stepping from one candidate to the
+ * next only rewrites the mask characters that change.
+ */
+
+#include "hybrid.h"
+#include "mask.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+/** What a hybrid keyspace needs to produce its candidates. */
+typedef struct {
+  WordPool const *dict;
+  Mask mask;
+  bool prefix;
+} HybridState;
+
+/**
+ * Adds the hybrid candidates at positions start up to end to the batch.
+ * 
+ * @param ks hybrid keyspace
+ * @param start first position
+ * @param end position after the last one
+ * @param out batch to add to
+ */
+static void fillHybrid( Keyspace const *ks, long long start, long long end, Batch *out )
+{
+  HybridState const *hs = (HybridState const *)ks->state;
+  Mask const *mask = &hs->mask;
+  long long idx = start;
+
+  while ( idx < end ) {
+    long long w = idx / mask->size;
+    long long wordEnd = ( w + 1 ) * mask->size < end ? ( w + 1 ) * mask->size : end;
+    int wordLen = hs->dict->lens[ w ];
+
+    // skip every candidate of a word too long to take the mask
+    if ( wordLen + mask->len > PW_LIMIT ) {
+      idx = wordEnd;
+      continue;
+    }
+
+    /**
+     * Lay out the word and the mask's first string once
+     */
+    Password cand = "";
+    char *maskAt = hs->prefix ? cand : cand + wordLen;
+    memcpy( hs->prefix ? cand + mask->len : cand, hs->dict->slots[ w ], wordLen );
+
+    int digits[ PW_LIMIT ];
+    seekMask( mask, idx % mask->size, digits, maskAt );
+
+    /**
+     * Then step the mask characters alone
+     */
+    while ( true ) {
+      addCandidate( out, cand, wordLen + mask->len, idx );
+      if ( ++idx >= wordEnd ) {
+        break;
+      }
+      nextMask( mask, digits, maskAt );
+    }
+  }
+}
+
+/**
+ * Makes a keyspace of every dictionary word joined with every string
+ * of a mask, such as "batman" with "?d?d?d?d" giving "batman0000" up
+ * to "batman9999".  Position i is word i / M with mask string i % M,
+ * where M is the size of the mask's keyspace.  Words too long to take
+ * the mask are skipped.
+ * 
+ * @param dict dictionary words, which must outlive the keyspace
+ * @param maskStr mask string
+ * @param prefix put the mask before the word instead of after it
+ * @return pointer to the newly created keyspace, or NULL if the mask is invalid
+ */
+Keyspace *makeHybridKeyspace( WordPool const *dict, char const *maskStr, bool prefix )
+{
+  HybridState *hs = (HybridState *)malloc( sizeof( HybridState ) );
+
+  if ( !parseMask( maskStr, &hs->mask ) ||
+       ( dict->count > 0 && hs->mask.size > LLONG_MAX / dict->count ) ) {
+    free( hs );
+    return NULL;
+  }
+  hs->dict = dict;
+  hs->prefix = prefix;
+
+  Keyspace *ks = (Keyspace *)malloc( sizeof( Keyspace ) );
+  ks->size = dict->count * hs->mask.size;
+  ks->fill = fillHybrid;
+  ks->cleanup = free;
+  ks->state = hs;
+
+  return ks;
+}
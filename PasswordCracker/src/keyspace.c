@@ -0,0 +1,107 @@
+/**
+ * @file keyspace.c
+ * @author Luke Early
+ * Implements the keyspace for a plain dictionary, where position i
+ * is simply word i, and for a subset of one.
+ */
+
+#include "keyspace.h"
+#include <stdlib.h>
+
+/**
+ * Adds dictionary words start up to end to the batch.
+ * 
+ * @param ks dictionary keyspace
+ * @param start first position
+ * @param end position after the last one
+ * @param out batch to add to
+ */
+static void fillDict( Keyspace const *ks, long long start, long long end, Batch *out )
+{
+  WordPool const *dict = (WordPool const *)ks->state;
+
+  for ( long long i = start; i < end; i++ ) {
+    addCandidate( out, dict->slots[ i ], dict->lens[ i ], i );
+  }
+}
+
+/**
+ * Makes a keyspace holding the words of a dictionary, in order.
+ * 
+ * @param dict dictionary words, which must outlive the keyspace
+ * @return pointer to the newly created keyspace
+ */
+Keyspace *makeDictKeyspace( WordPool const *dict )
+{
+  Keyspace *ks = (Keyspace *)malloc( sizeof( Keyspace ) );
+
+  ks->size = dict->count;
+  ks->fill = fillDict;
+  ks->cleanup = NULL;
+  ks->state = (void *)dict;
+
+  return ks;
+}
+
+/** What a subset keyspace needs to produce its candidates. */
+typedef struct {
+  WordPool const *dict;
+  long long const *picks;
+} SubsetState;
+
+/**
+ * Adds picked words start up to end to the batch.
+ * 
+ * @param ks subset keyspace
+ * @param start first position
+ * @param end position after the last one
+ * @param out batch to add to
+ */
+static void fillSubset( Keyspace const *ks, long long start, long long end, Batch *out )
+{
+  SubsetState const *ss = (SubsetState const *)ks->state;
+
+  for ( long long i = start; i < end; i++ ) {
+    long long w = ss->picks[ i ];
+    addCandidate( out, ss->dict->slots[ w ], ss->dict->lens[ w ], w );
+  }
+}
+
+/**
+ * Makes a keyspace holding some of the words of a dictionary.  Each
+ * keeps its position in the dictionary, so results come out in the
+ * same order as with the whole dictionary.
+ * 
+ * @param dict dictionary words, which must outlive the keyspace
+ * @param picks dictionary positions of the words, in increasing
+ *              order, which must outlive the keyspace
+ * @param count number of words picked
+ * @return pointer to the newly created keyspace
+ */
+Keyspace *makeSubsetKeyspace( WordPool const *dict, long long const *picks, long long count )
+{
+  SubsetState *ss = (SubsetState *)malloc( sizeof( SubsetState ) );
+  ss->dict = dict;
+  ss->picks = picks;
+
+  Keyspace *ks = (Keyspace *)malloc( sizeof( Keyspace ) );
+  ks->size = count;
+  ks->fill = fillSubset;
+  ks->cleanup = free;
+  ks->state = ss;
+
+  return ks;
+}
+
+/**
+ * Frees the memory previously allocated to the given keyspace.
+ * 
+ * @param ks keyspace to free
+ */
+void freeKeyspace( Keyspace *ks )
+{
+  if ( ks->cleanup != NULL ) {
+    ks->cleanup( ks->state );
+  }
+  free( ks );
+}
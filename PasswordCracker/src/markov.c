@@ -0,0 +1,382 @@
+/**
+ * @file markov.c
+ * @author Luke Early
+ * Implements Markov-chain candidate generation: statistics about
+ * which characters follow which, learned from a dictionary, order
+ * brute force so the likely strings come first.
+ * 
+ * At each position, the characters that can follow the previous one
+ * are ranked from most to least common, and a candidate is described
+ * by its rank at each position.  Candidates are numbered by their
+ * total rank first and length second, so a position can be turned
+ * back into its candidate by counting, without walking the ones
+ * before it.
+ */
+
+#include "markov.h"
+#include "fileutil.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+
+/** Marks a file as holding Markov statistics, "MKV2" read as bytes. */
+#define MARKOV_MAGIC 0x4d4b5632
+
+/** Bytes in a stored count or magic number. */
+#define WORD_BYTES 4
+
+/** Bytes in a stored entry: position, context, character and count. */
+#define ENTRY_BYTES ( 3 + WORD_BYTES )
+
+/** Number of counts the statistics hold. */
+#define CELL_COUNT ( PW_LIMIT * MARKOV_CONTEXTS * MARKOV_CHARS )
+
+/** Largest total rank of a candidate. */
+#define MAX_LEVEL ( PW_LIMIT * ( MARKOV_CHARS - 1 ) )
+
+/** A run of candidates sharing a length and total rank. */
+typedef struct {
+  // Length of the candidates.
+  int len;
+
+  // Total rank of the candidates.
+  int level;
+
+  // First keyspace position of the run.
+  long long start;
+} MarkovRun;
+
+/** What a Markov keyspace needs to produce its candidates. */
+typedef struct {
+  // Characters after each context at each position, most likely first.
+  char ranked[ PW_LIMIT ][ MARKOV_CONTEXTS ][ MARKOV_CHARS ];
+
+  // ways[ k ][ s ] is the number of ways k positions can have total rank s.
+  long long ways[ PW_LIMIT + 1 ][ MAX_LEVEL + 1 ];
+
+  // Runs in keyspace order, plus one marking the end.
+  MarkovRun *runs;
+  int runCount;
+} MarkovState;
+
+/**
+ * Adds the transitions of every word in a dictionary to the
+ * statistics.  Words with characters the statistics don't cover are
+ * left out.
+ * 
+ * @param stats statistics to add to, which should start out zeroed
+ * @param words words to learn from
+ */
+void trainMarkov( MarkovStats *stats, WordPool const *words )
+{
+  for ( long long w = 0; w < words->count; w++ ) {
+    char const *word = words->slots[ w ];
+    int len = words->lens[ w ];
+
+    bool covered = true;
+    for ( int p = 0; p < len; p++ ) {
+      if ( word[ p ] < MARKOV_FIRST_CHAR || word[ p ] >= MARKOV_FIRST_CHAR + MARKOV_CHARS ) {
+        covered = false;
+      }
+    }
+    if ( !covered ) {
+      continue;
+    }
+
+    int context = 0;
+    for ( int p = 0; p < len; p++ ) {
+      int c = word[ p ] - MARKOV_FIRST_CHAR;
+      if ( stats->counts[ p ][ context ][ c ] < UINT32_MAX ) {
+        stats->counts[ p ][ context ][ c ]++;
+      }
+      context = 1 + c;
+    }
+  }
+}
+
+/**
+ * Stores a word in a file, most significant byte first.
+ * 
+ * @param fp file to write to
+ * @param v the word
+ * @return true if it was written
+ */
+static bool putWord( FILE *fp, uint32_t v )
+{
+  unsigned char buf[ WORD_BYTES ] = { v >> 24, v >> 16, v >> 8, v };
+  return fwrite( buf, WORD_BYTES, 1, fp ) == 1;
+}
+
+/**
+ * Reads a word stored by putWord().
+ * 
+ * @param p first byte of the word
+ * @return the word
+ */
+static uint32_t loadWord( unsigned char const *p )
+{
+  return (uint32_t) p[ 0 ] << 24 | (uint32_t) p[ 1 ] << 16 | (uint32_t) p[ 2 ] << 8 | p[ 3 ];
+}
+
+/**
+ * Writes statistics to a stream: the magic number and the number of
+ * counts that aren't zero, then the position, context, character and
+ * value of each of those counts.
+ * 
+ * @param fp stream to write to
+ * @param ctx statistics to write
+ * @return true if everything was written
+ */
+static bool writeStats( FILE *fp, void const *ctx )
+{
+  MarkovStats const *stats = (MarkovStats const *)ctx;
+
+  uint32_t used = 0;
+  for ( int p = 0; p < PW_LIMIT; p++ ) {
+    for ( int x = 0; x < MARKOV_CONTEXTS; x++ ) {
+      for ( int c = 0; c < MARKOV_CHARS; c++ ) {
+        used += stats->counts[ p ][ x ][ c ] != 0;
+      }
+    }
+  }
+
+  bool ok = putWord( fp, MARKOV_MAGIC ) && putWord( fp, used );
+  for ( int p = 0; ok && p < PW_LIMIT; p++ ) {
+    for ( int x = 0; ok && x < MARKOV_CONTEXTS; x++ ) {
+      for ( int c = 0; ok && c < MARKOV_CHARS; c++ ) {
+        if ( stats->counts[ p ][ x ][ c ] != 0 ) {
+          ok = fputc( p, fp ) != EOF && fputc( x, fp ) != EOF && fputc( c, fp ) != EOF &&
+               putWord( fp, stats->counts[ p ][ x ][ c ] );
+        }
+      }
+    }
+  }
+
+  return ok;
+}
+
+/**
+ * Writes statistics to a file, replacing it only once the whole file
+ * is written.
+ * 
+ * @param name name of the file
+ * @param stats statistics to write
+ * @return true if the whole file was written
+ */
+bool saveMarkovStats( char const *name, MarkovStats const *stats )
+{
+  return replaceFile( name, writeStats, stats );
+}
+
+/**
+ * Reads statistics written by saveMarkovStats().
+ * 
+ * @param name name of the file
+ * @param stats statistics to fill in
+ * @return true if the file held valid statistics
+ */
+bool loadMarkovStats( char const *name, MarkovStats *stats )
+{
+  FILE *fp = fopen( name, "rb" );
+  if ( fp == NULL ) {
+    return false;
+  }
+
+  memset( stats, 0, sizeof( MarkovStats ) );
+  unsigned char head[ 2 * WORD_BYTES ];
+  bool ok = fread( head, sizeof( head ), 1, fp ) == 1 && loadWord( head ) == MARKOV_MAGIC;
+  uint32_t used = ok ? loadWord( head + WORD_BYTES ) : 0;
+  ok = ok && used <= CELL_COUNT;
+
+  unsigned char buf[ ENTRY_BYTES ];
+  for ( uint32_t i = 0; ok && i < used; i++ ) {
+    ok = fread( buf, ENTRY_BYTES, 1, fp ) == 1 && buf[ 0 ] < PW_LIMIT &&
+         buf[ 1 ] < MARKOV_CONTEXTS && buf[ 2 ] < MARKOV_CHARS;
+    if ( ok ) {
+      stats->counts[ buf[ 0 ] ][ buf[ 1 ] ][ buf[ 2 ] ] = loadWord( buf + 3 );
+    }
+  }
+  ok = ok && fgetc( fp ) == EOF;
+
+  fclose( fp );
+  return ok;
+}
+
+/**
+ * Adds two counts, stopping at LLONG_MAX instead of overflowing.
+ * 
+ * @param a first count
+ * @param b second count
+ * @return a + b, or LLONG_MAX if that's too big
+ */
+static long long addCapped( long long a, long long b )
+{
+  return a > LLONG_MAX - b ? LLONG_MAX : a + b;
+}
+
+/**
+ * Ranks the characters after one context from most to least common,
+ * breaking ties by character order.
+ * 
+ * @param counts how often each character follows the context
+ * @param ranked where to put the characters, most common first
+ */
+static void rankChars( uint32_t const counts[ MARKOV_CHARS ], char ranked[ MARKOV_CHARS ] )
+{
+  for ( int i = 0; i < MARKOV_CHARS; i++ ) {
+    int j = i;
+    while ( j > 0 && counts[ ranked[ j - 1 ] - MARKOV_FIRST_CHAR ] < counts[ i ] ) {
+      ranked[ j ] = ranked[ j - 1 ];
+      j--;
+    }
+    ranked[ j ] = MARKOV_FIRST_CHAR + i;
+  }
+}
+
+/**
+ * Adds the Markov candidates at positions start up to end to the
+ * batch.
+ * 
+ * @param ks Markov keyspace
+ * @param start first position
+ * @param end position after the last one
+ * @param out batch to add to
+ */
+static void fillMarkov( Keyspace const *ks, long long start, long long end, Batch *out )
+{
+  MarkovState const *ms = (MarkovState const *)ks->state;
+
+  /**
+   * Find the run holding the start position
+   */
+  int lo = 0;
+  int hi = ms->runCount - 1;
+  while ( lo < hi ) {
+    int mid = ( lo + hi + 1 ) / 2;
+    if ( ms->runs[ mid ].start <= start ) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+
+  int run = lo;
+  for ( long long idx = start; idx < end; idx++ ) {
+    while ( ms->runs[ run + 1 ].start <= idx ) {
+      run++;
+    }
+
+    /**
+     * Pick each position's rank by counting how many candidates the
+     * lower ranks would account for
+     */
+    int len = ms->runs[ run ].len;
+    int rest = ms->runs[ run ].level;
+    long long offset = idx - ms->runs[ run ].start;
+    int context = 0;
+    Password cand = "";
+
+    for ( int p = 0; p < len; p++ ) {
+      long long const *after = ms->ways[ len - p - 1 ];
+      int rank = 0;
+      while ( offset >= after[ rest - rank ] ) {
+        offset -= after[ rest - rank ];
+        rank++;
+      }
+
+      cand[ p ] = ms->ranked[ p ][ context ][ rank ];
+      context = 1 + cand[ p ] - MARKOV_FIRST_CHAR;
+      rest -= rank;
+    }
+
+    addCandidate( out, cand, len, idx );
+  }
+}
+
+/**
+ * Frees a Markov keyspace's state.
+ * 
+ * @param state state to free
+ */
+static void freeMarkov( void *state )
+{
+  MarkovState *ms = (MarkovState *)state;
+
+  free( ms->runs );
+  free( ms );
+}
+
+/**
+ * Makes a keyspace of the likely strings of lengths 1 up to maxLen.
+ * At each position, only the threshold characters most likely to
+ * follow the previous one are tried.  Every candidate has a rank at
+ * each position, and candidates come in order of their total rank,
+ * so the likeliest strings of every length come first.
+ * 
+ * @param stats statistics to generate from
+ * @param threshold number of characters tried at each position
+ * @param maxLen length of the longest candidates
+ * @return pointer to the newly created keyspace, or NULL if it
+ *         would have too many positions to number
+ */
+Keyspace *makeMarkovKeyspace( MarkovStats const *stats, int threshold, int maxLen )
+{
+  MarkovState *ms = (MarkovState *)malloc( sizeof( MarkovState ) );
+
+  for ( int p = 0; p < PW_LIMIT; p++ ) {
+    for ( int c = 0; c < MARKOV_CONTEXTS; c++ ) {
+      rankChars( stats->counts[ p ][ c ], ms->ranked[ p ][ c ] );
+    }
+  }
+
+  /**
+   * Count the ways to spread each total rank over each number of
+   * positions
+   */
+  memset( ms->ways, 0, sizeof( ms->ways ) );
+  ms->ways[ 0 ][ 0 ] = 1;
+  for ( int k = 1; k <= PW_LIMIT; k++ ) {
+    for ( int s = 0; s <= MAX_LEVEL; s++ ) {
+      for ( int r = 0; r < threshold && r <= s; r++ ) {
+        ms->ways[ k ][ s ] = addCapped( ms->ways[ k ][ s ], ms->ways[ k - 1 ][ s - r ] );
+      }
+    }
+  }
+
+  /**
+   * Lay out a run for each total rank and length, lowest rank first
+   */
+  int maxLevel = maxLen * ( threshold - 1 );
+  ms->runs = (MarkovRun *)malloc( ( ( maxLevel + 1 ) * maxLen + 1 ) * sizeof( MarkovRun ) );
+  ms->runCount = 0;
+
+  long long size = 0;
+  for ( int level = 0; level <= maxLevel; level++ ) {
+    for ( int len = 1; len <= maxLen; len++ ) {
+      long long count = ms->ways[ len ][ level ];
+      if ( count == 0 ) {
+        continue;
+      }
+      if ( count == LLONG_MAX || size > LLONG_MAX - count ) {
+        freeMarkov( ms );
+        return NULL;
+      }
+
+      MarkovRun *run = &ms->runs[ ms->runCount++ ];
+      run->len = len;
+      run->level = level;
+      run->start = size;
+      size += count;
+    }
+  }
+  ms->runs[ ms->runCount ].start = LLONG_MAX;
+
+  Keyspace *ks = (Keyspace *)malloc( sizeof( Keyspace ) );
+  ks->size = size;
+  ks->fill = fillMarkov;
+  ks->cleanup = freeMarkov;
+  ks->state = ms;
+
+  return ks;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file mask.c
+ * @author Luke Early
+ * Parses and expands masks, which describe sets of strings position
+ * by position.
+ */
+
+#include "mask.h"
+#include <string.h>
+#include <limits.h>
+
+/** Character that introduces a character class in a mask */
+#define MASK_CLASS_CHAR '?'
+
+/** Lowercase letters, for ?l */
+static char const lowerSet[] = "abcdefghijklmnopqrstuvwxyz";
+
+/** Uppercase letters, for ?u */
+static char const upperSet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+/** Digits, for ?d */
+static char const digitSet[] = "0123456789";
+
+/** Symbols and space, for ?s */
+static char const symbolSet[] = " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+/** Every printable character, for ?a */
+static char const allSet[] =
+  "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+  " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+/**
+ * Returns the set of characters for a class letter.
+ * 
+ * @param c letter following the ? in a mask
+ * @return the class's characters, or NULL for an unknown class
+ */
+static char const *classSet( char c )
+{
+  switch ( c ) {
+  case 'l':
+    return lowerSet;
+  case 'u':
+    return upperSet;
+  case 'd':
+    return digitSet;
+  case 's':
+    return symbolSet;
+  case 'a':
+    return allSet;
+  default:
+    return NULL;
+  }
+}
+
+/**
+ * Parses a mask string.
+ * 
+ * @param str mask string
+ * @param mask mask to fill in
+ * @return true if str is a valid mask no longer than PW_LIMIT
+ */
+bool parseMask( char const *str, Mask *mask )
+{
+  mask->len = 0;
+  mask->size = 1;
+
+  for ( int i = 0; str[ i ]; i++ ) {
+    if ( mask->len >= PW_LIMIT ) {
+      return false;
+    }
+
+    char const *set;
+    if ( str[ i ] == MASK_CLASS_CHAR && str[ i + 1 ] != MASK_CLASS_CHAR ) {
+      set = classSet( str[ ++i ] );
+      if ( set == NULL ) {
+        return false;
+      }
+    } else {
+      if ( str[ i ] == MASK_CLASS_CHAR ) {
+        i++;
+      }
+      mask->literals[ mask->len ][ 0 ] = str[ i ];
+      mask->literals[ mask->len ][ 1 ] = '\0';
+      set = mask->literals[ mask->len ];
+    }
+
+    mask->sets[ mask->len ] = set;
+    mask->sizes[ mask->len ] = strlen( set );
+    if ( mask->size > LLONG_MAX / mask->sizes[ mask->len ] ) {
+      return false;
+    }
+    mask->size *= mask->sizes[ mask->len ];
+    mask->len++;
+  }
+
+  return true;
+}
+
+/**
+ * Writes the string at the given position of the mask's keyspace,
+ * and the digits that identify it, for use with nextMask().
+ * 
+ * @param mask mask to expand
+ * @param pos position, from 0 to mask->size - 1
+ * @param digits index into each position's set of characters
+ * @param out where the mask->len characters are written
+ */
+void seekMask( Mask const *mask, long long pos, int digits[ PW_LIMIT ], char *out )
+{
+  // the last position changes fastest
+  for ( int i = mask->len - 1; i >= 0; i-- ) {
+    digits[ i ] = pos % mask->sizes[ i ];
+    pos /= mask->sizes[ i ];
+    out[ i ] = mask->sets[ i ][ digits[ i ] ];
+  }
+}
+
+/**
+ * Steps to the next string of the mask's keyspace, like an odometer,
+ * rewriting only the characters that change.
+ * 
+ * @param mask mask to expand
+ * @param digits digits of the current string, updated
+ * @param out the current string, updated
+ */
+void nextMask( Mask const *mask, int digits[ PW_LIMIT ], char *out )
+{
+  for ( int i = mask->len - 1; i >= 0; i-- ) {
+    if ( ++digits[ i ] < mask->sizes[ i ] ) {
+      out[ i ] = mask->sets[ i ][ digits[ i ] ];
+      return;
+    }
+    digits[ i ] = 0;
+    out[ i ] = mask->sets[ i ][ 0 ];
+  }
+}
@@ -6,6 +6,13 @@
 
 #include "md5.h"
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef USE_OPENSSL
+// MD5_Transform() is deprecated in OpenSSL 3, but it is the only way in to the bare compression.
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include <openssl/md5.h>
+#endif
 
 /** Function type for the f functions in the md5 algorithm. */
 typedef word (*FFunction)( word, word, word );
@@ -239,32 +246,24 @@ void padBlock( Block *block )
 }
 
 /**
- * Pads given input block, computes the MD5 hash with helper functions, 
- * stores the results in a given hash array.
+ * The in-tree MD5 backend: runs the 64 iterations of the algorithm
+ * over one block and adds the result into the state.
  * 
- * @param block block of data
- * @param hash list of hashes
+ * @param state words A, B, C, D to update
+ * @param data padded block of data
  */
-void md5Hash( Block *block, byte hash[ HASH_SIZE ] )
+static void intreeTransform( word state[ 4 ], byte const data[ BLOCK_SIZE ] )
 {
-  /** 
-   * Starting values for words A, B, C, D 
-   */
-  word A = INIT_VALUE_A;
-  word B = INIT_VALUE_B;
-  word C = INIT_VALUE_C;
-  word D = INIT_VALUE_D;
+  word A = state[ 0 ];
+  word B = state[ 1 ];
+  word C = state[ 2 ];
+  word D = state[ 3 ];
 
   /** 
    * List of words
    */
   word M[ HASH_SIZE ];
 
-  /** 
-   * Ensure block is properly padded
-   */
-  padBlock( block );
-
   /**
    * Fill M with 16 words
    */
@@ -275,9 +274,9 @@ void md5Hash( Block *block, byte hash[ HASH_SIZE ] )
 
     for ( int j = mostSigByte; j > leastSigByte - 1; j-- ) {
       if ( j == leastSigByte ) {
-        w = w | block->data[ j ];
+        w = w | data[ j ];
       } else {
-        w = w | block->data[ j ];
+        w = w | data[ j ];
         w = w << BITS_IN_A_BYTE;
       }
     }
@@ -291,13 +290,123 @@ void md5Hash( Block *block, byte hash[ HASH_SIZE ] )
     md5Iteration( M, &A, &B, &C, &D, i );
   }
 
-  /**
-   * Add back in the initialization values
+  state[ 0 ] += A;
+  state[ 1 ] += B;
+  state[ 2 ] += C;
+  state[ 3 ] += D;
+}
+
+#ifdef USE_OPENSSL
+/**
+ * The libcrypto MD5 backend: has OpenSSL's MD5_Transform() compress
+ * one block into the state.
+ * 
+ * @param state words A, B, C, D to update
+ * @param data padded block of data
+ */
+static void opensslTransform( word state[ 4 ], byte const data[ BLOCK_SIZE ] )
+{
+  MD5_CTX ctx;
+  MD5_Init( &ctx );
+  ctx.A = state[ 0 ];
+  ctx.B = state[ 1 ];
+  ctx.C = state[ 2 ];
+  ctx.D = state[ 3 ];
+
+  MD5_Transform( &ctx, data );
+
+  state[ 0 ] = ctx.A;
+  state[ 1 ] = ctx.B;
+  state[ 2 ] = ctx.C;
+  state[ 3 ] = ctx.D;
+}
+#endif
+
+/** An MD5 backend that may be chosen by name. */
+typedef struct {
+  char const *name;
+  Md5Transform transform;
+} Md5Backend;
+
+/** Backends built into this program, the default first. */
+static Md5Backend const backends[] = {
+  { MD5_BACKEND_INTREE, intreeTransform },
+#ifdef USE_OPENSSL
+  { MD5_BACKEND_OPENSSL, opensslTransform },
+#endif
+};
+
+/** Backend md5Hash() is using. */
+static Md5Backend const *backend = &backends[ 0 ];
+
+/**
+ * Chooses the backend md5Hash() compresses blocks with.  This must
+ * be done before any hashing threads start.
+ * 
+ * @param name MD5_BACKEND_INTREE or MD5_BACKEND_OPENSSL
+ * @return false if there is no backend of that name in this build
+ */
+bool setMd5Backend( char const *name )
+{
+  for ( int i = 0; md5BackendAt( i ) != NULL; i++ ) {
+    if ( strcmp( backends[ i ].name, name ) == 0 ) {
+      backend = &backends[ i ];
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Returns the name of the backend md5Hash() is using.
+ * 
+ * @return name of the backend
+ */
+char const *md5BackendName( void )
+{
+  return backend->name;
+}
+
+/**
+ * Returns the name of one of the backends in this build, for listing
+ * them all.
+ * 
+ * @param i index of the backend
+ * @return the backend's name, or NULL if there are fewer than i + 1
+ */
+char const *md5BackendAt( int i )
+{
+  if ( i < 0 || i >= (int) ( sizeof( backends ) / sizeof( backends[ 0 ] ) ) ) {
+    return NULL;
+  }
+  return backends[ i ].name;
+}
+
+/**
+ * Pads given input block, computes the MD5 hash with the chosen
+ * backend, stores the results in a given hash array.
+ * 
+ * @param block block of data
+ * @param hash list of hashes
+ */
+void md5Hash( Block *block, byte hash[ HASH_SIZE ] )
+{
+  /** 
+   * Starting values for words A, B, C, D 
    */
-  A += INIT_VALUE_A;
-  B += INIT_VALUE_B;
-  C += INIT_VALUE_C;
-  D += INIT_VALUE_D;
+  word state[ 4 ] = { INIT_VALUE_A, INIT_VALUE_B, INIT_VALUE_C, INIT_VALUE_D };
+
+  /** 
+   * Ensure block is properly padded
+   */
+  padBlock( block );
+
+  backend->transform( state, block->data );
+
+  word A = state[ 0 ];
+  word B = state[ 1 ];
+  word C = state[ 2 ];
+  word D = state[ 3 ];
 
   for ( int i = 0; i < HASH_SIZE; i++ ) {
     byte byteToLoad = 0;
@@ -0,0 +1,214 @@
+/**
+ * @file numa.c
+ * @author Luke Early
+ * Places workers and the data they read on the host's NUMA nodes.
+ * 
+ * Memory belongs to the node of the CPU that first touches it, so
+ * data built by the main thread ends up on one node, and workers on
+ * the others read it across the interconnect.  Workers are pinned to
+ * the nodes in turn, small data they read all the time is copied
+ * onto each node by a thread bound there, and large data is spread
+ * over every node.
+ */
+
+#include "numa.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+/** Directory the kernel describes the NUMA nodes in. */
+#define NODE_DIR "/sys/devices/system/node"
+
+/** Length of the longest file name or CPU list read from NODE_DIR. */
+#define NODE_LINE_LIMIT 4095
+
+/** mbind() policy and flag for spreading pages over nodes and moving those in place. */
+#define MPOL_INTERLEAVE 3
+#define MPOL_MF_MOVE ( 1 << 1 )
+
+/** Bits in a word of a node mask. */
+#define MASK_WORD_BITS ( 8 * sizeof( unsigned long ) )
+
+/** The nodes workers are placed on, or NULL if NUMA placement is off. */
+static NumaTopology *topology = NULL;
+
+/**
+ * Reads a CPU or node list from a file in NODE_DIR.
+ * 
+ * @param name file name, relative to NODE_DIR
+ * @param list where the list is stored
+ * @return false if the file is missing or not a valid list
+ */
+static bool readNodeList( char const *name, WorkerLimits *list )
+{
+  char path[ NODE_LINE_LIMIT + 1 ];
+  snprintf( path, sizeof( path ), "%s/%s", NODE_DIR, name );
+
+  FILE *fp = fopen( path, "r" );
+  if ( fp == NULL ) {
+    return false;
+  }
+
+  char line[ NODE_LINE_LIMIT + 1 ];
+  bool ok = fgets( line, sizeof( line ), fp ) != NULL;
+  fclose( fp );
+  if ( !ok ) {
+    return false;
+  }
+
+  line[ strcspn( line, "\n" ) ] = '\0';
+
+  // a node without CPUs has an empty list
+  list->cpuCount = 0;
+  return line[ 0 ] == '\0' || parseCpuList( line, list );
+}
+
+/**
+ * Reads the host's NUMA nodes from /sys/devices/system/node and makes
+ * them the ones workers are placed on.  A host without NUMA has one
+ * node.
+ * 
+ * @return false if the nodes could not be read
+ */
+bool enableNuma( void )
+{
+  WorkerLimits *list = (WorkerLimits *)malloc( sizeof( WorkerLimits ) );
+  WorkerLimits *nodeCpus = (WorkerLimits *)malloc( sizeof( WorkerLimits ) );
+  NumaTopology *topo = (NumaTopology *)calloc( 1, sizeof( NumaTopology ) );
+  for ( int cpu = 0; cpu < MAX_AFFINITY; cpu++ ) {
+    topo->cpuNode[ cpu ] = -1;
+  }
+
+  bool ok = readNodeList( "online", list );
+  for ( int i = 0; ok && i < list->cpuCount && topo->count < MAX_NODES; i++ ) {
+    char name[ NODE_LINE_LIMIT + 1 ];
+    snprintf( name, sizeof( name ), "node%d/cpulist", list->cpus[ i ] );
+    ok = readNodeList( name, nodeCpus );
+
+    // memory-only nodes have no workers to place
+    if ( ok && nodeCpus->cpuCount > 0 ) {
+      int n = topo->count++;
+      topo->ids[ n ] = list->cpus[ i ];
+      topo->cpuCount[ n ] = nodeCpus->cpuCount;
+      topo->cpus[ n ] = (int *)malloc( nodeCpus->cpuCount * sizeof( int ) );
+      memcpy( topo->cpus[ n ], nodeCpus->cpus, nodeCpus->cpuCount * sizeof( int ) );
+      for ( int c = 0; c < nodeCpus->cpuCount; c++ ) {
+        topo->cpuNode[ nodeCpus->cpus[ c ] ] = n;
+      }
+    }
+  }
+
+  free( nodeCpus );
+  free( list );
+  if ( !ok || topo->count == 0 ) {
+    for ( int n = 0; n < topo->count; n++ ) {
+      free( topo->cpus[ n ] );
+    }
+    free( topo );
+    return false;
+  }
+
+  topology = topo;
+  return true;
+}
+
+/**
+ * Returns the NUMA nodes workers are placed on.
+ * 
+ * @return the nodes, or NULL if NUMA placement is off
+ */
+NumaTopology const *numaTopology( void )
+{
+  return topology;
+}
+
+/**
+ * Fills in worker limits that pin the workers to the CPUs of every
+ * node in turn, so worker i runs on node i modulo the node count as
+ * long as there are CPUs of that node left.
+ * 
+ * @param limits limits to fill in the CPUs of
+ */
+void numaWorkerLimits( WorkerLimits *limits )
+{
+  limits->cpuCount = 0;
+
+  bool more = true;
+  for ( int c = 0; more; c++ ) {
+    more = false;
+    for ( int n = 0; n < topology->count; n++ ) {
+      if ( c < topology->cpuCount[ n ] ) {
+        limits->cpus[ limits->cpuCount++ ] = topology->cpus[ n ][ c ];
+        more = true;
+      }
+    }
+  }
+}
+
+/**
+ * Returns the node the calling thread is running on.
+ * 
+ * @return index of the node in the topology, 0 if NUMA placement is off
+ */
+int currentNode( void )
+{
+  int cpu = sched_getcpu();
+  if ( topology == NULL || cpu < 0 || cpu >= MAX_AFFINITY || topology->cpuNode[ cpu ] < 0 ) {
+    return 0;
+  }
+  return topology->cpuNode[ cpu ];
+}
+
+/**
+ * Limits the calling thread to the CPUs of one node, so memory it
+ * touches first is allocated there.
+ * 
+ * @param node index of the node in the topology
+ */
+void bindToNode( int node )
+{
+  cpu_set_t set;
+  CPU_ZERO( &set );
+  for ( int c = 0; c < topology->cpuCount[ node ]; c++ ) {
+    CPU_SET( topology->cpus[ node ][ c ], &set );
+  }
+  pthread_setaffinity_np( pthread_self(), sizeof( set ), &set );
+}
+
+/**
+ * Spreads the pages of a block of memory evenly over the nodes, for
+ * large data every worker reads.  Pages already in place are moved.
+ * 
+ * @param addr start of the block
+ * @param len size of the block in bytes
+ */
+void interleaveMemory( void *addr, size_t len )
+{
+  if ( topology == NULL || topology->count < 2 || len == 0 ) {
+    return;
+  }
+
+  unsigned long mask[ MAX_NODES / MASK_WORD_BITS + 1 ];
+  memset( mask, 0, sizeof( mask ) );
+  int maxNode = 0;
+  for ( int n = 0; n < topology->count; n++ ) {
+    int id = topology->ids[ n ];
+    if ( id < MAX_NODES ) {
+      mask[ id / MASK_WORD_BITS ] |= 1UL << ( id % MASK_WORD_BITS );
+      maxNode = id + 1 > maxNode ? id + 1 : maxNode;
+    }
+  }
+
+  // mbind() works on whole pages
+  uintptr_t page = sysconf( _SC_PAGESIZE );
+  uintptr_t start = (uintptr_t) addr & ~( page - 1 );
+  uintptr_t end = ( (uintptr_t) addr + len + page - 1 ) & ~( page - 1 );
+
+  // the kernel reads one bit fewer of the mask than maxnode says
+  syscall( SYS_mbind, start, end - start, MPOL_INTERLEAVE, mask, maxNode + 1, MPOL_MF_MOVE );
+}
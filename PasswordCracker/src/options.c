@@ -0,0 +1,444 @@
+/**
+ * @file options.c
+ * @author Luke Early
+ * Parses the command-line options for the program.
+ */
+
+#include "options.h"
+#include "dictionary.h"
+#include "engine.h"
+#include "markov.h"
+#include "prince.h"
+#include "tune.h"
+#include "workers.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+
+/** Most file names that can be given on the command line. */
+#define MAX_FILES ( MAX_SHADOWS + 1 )
+
+/** base for numeric option values */
+#define OPTION_BASE 10
+
+/** Print out a usage message and exit unsuccessfully. */
+static void usage()
+{
+  fprintf( stderr, "Usage: crack dictionary-filename shadow-filename\n" );
+  exit( EXIT_FAILURE );
+}
+
+/** Print out the list of options and exit successfully. */
+static void help()
+{
+  printf( "Usage: crack [options] dictionary-filename shadow-filename...\n" );
+  printf( "  Several shadow files are cracked in one pass, each user reported as"
+          " FILE:USER\n" );
+  printf( "  --pipeline       stream the dictionary to hashing workers;"
+          " \"-\" reads it from stdin\n" );
+  printf( "  --threads N      number of hashing workers (default: one per CPU)\n" );
+  printf( "  --hybrid-suffix MASK  try each word followed by every string of MASK\n" );
+  printf( "  --hybrid-prefix MASK  try each word preceded by every string of MASK\n" );
+  printf( "                   (?l lower, ?u upper, ?d digit, ?s symbol, ?a any, ?? a ?)\n" );
+  printf( "  --prince         try chains of dictionary words, fewest words first\n" );
+  printf( "  --prince-elems N  most words in a chain (default: %d)\n", DEFAULT_PRINCE_ELEMS );
+  printf( "  --combine LEFT RIGHT  try each word of LEFT followed by each word of RIGHT;\n"
+          "                   only the shadow file name follows\n" );
+  printf( "  --markov-train STATS  learn character statistics from the dictionary"
+          " into STATS;\n                   only the dictionary file name follows\n" );
+  printf( "  --markov STATS   try the likeliest strings under STATS first;"
+          " only the shadow\n                   file name follows\n" );
+  printf( "  --markov-threshold N  characters tried at each position"
+          " (default: %d)\n", DEFAULT_MARKOV_THRESHOLD );
+  printf( "  --markov-length N  longest string tried (default: %d)\n", DEFAULT_MARKOV_LENGTH );
+  printf( "  --tile-words N   words per tile of work (default: %d)\n", DEFAULT_TILE_WORDS );
+  printf( "  --tile-salts N   salt groups per tile of work (default: %d)\n", DEFAULT_TILE_SALTS );
+  printf( "  --tiers N[,N...]  run the first N candidates against every account, then\n"
+          "                   the next N, and so on, then the rest; each account\n"
+          "                   is reported once\n" );
+  printf( "  --policy RULES   skip candidates the target system would refuse; RULES is\n"
+          "                   a comma-separated list of min=N, max=N, lower, upper,\n"
+          "                   digit, symbol, classes=N and forbid=CHARS\n" );
+  printf( "  --dedupe MB      skip candidates already tried, remembering them in a\n"
+          "                   filter of MB MiB; a few new ones may be skipped too\n" );
+  printf( "  --state FILE     re-audit: try only new words on old accounts, and all\n"
+          "                   words on new ones, then record this run in FILE\n" );
+  printf( "  --daemon SOCKET  keep the dictionary loaded and crack jobs sent to SOCKET\n"
+          "                   (JOB PRI + shadow lines + \".\", FILE PRI PATH, CANCEL ID,\n"
+          "                   RELOAD, SHUTDOWN)\n" );
+  printf( "  --connect SOCKET  send standard input to the daemon at SOCKET and print\n"
+          "                   what it sends back\n" );
+  printf( "  --hash FILE      write \"$1$salt$hash\" for each line of FILE (\"-\" for"
+          " stdin),\n                   a word and a salt separated by a space\n" );
+  printf( "  --hash-salt SALT  hash each word of the --hash file with SALT\n" );
+  printf( "  --build-index FILE  hash the dictionary with one salt and save the"
+          " digests in FILE\n" );
+  printf( "  --index-salt SALT  salt to build the index for\n" );
+  printf( "  --index FILE     look up users with the salt of index FILE instead of"
+          " hashing\n" );
+  printf( "  --manifest FILE  also crack the shadow files listed in FILE, one per line\n" );
+  printf( "  --stats          report statistics about the run on stderr\n" );
+  printf( "  --max-words N    largest dictionary to load, 0 for no limit"
+          " (default: %d)\n", DLIST_LIMIT );
+  printf( "  --shm-dict NAME  share the loaded dictionary with other runs"
+          " through shared memory\n" );
+  printf( "  --shm-keep       leave the shared dictionary in place on exit\n" );
+  printf( "  --md5-backend NAME  compute MD5 with NAME (intree, or openssl if built"
+          " with OPENSSL=1)\n" );
+  printf( "  --benchmark N    time each MD5 backend on N md5crypt hashes\n" );
+  printf( "  --autotune       use the threads and MD5 backend measured\n"
+          "                   fastest on this kind of host, measuring them if needed\n" );
+  printf( "  --plan           estimate the hashes, time and memory the run needs"
+          " instead\n                   of cracking\n" );
+  printf( "  --max-cpu PCT    let each worker hash at most PCT%% of the time"
+          " (default: %d)\n", FULL_CPU );
+  printf( "  --affinity LIST  pin the workers to the CPUs in LIST, such as 0-3,8\n" );
+  printf( "  --nice N         run the workers at niceness N, and read at idle-ish"
+          " I/O priority\n" );
+  printf( "  --numa           spread the workers over the NUMA nodes, with a copy of"
+          " the\n                   targets on each\n" );
+  printf( "  --trace FILE     write a Chrome trace_event JSON timeline of each"
+          " thread's\n                   stages to FILE at exit\n" );
+  printf( "  --tune-file FILE  cache of host tunings (default: ~/%s)\n", TUNE_FILE_NAME );
+  printf( "  --help           print this message\n" );
+  exit( EXIT_SUCCESS );
+}
+
+/**
+ * Returns the value that follows an option, or prints a usage
+ * message if there isn't one.
+ * 
+ * @param argc number of command-line arguments
+ * @param argv command-line arguments
+ * @param idx index of the option, advanced past its value
+ * @return the option's value
+ */
+static char const *optionValue( int argc, char *argv[], int *idx )
+{
+  if ( *idx + 1 >= argc ) {
+    usage();
+  }
+
+  *idx += 1;
+  return argv[ *idx ];
+}
+
+/**
+ * Parses a non-negative count given as an option value, which may be
+ * as large as a long long holds.
+ * 
+ * @param str option value
+ * @return value of str
+ */
+static long long parseLongCount( char const *str )
+{
+  char *end;
+  errno = 0;
+  long long val = strtoll( str, &end, OPTION_BASE );
+
+  if ( *str == '\0' || *end != '\0' || val < 0 || errno == ERANGE ) {
+    usage();
+  }
+
+  return val;
+}
+
+/**
+ * Parses a non-negative count given as an option value, which must
+ * fit in an int.
+ * 
+ * @param str option value
+ * @return value of str
+ */
+static int parseCount( char const *str )
+{
+  long long val = parseLongCount( str );
+
+  if ( val > INT_MAX ) {
+    usage();
+  }
+
+  return (int) val;
+}
+
+/**
+ * Parses a comma-separated list of tier sizes, each at least 1.
+ * 
+ * @param str option value
+ * @param opts options to store the sizes in
+ */
+static void parseTiers( char const *str, Options *opts )
+{
+  opts->tierCount = 0;
+
+  while ( true ) {
+    char *end;
+    long long val = strtoll( str, &end, OPTION_BASE );
+
+    if ( end == str || val < 1 || opts->tierCount == MAX_TIERS ) {
+      usage();
+    }
+    opts->tiers[ opts->tierCount++ ] = val;
+
+    if ( *end == '\0' ) {
+      return;
+    } else if ( *end != ',' ) {
+      usage();
+    }
+    str = end + 1;
+  }
+}
+
+/**
+ * Parses the command line into the given options.  Options start
+ * with "--" and may appear anywhere before the file names.  With
+ * --combine or --markov, the candidates don't come from a dictionary
+ * and only the shadow file names are left; with --markov-train, only
+ * the dictionary file name is.  Any unknown option or missing file
+ * name prints a usage message and exits unsuccessfully.
+ * 
+ * @param argc number of command-line arguments
+ * @param argv command-line arguments
+ * @param opts options to fill in
+ */
+void parseOptions( int argc, char *argv[], Options *opts )
+{
+  char const *files[ MAX_FILES ];
+  int fileCount = 0;
+
+  memset( opts, 0, sizeof( Options ) );
+  opts->maxWords = DLIST_LIMIT;
+  opts->maxCpu = FULL_CPU;
+  opts->tileWords = DEFAULT_TILE_WORDS;
+  opts->tileSalts = DEFAULT_TILE_SALTS;
+  opts->princeElems = DEFAULT_PRINCE_ELEMS;
+  opts->markovThreshold = DEFAULT_MARKOV_THRESHOLD;
+  opts->markovLength = DEFAULT_MARKOV_LENGTH;
+
+  for ( int i = 1; i < argc; i++ ) {
+    char const *arg = argv[ i ];
+
+    if ( strcmp( arg, "--help" ) == 0 ) {
+      help();
+    } else if ( strcmp( arg, "--pipeline" ) == 0 ) {
+      opts->pipeline = true;
+    } else if ( strcmp( arg, "--threads" ) == 0 ) {
+      opts->threads = parseCount( optionValue( argc, argv, &i ) );
+    } else if ( strcmp( arg, "--hybrid-suffix" ) == 0 ) {
+      opts->hybridSuffix = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--hybrid-prefix" ) == 0 ) {
+      opts->hybridPrefix = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--prince" ) == 0 ) {
+      opts->prince = true;
+    } else if ( strcmp( arg, "--prince-elems" ) == 0 ) {
+      opts->princeElems = parseCount( optionValue( argc, argv, &i ) );
+    } else if ( strcmp( arg, "--combine" ) == 0 ) {
+      opts->dictName = optionValue( argc, argv, &i );
+      opts->combineName = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--markov-train" ) == 0 ) {
+      opts->markovTrain = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--markov" ) == 0 ) {
+      opts->markovName = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--markov-threshold" ) == 0 ) {
+      opts->markovThreshold = parseCount( optionValue( argc, argv, &i ) );
+    } else if ( strcmp( arg, "--markov-length" ) == 0 ) {
+      opts->markovLength = parseCount( optionValue( argc, argv, &i ) );
+    } else if ( strcmp( arg, "--tile-words" ) == 0 ) {
+      opts->tileWords = parseCount( optionValue( argc, argv, &i ) );
+    } else if ( strcmp( arg, "--tile-salts" ) == 0 ) {
+      opts->tileSalts = parseCount( optionValue( argc, argv, &i ) );
+    } else if ( strcmp( arg, "--tiers" ) == 0 ) {
+      parseTiers( optionValue( argc, argv, &i ), opts );
+    } else if ( strcmp( arg, "--policy" ) == 0 ) {
+      opts->policy = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--dedupe" ) == 0 ) {
+      opts->dedupeMB = parseCount( optionValue( argc, argv, &i ) );
+    } else if ( strcmp( arg, "--state" ) == 0 ) {
+      opts->stateName = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--daemon" ) == 0 ) {
+      opts->daemonName = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--connect" ) == 0 ) {
+      opts->connectName = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--hash" ) == 0 ) {
+      opts->hashName = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--hash-salt" ) == 0 ) {
+      opts->hashSalt = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--build-index" ) == 0 ) {
+      opts->buildIndex = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--index-salt" ) == 0 ) {
+      opts->indexSalt = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--index" ) == 0 ) {
+      opts->indexName = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--manifest" ) == 0 ) {
+      opts->manifestName = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--stats" ) == 0 ) {
+      opts->stats = true;
+    } else if ( strcmp( arg, "--max-words" ) == 0 ) {
+      opts->maxWords = parseLongCount( optionValue( argc, argv, &i ) );
+    } else if ( strcmp( arg, "--shm-dict" ) == 0 ) {
+      opts->shmName = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--shm-keep" ) == 0 ) {
+      opts->shmKeep = true;
+    } else if ( strcmp( arg, "--md5-backend" ) == 0 ) {
+      opts->md5Backend = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--benchmark" ) == 0 ) {
+      opts->benchCount = parseCount( optionValue( argc, argv, &i ) );
+      if ( opts->benchCount == 0 ) {
+        usage();
+      }
+    } else if ( strcmp( arg, "--autotune" ) == 0 ) {
+      opts->autotune = true;
+    } else if ( strcmp( arg, "--plan" ) == 0 ) {
+      opts->plan = true;
+    } else if ( strcmp( arg, "--max-cpu" ) == 0 ) {
+      opts->maxCpu = parseCount( optionValue( argc, argv, &i ) );
+    } else if ( strcmp( arg, "--affinity" ) == 0 ) {
+      opts->affinity = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--nice" ) == 0 ) {
+      opts->nice = parseCount( optionValue( argc, argv, &i ) );
+    } else if ( strcmp( arg, "--numa" ) == 0 ) {
+      opts->numa = true;
+    } else if ( strcmp( arg, "--trace" ) == 0 ) {
+      opts->traceName = optionValue( argc, argv, &i );
+    } else if ( strcmp( arg, "--tune-file" ) == 0 ) {
+      opts->tuneName = optionValue( argc, argv, &i );
+    } else if ( arg[ 0 ] == '-' && strcmp( arg, STDIN_DICT_NAME ) != 0 ) {
+      usage();
+    } else if ( fileCount < MAX_FILES ) {
+      files[ fileCount++ ] = arg;
+    } else {
+      usage();
+    }
+  }
+
+  if ( opts->tileWords == 0 || opts->tileSalts == 0 ||
+       opts->markovThreshold < 1 || opts->markovThreshold > MARKOV_CHARS ||
+       opts->markovLength < 1 || opts->markovLength > PW_LIMIT ||
+       opts->princeElems < 1 || opts->princeElems > PW_LIMIT ||
+       opts->maxCpu < 1 || opts->maxCpu > FULL_CPU || opts->nice > MAX_NICE ) {
+    usage();
+  }
+
+  /**
+   * Only one way of producing candidates can be chosen.  A streamed
+   * dictionary is never held in memory to share, expand or run in
+   * tiers, and only a single dictionary can be shared.
+   */
+  bool expandsDict = opts->hybridSuffix != NULL || opts->hybridPrefix != NULL || opts->prince;
+  bool noDict = opts->combineName != NULL || opts->markovName != NULL;
+  int modes = ( opts->hybridSuffix != NULL ) + ( opts->hybridPrefix != NULL ) + opts->prince +
+              ( opts->combineName != NULL ) + ( opts->markovName != NULL ) +
+              ( opts->markovTrain != NULL ) + ( opts->buildIndex != NULL ) +
+              ( opts->hashName != NULL ) + ( opts->benchCount > 0 );
+  if ( modes > 1 || ( opts->pipeline && ( modes > 0 || opts->shmName != NULL || opts->tierCount > 0 ) ) ||
+       ( opts->shmName != NULL && modes > 0 && !expandsDict ) ) {
+    usage();
+  }
+
+  // an audit state covers whole dictionary words tried on every account
+  if ( opts->stateName != NULL && ( modes > 0 || opts->pipeline || opts->policy != NULL ||
+                                    opts->tierCount > 0 ) ) {
+    usage();
+  }
+
+  // hashing has no candidates to filter and nothing to crack
+  if ( ( opts->hashSalt != NULL && opts->hashName == NULL ) ||
+       ( opts->hashName != NULL && ( opts->policy != NULL || opts->dedupeMB > 0 ||
+                                     opts->tierCount > 0 || opts->shmName != NULL ||
+                                     opts->indexName != NULL ) ) ) {
+    usage();
+  }
+
+  // a benchmark makes up its own passwords and cracks nothing
+  if ( opts->benchCount > 0 && ( opts->pipeline || opts->policy != NULL || opts->dedupeMB > 0 ||
+                                 opts->tierCount > 0 || opts->shmName != NULL ||
+                                 opts->indexName != NULL || opts->stateName != NULL ) ) {
+    usage();
+  }
+
+  // NUMA placement chooses the CPUs itself
+  if ( opts->numa && opts->affinity != NULL ) {
+    usage();
+  }
+
+  // a tuning cache is only read by the autotuner
+  if ( opts->tuneName != NULL && !opts->autotune ) {
+    usage();
+  }
+
+  // an index holds the digests of plain dictionary words for one salt
+  if ( ( opts->buildIndex != NULL ) != ( opts->indexSalt != NULL ) ||
+       ( opts->indexName != NULL && ( modes > 0 || opts->pipeline || opts->stateName != NULL ) ) ) {
+    usage();
+  }
+
+  // the daemon takes its jobs, and their settings, from its clients
+  bool serving = opts->daemonName != NULL || opts->connectName != NULL;
+  if ( serving && ( modes > 0 || opts->pipeline || opts->policy != NULL || opts->tierCount > 0 ||
+                    opts->dedupeMB > 0 || opts->stateName != NULL || opts->shmName != NULL ||
+                    ( opts->daemonName != NULL && opts->connectName != NULL ) ) ) {
+    usage();
+  }
+
+  // a plan is for a run that cracks one keyspace it can count up front
+  if ( opts->plan && ( opts->pipeline || opts->stateName != NULL || serving ||
+                       opts->markovTrain != NULL || opts->buildIndex != NULL ||
+                       opts->hashName != NULL || opts->benchCount > 0 ) ) {
+    usage();
+  }
+
+  /**
+   * Find the file names the mode takes: --combine names its own word
+   * lists and --markov needs none, while training, building an index
+   * and the daemon need no shadow file and a client, hashing or a
+   * benchmark needs neither
+   */
+  bool wantDict = !noDict && opts->connectName == NULL && opts->hashName == NULL &&
+                  opts->benchCount == 0;
+  bool wantShadow = opts->markovTrain == NULL && opts->buildIndex == NULL &&
+                    opts->hashName == NULL && opts->benchCount == 0 && !serving;
+  if ( fileCount < wantDict ) {
+    usage();
+  }
+
+  int next = 0;
+  if ( wantDict ) {
+    opts->dictName = files[ next++ ];
+  }
+  while ( next < fileCount ) {
+    // without a dictionary name, one more file than MAX_SHADOWS is accepted
+    if ( opts->shadowCount == MAX_SHADOWS ) {
+      usage();
+    }
+    opts->shadowNames[ opts->shadowCount++ ] = files[ next++ ];
+  }
+
+  // a manifest can stand in for the shadow file names
+  if ( wantShadow ? opts->shadowCount == 0 && opts->manifestName == NULL
+                  : opts->shadowCount > 0 || opts->manifestName != NULL ) {
+    usage();
+  }
+
+  /**
+   * Check for valid file names
+   * 
+   * Standard input is only usable when streaming the dictionary.
+   */
+  if ( wantDict ) {
+    if ( strcmp( opts->dictName, STDIN_DICT_NAME ) == 0 ) {
+      if ( !opts->pipeline ) {
+        usage();
+      }
+    } else if ( strstr( opts->dictName, "dictionary" ) == NULL ) {
+      usage();
+    }
+  }
+
+  for ( int i = 0; i < opts->shadowCount; i++ ) {
+    if ( strstr( opts->shadowNames[ i ], "shadow" ) == NULL ) {
+      usage();
+    }
+  }
+}
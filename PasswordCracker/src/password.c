@@ -14,85 +14,196 @@
 #define PW_ITERATIONS 1000
 
 /**
- * Computes the alternate hash for the given password.
+ * Copies n bytes to the end of a block.  Callers have already made
+ * sure the block has room for them.
  * 
- * Stores alternate hash in altHash array.
+ * @param block block to append to
+ * @param src bytes to append
+ * @param n number of bytes
+ */
+static void putBytes( Block *block, void const *src, int n )
+{
+  memcpy( block->data + block->len, src, n );
+  block->len += n;
+}
+
+/**
+ * Checks that a string can be used as a salt: no longer than
+ * SALT_LENGTH, and made only of SALT_CHARS.
  * 
- * @param pass password to hash
- * @param salt salt string used to hash the given password
+ * @param salt string to check
+ * @return true if it is a valid salt
+ */
+bool isValidSalt( char const *salt )
+{
+  size_t len = strlen( salt );
+  return len <= SALT_LENGTH && strspn( salt, SALT_CHARS ) == len;
+}
+
+/**
+ * Fills in a prepared salt, working out its length once.
+ * 
+ * @param ps prepared salt to fill in
+ * @param salt salt string
+ */
+void prepareSalt( PreparedSalt *ps, char const salt[ SALT_LENGTH + 1 ] )
+{
+  strncpy( ps->str, salt, SALT_LENGTH );
+  ps->str[ SALT_LENGTH ] = '\0';
+  ps->len = strlen( ps->str );
+}
+
+/**
+ * Computes the alternate hash for a prepared password and salt.
+ * 
+ * @param pw prepared password
+ * @param ps prepared salt
  * @param altHash array where the alternate hash is stored
  */
-void computeAlternateHash( char const pass[], char const salt[ SALT_LENGTH + 1 ], byte altHash[ HASH_SIZE ] )
+static void alternateHashPrepared( PreparedWord const *pw, PreparedSalt const *ps, byte altHash[ HASH_SIZE ] )
 {
-  /**
-   * Init empty block
-   */
-  Block *altHashBlock = makeBlock();
+  Block altHashBlock = { .len = 0 };
 
   /**
    * Add password, salt, password again
    */
-  appendString( altHashBlock, pass );
-  appendString( altHashBlock, salt );
-  appendString( altHashBlock, pass );
+  putBytes( &altHashBlock, pw->str, pw->len );
+  putBytes( &altHashBlock, ps->str, ps->len );
+  putBytes( &altHashBlock, pw->str, pw->len );
 
-  /**
-   * calculate alt hash
-   */
-  md5Hash( altHashBlock, altHash );
-  free( altHashBlock );
-  
+  md5Hash( &altHashBlock, altHash );
 }
 
 /**
- * Computes the first intermediate hash from a given password, salt, 
- * and alternate hash.
- * 
- * Intermediate hash stored in intHash.
+ * Computes the first intermediate hash for a prepared password and salt.
  * 
- * @param pass password to hash
- * @param salt salt string used to hash the given password 
- * @param altHash array where the alternate hash is stored
- * @param intHash 
+ * @param pw prepared password
+ * @param ps prepared salt
+ * @param altHash the alternate hash
+ * @param intHash array where the intermediate hash is stored
  */
-void computeFirstIntermediate( char const pass[], char const salt[ SALT_LENGTH + 1 ], byte altHash[ HASH_SIZE ], byte intHash[ HASH_SIZE ] )
+static void firstIntermediatePrepared( PreparedWord const *pw, PreparedSalt const *ps, byte altHash[ HASH_SIZE ], byte intHash[ HASH_SIZE ] )
 {
-  /**
-   * Init empty block
-   */
-  Block *intHashBlock = makeBlock();
-
-  int passwordLength = strlen( pass );
+  Block intHashBlock = { .len = 0 };
+  int passwordLength = pw->len;
 
   /**
-   * Add password, salt, password again
+   * Add password, magic string, salt
    */
-  appendString( intHashBlock, pass );
-  appendString( intHashBlock, "$1$" );
-  appendString( intHashBlock, salt );
+  putBytes( &intHashBlock, pw->str, pw->len );
+  putBytes( &intHashBlock, "$1$", MD5_MAGIC_LENGTH );
+  putBytes( &intHashBlock, ps->str, ps->len );
 
   /**
    * adds passwordLength bytes from altHash to end of intermediateHashBlock
    */
-  for ( int i = 0; i < passwordLength; i++ ) {
-    appendByte( intHashBlock, altHash[ i ] );
-  }
-
+  putBytes( &intHashBlock, altHash, passwordLength );
 
   while ( passwordLength != 0 ) {
     int bit = passwordLength & 0x1;
 
     if ( bit == ZERO_BYTE_FLAG ) {
-      intHashBlock->data[ intHashBlock->len++ ] = 0x00;
-      passwordLength = passwordLength >> SINGLE_BIT_MOVEMENT;
-    } else if ( bit == FIRST_BYTE_FLAG ) {
-      intHashBlock->data[ intHashBlock->len++ ] = intHashBlock->data[ FIRST_BYTE_OF_BLOCK_DATA_IDX ];
-      passwordLength = passwordLength >> SINGLE_BIT_MOVEMENT;
+      intHashBlock.data[ intHashBlock.len++ ] = 0x00;
+    } else {
+      intHashBlock.data[ intHashBlock.len++ ] = intHashBlock.data[ FIRST_BYTE_OF_BLOCK_DATA_IDX ];
     }
+    passwordLength = passwordLength >> SINGLE_BIT_MOVEMENT;
+  }
+
+  md5Hash( &intHashBlock, intHash );
+}
+
+/**
+ * Computes the next intermediate hash for a prepared password and salt.
+ * 
+ * @param pw prepared password
+ * @param ps prepared salt
+ * @param inum iteration number parameter, between 0 and 999
+ * @param intHash where intermediate hash is stored
+ */
+static void nextIntermediatePrepared( PreparedWord const *pw, PreparedSalt const *ps, int inum, byte intHash[ HASH_SIZE ] )
+{
+  Block nextHashBlock = { .len = 0 };
+
+  if ( inum % 2 == 0 ) { // i is even
+    putBytes( &nextHashBlock, intHash, HASH_SIZE );
+  } else {
+    putBytes( &nextHashBlock, pw->str, pw->len );
+  }
+
+  if ( inum % 3 != 0 ) { // i not divisible by 3
+    putBytes( &nextHashBlock, ps->str, ps->len );
+  }
+  if ( inum % 7 != 0 ) { // i not divisible by 7
+    putBytes( &nextHashBlock, pw->str, pw->len );
+  }
+
+  if ( inum % 2 == 0 ) { // i is even
+    putBytes( &nextHashBlock, pw->str, pw->len );
+  } else {
+    putBytes( &nextHashBlock, intHash, HASH_SIZE );
   }
 
-  md5Hash( intHashBlock, intHash );
-  free( intHashBlock );
+  md5Hash( &nextHashBlock, intHash );
+}
+
+/**
+ * Generates the 16-byte hash for a prepared password and salt.  This
+ * is the inner loop of cracking, so it works on blocks on the stack
+ * and never has to measure the password or salt.
+ * 
+ * @param pw prepared password
+ * @param ps prepared salt
+ * @param hash 16-byte hash generated from MD5 hash algo
+ */
+void hashPrepared( PreparedWord const *pw, PreparedSalt const *ps, byte hash[ HASH_SIZE ] )
+{
+  byte altHash[ HASH_SIZE ];
+
+  alternateHashPrepared( pw, ps, altHash );
+  firstIntermediatePrepared( pw, ps, altHash, hash );
+
+  for ( int i = 0; i < PW_ITERATIONS; i++ ) {
+    nextIntermediatePrepared( pw, ps, i, hash );
+  }
+}
+
+/**
+ * Computes the alternate hash for the given password.
+ * 
+ * Stores alternate hash in altHash array.
+ * 
+ * @param pass password to hash
+ * @param salt salt string used to hash the given password
+ * @param altHash array where the alternate hash is stored
+ */
+void computeAlternateHash( char const pass[], char const salt[ SALT_LENGTH + 1 ], byte altHash[ HASH_SIZE ] )
+{
+  PreparedWord pw = { pass, strlen( pass ) };
+  PreparedSalt ps;
+  prepareSalt( &ps, salt );
+
+  alternateHashPrepared( &pw, &ps, altHash );
+}
+
+/**
+ * Computes the first intermediate hash from a given password, salt, 
+ * and alternate hash.
+ * 
+ * Intermediate hash stored in intHash.
+ * 
+ * @param pass password to hash
+ * @param salt salt string used to hash the given password 
+ * @param altHash array where the alternate hash is stored
+ * @param intHash 
+ */
+void computeFirstIntermediate( char const pass[], char const salt[ SALT_LENGTH + 1 ], byte altHash[ HASH_SIZE ], byte intHash[ HASH_SIZE ] )
+{
+  PreparedWord pw = { pass, strlen( pass ) };
+  PreparedSalt ps;
+  prepareSalt( &ps, salt );
+
+  firstIntermediatePrepared( &pw, &ps, altHash, intHash );
 }
 
 /**
@@ -106,37 +217,11 @@ void computeFirstIntermediate( char const pass[], char const salt[ SALT_LENGTH +
  */
 void computeNextIntermediate( char const pass[], char const salt[ SALT_LENGTH + 1 ], int inum, byte intHash[ HASH_SIZE ] )
 {
-  /**
-   * Init empty block
-   */
-  Block *nextHashBlock = makeBlock();
+  PreparedWord pw = { pass, strlen( pass ) };
+  PreparedSalt ps;
+  prepareSalt( &ps, salt );
 
-  if ( inum % 2 == 0 ) { // i is even
-    for ( int i = 0; i < HASH_SIZE; i++ ) {
-      appendByte( nextHashBlock, intHash[ i ] );
-    }
-      if ( inum % 3 != 0 ) { // i not divisible by 3
-      appendString( nextHashBlock, salt );
-      }
-      if ( inum % 7 != 0 ) { // i not divisible by 7
-        appendString( nextHashBlock, pass );
-      }
-    appendString( nextHashBlock, pass );
-  } else { // i is odd
-    appendString( nextHashBlock, pass );
-
-    if ( inum % 3 != 0 ) { // i not divisible by 3
-      appendString( nextHashBlock, salt );
-    }
-    if ( inum % 7 != 0 ) { // i not divisible by 7
-      appendString( nextHashBlock, pass );
-    }
-    for ( int i = 0; i < HASH_SIZE; i++ ) {
-      appendByte( nextHashBlock, intHash[ i ] );
-    }   
-  }
-  md5Hash( nextHashBlock, intHash );
-  free( nextHashBlock );
+  nextIntermediatePrepared( &pw, &ps, inum, intHash );
 }
 
 /**
@@ -208,30 +293,94 @@ void hashToString( byte hash[ HASH_SIZE ], char result[ PW_HASH_LIMIT + 1 ] )
  */
 void hashPassword( char const pass[], char const salt[ SALT_LENGTH + 1 ], char result[ PW_HASH_LIMIT + 1 ] )
 {
-  // all hash arrays
-  byte altHash[ HASH_SIZE ] = { 0 };
   byte intHash[ HASH_SIZE ] = { 0 };
 
-  /**
-   * Make a block, append pass to block
-   */
-  Block *b1 = makeBlock();
-  appendString( b1, pass );
+  hashPasswordRaw( pass, salt, intHash );
+  hashToString( intHash, result );
+}
+
+/**
+ * Generates the 16-byte hash for a password and salt string, without
+ * converting it to printable characters.
+ * 
+ * @param pass password to hash
+ * @param salt salt string used to hash the given password
+ * @param hash 16-byte hash generated from MD5 hash algo
+ */
+void hashPasswordRaw( char const pass[], char const salt[ SALT_LENGTH + 1 ], byte hash[ HASH_SIZE ] )
+{
+  PreparedWord pw = { pass, strlen( pass ) };
+  PreparedSalt ps;
+  prepareSalt( &ps, salt );
+
+  hashPrepared( &pw, &ps, hash );
+}
+
+/**
+ * Returns the 6-bit value of a character from the hash string set,
+ * or -1 if it isn't one of them.
+ * 
+ * @param ch character to look up
+ * @return position of ch in pwCode64
+ */
+static int letterValue( char ch )
+{
+  for ( int i = 0; pwCode64[ i ]; i++ ) {
+    if ( pwCode64[ i ] == ch ) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Converts a password hash string, as made by hashPassword(), back
+ * into the 16-byte hash it encodes.
+ * 
+ * @param str password hash string
+ * @param hash where the 16-byte hash is stored
+ * @return true if str is a valid hash string
+ */
+bool stringToHash( char const str[], byte hash[ HASH_SIZE ] )
+{
+  byte hashRearr[ HASH_SIZE ];
+
+  if ( strlen( str ) != PW_HASH_LIMIT ) {
+    return false;
+  }
 
   /**
-   * alternate hash
-   */
-  computeAlternateHash( pass, salt, altHash );
-  
-  /**
-   * first intermediate hash
+   * Each set of four letters holds 24 bits, least significant first
    */
-  computeFirstIntermediate( pass, salt, altHash, intHash );
+  int strCount = 0;
+  for ( int byteSet = 0; byteSet < HASH_SIZE; byteSet += SET_OF_BYTES ) {
+    int letters = byteSet + SET_OF_BYTES > HASH_SIZE ? LETTERS_IN_LAST_SET : LETTERS_IN_SET;
+    unsigned long bits = 0;
 
-  for ( int i = 0; i < PW_ITERATIONS; i++ ) {
-    computeNextIntermediate( pass, salt, i, intHash );
+    for ( int i = 0; i < letters; i++ ) {
+      int val = letterValue( str[ strCount++ ] );
+      if ( val < 0 ) {
+        return false;
+      }
+      bits |= (unsigned long) val << ( BITS_IN_LETTER * i );
+    }
+
+    for ( int i = 0; i < SET_OF_BYTES && byteSet + i < HASH_SIZE; i++ ) {
+      hashRearr[ byteSet + i ] = bits >> ( BITS_IN_A_BYTE * i );
+    }
+
+    // the last letter may only use the bits left over in the last byte
+    if ( bits >> ( BITS_IN_A_BYTE * SET_OF_BYTES ) ) {
+      return false;
+    }
+    if ( letters == LETTERS_IN_LAST_SET && bits >> BITS_IN_A_BYTE ) {
+      return false;
+    }
   }
 
-  hashToString( intHash, result );
-  free( b1 );
+  for ( int i = 0; i < HASH_SIZE; i++ ) {
+    hash[ pwPerm[ i ] ] = hashRearr[ i ];
+  }
+
+  return true;
 }
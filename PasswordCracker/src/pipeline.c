@@ -0,0 +1,288 @@
+/**
+ * @file pipeline.c
+ * @author Luke Early
+ * Overlaps reading the dictionary with hashing its words.
+ * 
+ * A fixed pool of batches cycles between two rings: the reader takes
+ * an empty batch, fills it from the dictionary and pushes it onto the
+ * full ring; a worker pops it, hashes every word once per salt group
+ * and returns it to the empty ring.
+ */
+
+#include "pipeline.h"
+#include "dictionary.h"
+#include "batch.h"
+#include "bloom.h"
+#include "policy.h"
+#include "groups.h"
+#include "ring.h"
+#include "workers.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+/** State shared by the reader and the hashing workers. */
+typedef struct {
+  // Dictionary stream being read.
+  FILE *fp;
+
+  // Targets to check each word against.
+  TargetStore const *store;
+
+  // Where matches are reported.
+  Results *results;
+
+  // Counters for the run.
+  Stats *stats;
+
+  // Policy words must meet, or NULL to try them all.
+  Policy const *policy;
+
+  // Candidates hashed so far, or NULL to hash repeats too.
+  BloomFilter *filter;
+
+  // Salt groups prepared once for the whole run.
+  PreparedGroup *salts;
+
+  // Batches waiting to be hashed.
+  Ring *full;
+
+  // Batches waiting to be refilled.
+  Ring *empty;
+
+  // Guards the sleep of a thread finding its ring empty, and done.
+  pthread_mutex_t lock;
+
+  // Signalled when a batch goes onto the full ring, or the reader is done.
+  pthread_cond_t filled;
+
+  // Signalled when a batch goes back onto the empty ring.
+  pthread_cond_t emptied;
+
+  // Set by the reader once the last batch is on the full ring.
+  bool done;
+} Pipeline;
+
+/**
+ * Pushes a batch onto one of the rings and wakes a thread that may
+ * be sleeping until that ring has one.
+ * 
+ * @param pl the shared Pipeline
+ * @param ring ring to push to
+ * @param cond condition signalled for that ring
+ * @param item batch to push
+ */
+static void handOver( Pipeline *pl, Ring *ring, pthread_cond_t *cond, void *item )
+{
+  // the rings hold every batch there is, so the push cannot fail
+  ringPush( ring, item );
+  pthread_mutex_lock( &pl->lock );
+  pthread_cond_signal( cond );
+  pthread_mutex_unlock( &pl->lock );
+}
+
+/**
+ * Pops a batch from one of the rings, sleeping while the ring is
+ * empty rather than spinning, so waiting threads leave the CPU to a
+ * slow dictionary producer.  Waiting ends without a batch once the
+ * reader is done.
+ * 
+ * @param pl the shared Pipeline
+ * @param ring ring to pop from
+ * @param cond condition signalled for that ring
+ * @param item where the batch is stored
+ * @return false if the ring is empty and the reader is done
+ */
+static bool takeBatch( Pipeline *pl, Ring *ring, pthread_cond_t *cond, void **item )
+{
+  if ( ringPop( ring, item ) ) {
+    return true;
+  }
+
+  // pushes signal under the lock, so a push after this check cannot be missed
+  pthread_mutex_lock( &pl->lock );
+  bool found;
+  while ( !( found = ringPop( ring, item ) ) && !pl->done ) {
+    pthread_cond_wait( cond, &pl->lock );
+  }
+  pthread_mutex_unlock( &pl->lock );
+  return found;
+}
+
+/**
+ * Reader thread: fills batches from the dictionary until it runs out.
+ * 
+ * @param arg the shared Pipeline
+ * @return always NULL
+ */
+static void *readerMain( void *arg )
+{
+  Pipeline *pl = (Pipeline *)arg;
+  bool more = true;
+  long long next = 0;
+  traceThreadName( "reader" );
+
+  while ( more ) {
+    void *item;
+    takeBatch( pl, pl->empty, &pl->emptied, &item );
+
+    long long span = traceBegin();
+    Batch *batch = (Batch *)item;
+    batch->count = 0;
+    while ( batch->count < batch->cap ) {
+      Password word = "";
+      readDictLine( pl->fp, word );
+      if ( strcmp( word, "" ) == 0 ) {
+        more = false;
+        break;
+      }
+      addCandidate( batch, word, strlen( word ), next++ );
+    }
+    countStat( &pl->stats->candidates, batch->count );
+    traceEnd( "read batch", span );
+
+    if ( batch->count > 0 ) {
+      handOver( pl, pl->full, &pl->filled, batch );
+    } else {
+      ringPush( pl->empty, batch );
+    }
+  }
+
+  pthread_mutex_lock( &pl->lock );
+  pl->done = true;
+  pthread_cond_broadcast( &pl->filled );
+  pthread_mutex_unlock( &pl->lock );
+  return NULL;
+}
+
+/**
+ * Hashes every word of the batch once for each salt group, reporting
+ * the targets it matches.  Words that break the policy, or were
+ * hashed before, are dropped first.
+ * 
+ * @param pl the shared Pipeline
+ * @param batch batch of candidate passwords
+ */
+static void hashBatch( Pipeline *pl, Batch *batch )
+{
+  TargetStore const *store = pl->store;
+  byte hash[ HASH_SIZE ];
+
+  if ( pl->policy != NULL ) {
+    countStat( &pl->stats->violations, dropViolations( pl->policy, batch ) );
+  }
+  if ( pl->filter != NULL ) {
+    countStat( &pl->stats->repeats, dropRepeats( pl->filter, batch ) );
+  }
+
+  for ( int j = 0; j < batch->count; j++ ) {
+    PreparedWord pw = { batch->words[ j ], batch->lens[ j ] };
+
+    for ( int g = 0; g < store->saltCount; g++ ) {
+      if ( !hashGroup( &pl->salts[ g ], &pw, hash ) ) {
+        continue;
+      }
+
+      int k = store->groupStart[ g ];
+      while ( ( k = findInGroup( store, g, hash, k ) ) >= 0 ) {
+        addHit( pl->results, store->order[ k ], batch->index[ j ], batch->words[ j ] );
+        k++;
+      }
+    }
+  }
+
+  countStat( &pl->stats->hashes, (long long) batch->count * store->saltCount );
+}
+
+/**
+ * Worker thread body: hashes batches until the reader is done and
+ * the full ring has been drained.
+ * 
+ * @param id worker number
+ * @param ctx the shared Pipeline
+ */
+static void workerMain( int id, void *ctx )
+{
+  Pipeline *pl = (Pipeline *)ctx;
+
+  while ( true ) {
+    void *item;
+    if ( !takeBatch( pl, pl->full, &pl->filled, &item ) ) {
+      break;
+    }
+
+    long long span = traceBegin();
+    hashBatch( pl, (Batch *)item );
+    traceEnd( "hash batch", span );
+    handOver( pl, pl->empty, &pl->emptied, item );
+    throttleWorker();
+  }
+}
+
+/**
+ * Cracks the given targets by streaming the dictionary through a
+ * reader thread and a set of hashing workers.  The reader fills
+ * fixed-size batches and hands them to the workers through a
+ * bounded ring, so reading overlaps hashing and memory use does
+ * not grow with the size of the dictionary.  Matches are added to
+ * results as soon as they are found.
+ * 
+ * @param fp dictionary stream
+ * @param store targets to crack
+ * @param results where matches are reported
+ * @param threads number of hashing workers
+ * @param policy policy words must meet, or NULL to try them all
+ * @param filter words hashed so far, or NULL to hash repeats too
+ * @param stats counters for the run
+ */
+void crackPipelined( FILE *fp, TargetStore const *store, Results *results, int threads,
+                     Policy const *policy, BloomFilter *filter, Stats *stats )
+{
+  Pipeline pl;
+  Batch *batches[ PIPELINE_DEPTH ];
+
+  pl.fp = fp;
+  pl.store = store;
+  pl.results = results;
+  pl.stats = stats;
+  pl.filter = filter;
+  pl.policy = policy;
+  stats->threads = threads;
+  stats->dedupe = filter != NULL;
+  stats->policy = policy != NULL;
+
+  pl.salts = prepareGroups( store );
+  pl.full = makeRing( PIPELINE_DEPTH );
+  pl.empty = makeRing( PIPELINE_DEPTH );
+  pl.done = false;
+  pthread_mutex_init( &pl.lock, NULL );
+  pthread_cond_init( &pl.filled, NULL );
+  pthread_cond_init( &pl.emptied, NULL );
+
+  for ( int i = 0; i < PIPELINE_DEPTH; i++ ) {
+    batches[ i ] = makeBatch( BATCH_WORDS );
+    ringPush( pl.empty, batches[ i ] );
+  }
+
+  pthread_t reader;
+  if ( pthread_create( &reader, NULL, readerMain, &pl ) != 0 ) {
+    perror( "pthread_create" );
+    exit( EXIT_FAILURE );
+  }
+
+  runWorkers( threads, workerMain, &pl );
+  pthread_join( reader, NULL );
+
+  for ( int i = 0; i < PIPELINE_DEPTH; i++ ) {
+    freeBatch( batches[ i ] );
+  }
+
+  freeGroups( pl.salts, store->saltCount );
+  freeRing( pl.full );
+  freeRing( pl.empty );
+  pthread_cond_destroy( &pl.emptied );
+  pthread_cond_destroy( &pl.filled );
+  pthread_mutex_destroy( &pl.lock );
+}
@@ -0,0 +1,244 @@
+/**
+ * @file plan.c
+ * @author Luke Early
+ * Estimates what a cracking run would cost before it is started.
+ * 
+ * Every candidate is hashed once for each salt group, so the work is
+ * the size of the keyspace times the number of groups.  How long a
+ * hash takes depends on the group's format, and for SHA-crypt on its
+ * rounds, so each format present is timed briefly, SHA-crypt at its
+ * fewest rounds, and every group is scaled from that.
+ */
+
+#include "plan.h"
+#include "groups.h"
+#include "engine.h"
+#include "results.h"
+#include "tune.h"
+#include "stats.h"
+#include "workers.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Number of hash formats. */
+#define FORMAT_COUNT ( FORMAT_SHA512CRYPT + 1 )
+
+/** Seconds in a minute, an hour and a day. */
+#define SECS_PER_MIN 60
+#define SECS_PER_HOUR 3600
+#define SECS_PER_DAY 86400
+
+/** Milliseconds in a second. */
+#define MS_PER_SEC 1000
+
+/** Bytes in a mebibyte. */
+#define BYTES_PER_MB ( 1 << 20 )
+
+/** Names of the hash formats, as printed. */
+static char const *const formatNames[ FORMAT_COUNT ] = {
+  "md5crypt", "raw MD5", "SHA-256-crypt", "SHA-512-crypt"
+};
+
+/**
+ * Writes a duration the way a person would read it, such as
+ * "3d 04h 05m" or "12.5s".
+ * 
+ * @param secs duration in seconds
+ * @param buf where the text is stored
+ */
+void formatDuration( double secs, char buf[ DURATION_LIMIT + 1 ] )
+{
+  if ( secs < SECS_PER_MIN ) {
+    snprintf( buf, DURATION_LIMIT + 1, "%.1fs", secs );
+    return;
+  }
+
+  long long whole = (long long) ( secs + 0.5 );
+  long long days = whole / SECS_PER_DAY;
+  int hours = whole % SECS_PER_DAY / SECS_PER_HOUR;
+  int mins = whole % SECS_PER_HOUR / SECS_PER_MIN;
+  int rest = whole % SECS_PER_MIN;
+
+  if ( days > 0 ) {
+    snprintf( buf, DURATION_LIMIT + 1, "%lldd %02dh %02dm", days, hours, mins );
+  } else if ( hours > 0 ) {
+    snprintf( buf, DURATION_LIMIT + 1, "%dh %02dm %02ds", hours, mins, rest );
+  } else {
+    snprintf( buf, DURATION_LIMIT + 1, "%dm %02ds", mins, rest );
+  }
+}
+
+/**
+ * Times hashing with a prepared group on one thread.
+ * 
+ * @param pg group to hash with
+ * @return passwords hashed per second
+ */
+static double measureGroup( PreparedGroup const *pg )
+{
+  Password words[ PLAN_TRIAL_WORDS ];
+  PreparedWord pws[ PLAN_TRIAL_WORDS ];
+  byte hashes[ PLAN_TRIAL_WORDS ][ HASH_SIZE ];
+  for ( int i = 0; i < PLAN_TRIAL_WORDS; i++ ) {
+    memset( words[ i ], 0, sizeof( Password ) );
+    pws[ i ].str = words[ i ];
+    pws[ i ].len = snprintf( words[ i ], sizeof( Password ), "plan%d", i );
+  }
+
+  Stats timer;
+  initStats( &timer );
+  long long count = 0;
+  double secs;
+  do {
+    if ( !hashGroupBatch( pg, pws, PLAN_TRIAL_WORDS, hashes ) ) {
+      for ( int i = 0; i < PLAN_TRIAL_WORDS; i++ ) {
+        hashGroup( pg, &pws[ i ], hashes[ i ] );
+      }
+    }
+    count += PLAN_TRIAL_WORDS;
+    secs = elapsedSeconds( &timer );
+  } while ( secs * MS_PER_SEC < PLAN_TRIAL_MS );
+
+  return count / secs;
+}
+
+/**
+ * Returns the bytes a word pool holds its words in.
+ * 
+ * @param pool the pool, or NULL
+ * @return bytes of slots and lengths
+ */
+static double poolBytes( WordPool const *pool )
+{
+  return pool == NULL ? 0 : (double) pool->cap * ( sizeof( Password ) + 1 );
+}
+
+/**
+ * Returns the bytes a target store and the run's results for it take.
+ * 
+ * @param store targets
+ * @return bytes of the store's tables, prepared groups and possible hits
+ */
+static double storeBytes( TargetStore const *store )
+{
+  double targets = (double) store->cap * ( HASH_SIZE + 2 * sizeof( int ) + sizeof( bool ) ) +
+                   store->count * sizeof( int ) + store->namesCap;
+  double salts = (double) store->saltCap * ( sizeof( Salt ) + 1 ) +
+                 store->saltIndexCap * sizeof( int ) +
+                 ( store->saltCount + 1 ) * ( sizeof( int ) + sizeof( PreparedGroup ) );
+  return targets + salts + (double) store->count * sizeof( Hit );
+}
+
+/**
+ * Prints what a cracking run would take instead of running it: the
+ * salt groups and candidates, the hashes that makes, how long they
+ * would take with different numbers of workers and how much memory
+ * the run needs.  The speed of each hash format is measured on one of
+ * its groups, except that md5crypt's is taken from this host's
+ * tuning under --autotune.
+ * 
+ * @param ks candidates the run would try
+ * @param store targets
+ * @param dict dictionary words, or NULL
+ * @param right second word list of a combinator run, or NULL
+ * @param opts options for the run
+ * @param fp stream to print the plan to
+ */
+void printPlan( Keyspace const *ks, TargetStore const *store, WordPool const *dict,
+                WordPool const *right, Options const *opts, FILE *fp )
+{
+  int groups[ FORMAT_COUNT ] = { 0 };
+  int ref[ FORMAT_COUNT ];
+  for ( int f = 0; f < FORMAT_COUNT; f++ ) {
+    ref[ f ] = -1;
+  }
+  for ( int g = 0; g < store->saltCount; g++ ) {
+    int f = store->saltFormats[ g ];
+    groups[ f ]++;
+    if ( ref[ f ] < 0 ) {
+      ref[ f ] = g;
+    }
+  }
+
+  /**
+   * Time each format on its first group, or take md5crypt's speed
+   * from the tuning.  SHA-crypt is timed on a copy of the group with
+   * its fewest rounds, since a group can ask for so many that even
+   * one trial batch would take hours
+   */
+  PreparedGroup *pgs = prepareGroups( store );
+  double rate[ FORMAT_COUNT ];
+  Tuning tuning;
+  bool cached = opts->autotune && cachedTuning( opts, &tuning ) && tuning.rate > 0;
+  for ( int f = 0; f < FORMAT_COUNT; f++ ) {
+    if ( ref[ f ] < 0 ) {
+      continue;
+    }
+    PreparedGroup trial = pgs[ ref[ f ] ];
+    if ( f == FORMAT_SHA256CRYPT || f == FORMAT_SHA512CRYPT ) {
+      trial.sha.rounds = SHA_ROUNDS_MIN;
+    }
+    rate[ f ] = f == FORMAT_MD5CRYPT && cached ? tuning.rate : measureGroup( &trial );
+  }
+
+  // SHA-crypt takes time in proportion to its rounds
+  double secs = 0;
+  for ( int g = 0; g < store->saltCount; g++ ) {
+    int f = store->saltFormats[ g ];
+    double cost = 1 / rate[ f ];
+    if ( f == FORMAT_SHA256CRYPT || f == FORMAT_SHA512CRYPT ) {
+      cost *= (double) pgs[ g ].sha.rounds / SHA_ROUNDS_MIN;
+    }
+    secs += ks->size * cost;
+  }
+  freeGroups( pgs, store->saltCount );
+
+  fprintf( fp, "targets:     %d in %d salt groups\n", store->count, store->saltCount );
+  for ( int f = 0; f < FORMAT_COUNT; f++ ) {
+    if ( ref[ f ] >= 0 ) {
+      fprintf( fp, "  %-13s %d groups, %.0f hashes/s per worker", formatNames[ f ], groups[ f ],
+               rate[ f ] );
+      if ( f == FORMAT_SHA256CRYPT || f == FORMAT_SHA512CRYPT ) {
+        fprintf( fp, " at %d rounds", SHA_ROUNDS_MIN );
+      }
+      fprintf( fp, " (%s)\n", f == FORMAT_MD5CRYPT && cached ? "cached" : "measured" );
+    }
+  }
+  fprintf( fp, "candidates:  %lld\n", ks->size );
+  fprintf( fp, "hashes:      %.0f\n", (double) ks->size * store->saltCount );
+
+  /**
+   * Workers past one per core share a core with another, so they are
+   * taken to add nothing
+   */
+  HostKey key;
+  hostKey( &key );
+  int counts[] = { 1, key.cores, key.cpus, workerCount( opts->threads ) };
+  int countLen = sizeof( counts ) / sizeof( counts[ 0 ] );
+  for ( int i = 0; i < countLen; i++ ) {
+    bool seen = false;
+    for ( int j = 0; j < i; j++ ) {
+      seen = seen || counts[ j ] == counts[ i ];
+    }
+    if ( seen ) {
+      continue;
+    }
+
+    char eta[ DURATION_LIMIT + 1 ];
+    formatDuration( secs / ( counts[ i ] < key.cores ? counts[ i ] : key.cores ), eta );
+    fprintf( fp, "time:        %s with %d workers\n", eta, counts[ i ] );
+  }
+
+  /**
+   * Memory for the word lists, the targets, each worker's tile
+   * buffers and the repeat filter
+   */
+  double words = poolBytes( dict ) + poolBytes( right );
+  double targets = storeBytes( store );
+  double tiles = (double) workerCount( opts->threads ) * opts->tileWords *
+                 ( sizeof( Password ) + 1 + sizeof( long long ) + sizeof( PreparedWord ) + HASH_SIZE );
+  double filter = (double) opts->dedupeMB * BYTES_PER_MB;
+  fprintf( fp, "memory:      %.1f MiB (words %.1f, targets %.1f, tiles %.1f, filter %.1f)\n",
+           ( words + targets + tiles + filter ) / BYTES_PER_MB, words / BYTES_PER_MB,
+           targets / BYTES_PER_MB, tiles / BYTES_PER_MB, filter / BYTES_PER_MB );
+}
@@ -0,0 +1,253 @@
+/**
+ * @file policy.c
+ * @author Luke Early
+ * Implements the password policy prefilter, which rejects candidates
+ * a target system would never have accepted.
+ * 
+ * A candidate fits in one 16-byte slot, so on SSE2 machines its
+ * characters are classified all at once: a few compares give a bit
+ * per character for each class, and the policy is checked on those
+ * bits.  Elsewhere, the same bits are built a character at a time.
+ */
+
+#include "policy.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/** Base for numbers in a policy. */
+#define POLICY_BASE 10
+
+/** Number of character classes. */
+#define CLASS_COUNT 4
+
+/** Bits of the characters of a password, one per position. */
+typedef struct {
+  // Positions holding each class of character.
+  int lower;
+  int upper;
+  int digit;
+
+  // Positions holding a forbidden character.
+  int forbidden;
+} CharBits;
+
+#ifdef __SSE2__
+
+/**
+ * Finds which positions of a slot hold which class of character,
+ * sixteen at a time.
+ * 
+ * @param policy policy giving the forbidden characters
+ * @param word the whole slot
+ * @param bits where to put the bits for each class
+ */
+static void classify( Policy const *policy, Password const word, CharBits *bits )
+{
+  __m128i v = _mm_loadu_si128( (__m128i const *) word );
+
+  // signed compares are fine: bytes past 0x7f fall in no range
+  __m128i lower = _mm_and_si128( _mm_cmpgt_epi8( v, _mm_set1_epi8( 'a' - 1 ) ),
+                                 _mm_cmplt_epi8( v, _mm_set1_epi8( 'z' + 1 ) ) );
+  __m128i upper = _mm_and_si128( _mm_cmpgt_epi8( v, _mm_set1_epi8( 'A' - 1 ) ),
+                                 _mm_cmplt_epi8( v, _mm_set1_epi8( 'Z' + 1 ) ) );
+  __m128i digit = _mm_and_si128( _mm_cmpgt_epi8( v, _mm_set1_epi8( '0' - 1 ) ),
+                                 _mm_cmplt_epi8( v, _mm_set1_epi8( '9' + 1 ) ) );
+
+  __m128i forbidden = _mm_setzero_si128();
+  for ( int f = 0; f < policy->forbidCount; f++ ) {
+    forbidden = _mm_or_si128( forbidden, _mm_cmpeq_epi8( v, _mm_set1_epi8( policy->forbid[ f ] ) ) );
+  }
+
+  bits->lower = _mm_movemask_epi8( lower );
+  bits->upper = _mm_movemask_epi8( upper );
+  bits->digit = _mm_movemask_epi8( digit );
+  bits->forbidden = _mm_movemask_epi8( forbidden );
+}
+
+#else
+
+/**
+ * Finds which positions of a slot hold which class of character,
+ * one at a time.
+ * 
+ * @param policy policy giving the forbidden characters
+ * @param word the whole slot
+ * @param bits where to put the bits for each class
+ */
+static void classify( Policy const *policy, Password const word, CharBits *bits )
+{
+  memset( bits, 0, sizeof( CharBits ) );
+
+  for ( int i = 0; i < (int) sizeof( Password ); i++ ) {
+    char c = word[ i ];
+    bits->lower |= ( c >= 'a' && c <= 'z' ) << i;
+    bits->upper |= ( c >= 'A' && c <= 'Z' ) << i;
+    bits->digit |= ( c >= '0' && c <= '9' ) << i;
+    bits->forbidden |= ( memchr( policy->forbid, c, policy->forbidCount ) != NULL ) << i;
+  }
+}
+
+#endif
+
+/**
+ * Reads a count following a rule's name.
+ * 
+ * @param str where the count starts
+ * @param val where to put the count
+ * @return where the count ends, or NULL if there isn't one
+ */
+static char const *readRuleCount( char const *str, int *val )
+{
+  char *end;
+  long n = strtol( str, &end, POLICY_BASE );
+
+  if ( end == str || n < 0 || n > PW_LIMIT ) {
+    return NULL;
+  }
+
+  *val = (int) n;
+  return end;
+}
+
+/**
+ * Checks whether a rule starts with the given name, and if so,
+ * returns where its value starts.
+ * 
+ * @param str where the rule starts
+ * @param name name of the rule, including any "="
+ * @return where the rule's value starts, or NULL if it's not that rule
+ */
+static char const *ruleValue( char const *str, char const *name )
+{
+  size_t len = strlen( name );
+
+  return strncmp( str, name, len ) == 0 ? str + len : NULL;
+}
+
+/**
+ * Parses a policy given as a comma-separated list of rules:
+ * min=N and max=N for the allowed lengths; lower, upper, digit and
+ * symbol for classes that must be used; classes=N for how many
+ * different classes must be used; and forbid=CHARS for characters
+ * that may not be used.
+ * 
+ * @param str policy string
+ * @param policy policy to fill in
+ * @return true if str is a valid policy
+ */
+bool parsePolicy( char const *str, Policy *policy )
+{
+  static char const *classNames[ CLASS_COUNT ] = { "lower", "upper", "digit", "symbol" };
+
+  memset( policy, 0, sizeof( Policy ) );
+  policy->maxLen = PW_LIMIT;
+
+  while ( *str != '\0' ) {
+    char const *end = str + strcspn( str, "," );
+    char const *val;
+
+    if ( ( val = ruleValue( str, "min=" ) ) != NULL ) {
+      str = readRuleCount( val, &policy->minLen );
+    } else if ( ( val = ruleValue( str, "max=" ) ) != NULL ) {
+      str = readRuleCount( val, &policy->maxLen );
+    } else if ( ( val = ruleValue( str, "classes=" ) ) != NULL ) {
+      str = readRuleCount( val, &policy->minClasses );
+    } else if ( ( val = ruleValue( str, "forbid=" ) ) != NULL ) {
+      policy->forbidCount = end - val;
+      if ( policy->forbidCount < 1 || policy->forbidCount > FORBID_LIMIT ) {
+        return false;
+      }
+      memcpy( policy->forbid, val, policy->forbidCount );
+      str = end;
+    } else {
+      // otherwise it names a class that must be used
+      int c = 0;
+      while ( c < CLASS_COUNT && ruleValue( str, classNames[ c ] ) != end ) {
+        c++;
+      }
+      if ( c == CLASS_COUNT ) {
+        return false;
+      }
+      policy->required |= CLASS_LOWER << c;
+      str = end;
+    }
+
+    // each rule ends at a comma, or the end of the policy
+    if ( str != end ) {
+      return false;
+    }
+    if ( *str == ',' ) {
+      str++;
+    }
+  }
+
+  return policy->minLen <= policy->maxLen && policy->minClasses <= CLASS_COUNT;
+}
+
+/**
+ * Reports whether a candidate meets a policy.
+ * 
+ * @param policy policy to check against
+ * @param word the candidate's whole zero-padded slot
+ * @param len length of the candidate
+ * @return true if the candidate meets the policy
+ */
+bool meetsPolicy( Policy const *policy, Password const word, int len )
+{
+  if ( len < policy->minLen || len > policy->maxLen ) {
+    return false;
+  }
+
+  CharBits bits;
+  classify( policy, word, &bits );
+
+  /**
+   * Look only at the candidate's own positions, and count what isn't
+   * a letter or digit as a symbol
+   */
+  int inWord = ( 1 << len ) - 1;
+  int lower = bits.lower & inWord;
+  int upper = bits.upper & inWord;
+  int digit = bits.digit & inWord;
+  int symbol = inWord & ~( lower | upper | digit );
+
+  if ( ( bits.forbidden & inWord ) != 0 ) {
+    return false;
+  }
+
+  int used = ( lower ? CLASS_LOWER : 0 ) | ( upper ? CLASS_UPPER : 0 ) |
+             ( digit ? CLASS_DIGIT : 0 ) | ( symbol ? CLASS_SYMBOL : 0 );
+
+  return ( used & policy->required ) == policy->required &&
+         __builtin_popcount( used ) >= policy->minClasses;
+}
+
+/**
+ * Keeps a candidate if it meets the policy.
+ * 
+ * @param ctx the policy
+ * @param word the candidate's slot
+ * @param len length of the candidate
+ * @return true if the candidate meets the policy
+ */
+static bool keepValid( void *ctx, Password const word, int len )
+{
+  return meetsPolicy( (Policy const *)ctx, word, len );
+}
+
+/**
+ * Removes the candidates that break a policy from a batch, keeping
+ * the order of the rest.
+ * 
+ * @param policy policy to check against
+ * @param batch batch to filter
+ * @return number of candidates removed
+ */
+int dropViolations( Policy const *policy, Batch *batch )
+{
+  return filterBatch( batch, keepValid, (void *)policy );
+}
@@ -0,0 +1,107 @@
+/**
+ * @file pool.c
+ * @author Luke Early
+ * Implements the word pool, a contiguous store of fixed-size
+ * dictionary word slots.
+ */
+
+#include "pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** initial capacity of a pool, in words */
+#define INIT_POOL_CAP 1024
+
+/** factor by which to grow a full pool */
+#define RESIZE_FACTOR 2
+
+/**
+ * Dynamically allocates an empty pool.
+ * 
+ * @return pointer to the newly created pool
+ */
+WordPool *makeWordPool()
+{
+  WordPool *pool = (WordPool *)malloc( sizeof( WordPool ) );
+
+  pool->slots = (Password *)malloc( INIT_POOL_CAP * sizeof( Password ) );
+  pool->lens = (byte *)malloc( INIT_POOL_CAP * sizeof( byte ) );
+  pool->count = 0;
+  pool->cap = INIT_POOL_CAP;
+  pool->ownsSlots = true;
+
+  return pool;
+}
+
+/**
+ * Makes a pool that reads words from slots stored elsewhere.  The
+ * slots are not copied and are not freed with the pool.
+ * 
+ * @param slots existing array of word slots
+ * @param count number of words in slots
+ * @return pointer to the newly created pool
+ */
+WordPool *viewWordPool( Password const *slots, long long count )
+{
+  WordPool *pool = (WordPool *)malloc( sizeof( WordPool ) );
+
+  pool->slots = (Password *)slots;
+  pool->lens = (byte *)malloc( ( count + 1 ) * sizeof( byte ) );
+  pool->count = count;
+  pool->cap = count;
+  pool->ownsSlots = false;
+
+  for ( long long i = 0; i < count; i++ ) {
+    pool->lens[ i ] = strlen( slots[ i ] );
+  }
+
+  return pool;
+}
+
+/**
+ * Frees the memory previously allocated to the given pool.
+ * 
+ * @param pool pool to free
+ */
+void freeWordPool( WordPool *pool )
+{
+  if ( pool->ownsSlots ) {
+    free( pool->slots );
+  }
+  free( pool->lens );
+  free( pool );
+}
+
+/**
+ * Adds a copy of the given word to the end of the pool.
+ * 
+ * @param pool pool to add to
+ * @param word word to add, no longer than PW_LIMIT
+ */
+void appendWord( WordPool *pool, char const *word )
+{
+  if ( pool->count >= pool->cap ) {
+    pool->cap *= RESIZE_FACTOR;
+    pool->slots = (Password *)realloc( pool->slots, pool->cap * sizeof( Password ) );
+    pool->lens = (byte *)realloc( pool->lens, pool->cap * sizeof( byte ) );
+  }
+
+  // zero the whole slot so every byte past the word is padding
+  char *slot = pool->slots[ pool->count ];
+  strncpy( slot, word, sizeof( Password ) );
+  slot[ PW_LIMIT ] = '\0';
+
+  pool->lens[ pool->count ] = strlen( slot );
+  pool->count++;
+}
+
+/**
+ * Returns the number of bytes of memory the pool's words occupy.
+ * 
+ * @param pool pool to measure
+ * @return bytes used by slots and lengths
+ */
+size_t wordPoolBytes( WordPool const *pool )
+{
+  return pool->cap * ( sizeof( Password ) + sizeof( byte ) );
+}
@@ -0,0 +1,240 @@
+/**
+ * @file prince.c
+ * @author Luke Early
+ * Implements the PRINCE keyspace, which chains dictionary words
+ * together into candidates.
+ * 
+ * The words are grouped by length up front.  A chain of word lengths
+ * that fits in a password, like 5+4, stands for every way of picking
+ * a five-letter word and then a four-letter one, so its candidates
+ * can be numbered without ever being written out: each position is
+ * decoded into one word index per element, last element fastest.
+ */
+
+#include "prince.h"
+#include "buckets.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+/** Initial capacity for the list of chains. */
+#define INIT_CHAIN_CAP 64
+
+/** A sequence of word lengths, and the candidates it stands for. */
+typedef struct {
+  // Number of words in the chain.
+  int elems;
+
+  // Length of each word.
+  byte lens[ PW_LIMIT ];
+
+  // Number of candidates in the chain.
+  long long size;
+
+  // First keyspace position of the chain.
+  long long start;
+} Chain;
+
+/** What a PRINCE keyspace needs to produce its candidates. */
+typedef struct {
+  LengthBuckets words;
+
+  // Chains in keyspace order, plus one marking the end.
+  Chain *chains;
+  int chainCount;
+  int chainCap;
+} PrinceState;
+
+/**
+ * Adds a chain to the list, growing it if needed.
+ * 
+ * @param ps state holding the list
+ * @param chain chain to add
+ */
+static void addChain( PrinceState *ps, Chain const *chain )
+{
+  if ( ps->chainCount + 1 >= ps->chainCap ) {
+    ps->chainCap *= 2;
+    ps->chains = (Chain *)realloc( ps->chains, ps->chainCap * sizeof( Chain ) );
+  }
+
+  ps->chains[ ps->chainCount++ ] = *chain;
+}
+
+/**
+ * Adds every chain that extends the given one, and the chain itself
+ * if it isn't empty.  Chains holding more candidates than can be
+ * numbered are left out.
+ * 
+ * @param ps state holding the list of chains
+ * @param chain chain built so far
+ * @param room characters left in the password
+ * @param maxElems largest number of words in a chain
+ */
+static void buildChains( PrinceState *ps, Chain *chain, int room, int maxElems )
+{
+  if ( chain->elems > 0 ) {
+    addChain( ps, chain );
+  }
+  if ( chain->elems == maxElems ) {
+    return;
+  }
+
+  long long size = chain->size;
+  for ( int len = 1; len <= room; len++ ) {
+    long long count = bucketSize( &ps->words, len );
+    if ( count == 0 || size > LLONG_MAX / count ) {
+      continue;
+    }
+
+    chain->lens[ chain->elems++ ] = len;
+    chain->size = size * count;
+    buildChains( ps, chain, room - len, maxElems );
+    chain->elems--;
+  }
+  chain->size = size;
+}
+
+/**
+ * Orders chains by number of words, then by number of candidates,
+ * then by word lengths.
+ * 
+ * @param a first chain
+ * @param b second chain
+ * @return negative, zero, or positive as a comes before, with, or after b
+ */
+static int compareChains( void const *a, void const *b )
+{
+  Chain const *ca = (Chain const *)a;
+  Chain const *cb = (Chain const *)b;
+
+  if ( ca->elems != cb->elems ) {
+    return ca->elems - cb->elems;
+  }
+  if ( ca->size != cb->size ) {
+    return ca->size < cb->size ? -1 : 1;
+  }
+  return memcmp( ca->lens, cb->lens, ca->elems );
+}
+
+/**
+ * Adds the PRINCE candidates at positions start up to end to the
+ * batch.
+ * 
+ * @param ks PRINCE keyspace
+ * @param start first position
+ * @param end position after the last one
+ * @param out batch to add to
+ */
+static void fillPrince( Keyspace const *ks, long long start, long long end, Batch *out )
+{
+  PrinceState const *ps = (PrinceState const *)ks->state;
+
+  /**
+   * Find the chain holding the start position
+   */
+  int lo = 0;
+  int hi = ps->chainCount - 1;
+  while ( lo < hi ) {
+    int mid = ( lo + hi + 1 ) / 2;
+    if ( ps->chains[ mid ].start <= start ) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+
+  long long idx = start;
+  for ( int c = lo; idx < end; c++ ) {
+    Chain const *chain = &ps->chains[ c ];
+    long long chainEnd = ps->chains[ c + 1 ].start < end ? ps->chains[ c + 1 ].start : end;
+    Password cand = "";
+
+    // where each word of the chain goes
+    int at[ PW_LIMIT ];
+    int len = 0;
+    for ( int e = 0; e < chain->elems; e++ ) {
+      at[ e ] = len;
+      len += chain->lens[ e ];
+    }
+
+    /**
+     * Decode each position into one word per element, last element
+     * fastest
+     */
+    for ( ; idx < chainEnd; idx++ ) {
+      long long rest = idx - chain->start;
+      for ( int e = chain->elems - 1; e >= 0; e-- ) {
+        long long count = bucketSize( &ps->words, chain->lens[ e ] );
+        memcpy( cand + at[ e ], bucketWord( &ps->words, chain->lens[ e ], rest % count ),
+                chain->lens[ e ] );
+        rest /= count;
+      }
+
+      addCandidate( out, cand, len, idx );
+    }
+  }
+}
+
+/**
+ * Frees a PRINCE keyspace's state.
+ * 
+ * @param state state to free
+ */
+static void freePrince( void *state )
+{
+  PrinceState *ps = (PrinceState *)state;
+
+  freeBuckets( &ps->words );
+  free( ps->chains );
+  free( ps );
+}
+
+/**
+ * Makes a PRINCE keyspace: every chain of 1 up to maxElems dictionary
+ * words, possibly repeating, that fits in a password.  Chains are
+ * grouped by the lengths of their words, such as 4+3+1, and each such
+ * group covers every combination of words with those lengths.  Groups
+ * with fewer words come first, and among those the smaller groups,
+ * so quick chains finish before the large ones begin.
+ * 
+ * @param dict dictionary words, which must outlive the keyspace
+ * @param maxElems largest number of words in a chain
+ * @return pointer to the newly created keyspace, or NULL if it
+ *         would have too many positions to number
+ */
+Keyspace *makePrinceKeyspace( WordPool const *dict, int maxElems )
+{
+  PrinceState *ps = (PrinceState *)malloc( sizeof( PrinceState ) );
+
+  bucketWords( &ps->words, dict );
+  ps->chainCount = 0;
+  ps->chainCap = INIT_CHAIN_CAP;
+  ps->chains = (Chain *)malloc( ps->chainCap * sizeof( Chain ) );
+
+  Chain chain = { .elems = 0, .size = 1 };
+  buildChains( ps, &chain, PW_LIMIT, maxElems );
+  qsort( ps->chains, ps->chainCount, sizeof( Chain ), compareChains );
+
+  /**
+   * Number the chains' candidates one after another
+   */
+  long long size = 0;
+  for ( int c = 0; c < ps->chainCount; c++ ) {
+    if ( size > LLONG_MAX - ps->chains[ c ].size ) {
+      freePrince( ps );
+      return NULL;
+    }
+    ps->chains[ c ].start = size;
+    size += ps->chains[ c ].size;
+  }
+  ps->chains[ ps->chainCount ].start = size;
+
+  Keyspace *ks = (Keyspace *)malloc( sizeof( Keyspace ) );
+  ks->size = size;
+  ks->fill = fillPrince;
+  ks->cleanup = freePrince;
+  ks->state = ps;
+
+  return ks;
+}
@@ -0,0 +1,350 @@
+/**
+ * @file rawmd5.c
+ * @author Luke Early
+ * Cracks raw MD5 hashes, md5( salt . password ), with an unrolled
+ * single-block MD5.
+ * 
+ * A salted password of at most RAW_SALT_LIMIT + PW_LIMIT bytes always
+ * fits one block with words 9 to 13 and 15 left zero, so those words
+ * are folded out of the steps.  The steps that only read salt words
+ * are run once for the whole group.  Since the last step reads word
+ * 9, which is zero, and the three before it can be undone from the
+ * digest, each target fixes the value b must have after step 59;
+ * candidates that miss every such value are dropped four steps early.
+ */
+
+#include "rawmd5.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Number of salt characters packed in each message word. */
+#define BYTES_PER_WORD 4
+
+/** Index of the message word holding the message length in bits. */
+#define LENGTH_WORD 14
+
+/** Number of message words that can hold salt or password bytes. */
+#define DATA_WORDS 9
+
+/** Shift of the last step, undone to find the state before it. */
+#define LAST_SHIFT 21
+
+/** Round 1 function. */
+#define F( x, y, z ) ( ( z ) ^ ( ( x ) & ( ( y ) ^ ( z ) ) ) )
+
+/** Round 2 function. */
+#define G( x, y, z ) ( ( y ) ^ ( ( z ) & ( ( x ) ^ ( y ) ) ) )
+
+/** Round 3 function. */
+#define H( x, y, z ) ( ( x ) ^ ( y ) ^ ( z ) )
+
+/** Round 4 function. */
+#define I( x, y, z ) ( ( y ) ^ ( ( x ) | ~( z ) ) )
+
+/** Rotates a word left by s bits. */
+#define ROTL( v, s ) ( ( ( v ) << ( s ) ) | ( ( v ) >> ( WORD_BIT_SIZE - ( s ) ) ) )
+
+/** Rotates a word right by s bits. */
+#define ROTR( v, s ) ( ( ( v ) >> ( s ) ) | ( ( v ) << ( WORD_BIT_SIZE - ( s ) ) ) )
+
+/** One MD5 step, updating a in place. */
+#define STEP( f, a, b, c, d, x, i, s ) \
+  ( a ) += f( ( b ), ( c ), ( d ) ) + ( x ) + md5Noise[ i ]; \
+  ( a ) = ROTL( ( a ), s ) + ( b )
+
+/**
+ * Stores a byte of the message in its little-endian word.
+ * 
+ * @param m message words
+ * @param pos position of the byte in the message
+ * @param b the byte
+ */
+static inline void putByte( word *m, int pos, byte b )
+{
+  m[ pos / BYTES_PER_WORD ] |= (word) b << ( BITS_IN_A_BYTE * ( pos % BYTES_PER_WORD ) );
+}
+
+/**
+ * Reads a little-endian word of a digest.
+ * 
+ * @param digest the digest
+ * @param i index of the word
+ * @return the word
+ */
+static word digestWord( byte const digest[ HASH_SIZE ], int i )
+{
+  word w = 0;
+  for ( int j = NUMBER_OF_BYTES_IN_WORD - 1; j >= 0; j-- ) {
+    w = w << BITS_IN_A_BYTE | digest[ i * NUMBER_OF_BYTES_IN_WORD + j ];
+  }
+  return w;
+}
+
+/**
+ * Stores a word of a digest, little-endian.
+ * 
+ * @param digest the digest
+ * @param i index of the word
+ * @param w the word
+ */
+static void putDigestWord( byte digest[ HASH_SIZE ], int i, word w )
+{
+  for ( int j = 0; j < NUMBER_OF_BYTES_IN_WORD; j++ ) {
+    digest[ i * NUMBER_OF_BYTES_IN_WORD + j ] = w >> ( BITS_IN_A_BYTE * j );
+  }
+}
+
+/**
+ * Works out the value b must have after step 59 for the hash to
+ * come out as the given digest, by undoing the last four steps as
+ * far as they can be undone.
+ * 
+ * @param digest the digest
+ * @return the value of b after step 59
+ */
+static word checkValue( byte const digest[ HASH_SIZE ] )
+{
+  word a60 = digestWord( digest, 0 ) - INIT_VALUE_A;
+  word b63 = digestWord( digest, 1 ) - INIT_VALUE_B;
+  word c62 = digestWord( digest, 2 ) - INIT_VALUE_C;
+  word d61 = digestWord( digest, 3 ) - INIT_VALUE_D;
+
+  // step 63 reads word 9, which is always zero
+  return ROTR( b63 - c62, LAST_SHIFT ) - I( c62, d61, a60 ) - md5Noise[ BLOCK_SIZE - 1 ];
+}
+
+/**
+ * Comparison function for sorting check values.
+ * 
+ * @param a pointer to the first value
+ * @param b pointer to the second value
+ * @return negative, zero or positive as a sorts before, with or after b
+ */
+static int compareWords( void const *a, void const *b )
+{
+  word wa = *(word const *)a;
+  word wb = *(word const *)b;
+
+  return wa < wb ? -1 : wa > wb;
+}
+
+/**
+ * Prepares a raw MD5 salt group for cracking.
+ * 
+ * @param rs raw salt to fill in
+ * @param store targets
+ * @param group salt group of the store to prepare
+ */
+void prepareRawSalt( RawSalt *rs, TargetStore const *store, int group )
+{
+  char const *salt = store->salts[ group ];
+
+  memset( rs->block, 0, sizeof( rs->block ) );
+  rs->saltLen = strlen( salt );
+  for ( int i = 0; i < rs->saltLen; i++ ) {
+    putByte( rs->block, i, salt[ i ] );
+  }
+
+  /**
+   * Run the steps of round 1 that only read salt words
+   */
+  word st[ 4 ] = { INIT_VALUE_A, INIT_VALUE_B, INIT_VALUE_C, INIT_VALUE_D };
+  rs->midSteps = rs->saltLen / BYTES_PER_WORD;
+  for ( int i = 0; i < rs->midSteps; i++ ) {
+    int x = ( 4 - i % 4 ) % 4;
+    word b = st[ ( x + 1 ) % 4 ];
+    word c = st[ ( x + 2 ) % 4 ];
+    word d = st[ ( x + 3 ) % 4 ];
+    st[ x ] = b + rotateLeft( st[ x ] + F( b, c, d ) + rs->block[ i ] + md5Noise[ i ], md5Shift[ i ] );
+  }
+  memcpy( rs->mid, st, sizeof( st ) );
+
+  int size = store->groupStart[ group + 1 ] - store->groupStart[ group ];
+  rs->checks = (word *)malloc( ( size + 1 ) * sizeof( word ) );
+  rs->checkCount = 0;
+  for ( int k = store->groupStart[ group ]; k < store->groupStart[ group + 1 ]; k++ ) {
+    int t = store->order[ k ];
+    if ( store->valid[ t ] ) {
+      rs->checks[ rs->checkCount++ ] = checkValue( store->digests[ t ] );
+    }
+  }
+  qsort( rs->checks, rs->checkCount, sizeof( word ), compareWords );
+}
+
+/**
+ * Frees the memory held by a prepared raw salt.
+ * 
+ * @param rs raw salt to free
+ */
+void freeRawSalt( RawSalt *rs )
+{
+  free( rs->checks );
+}
+
+/**
+ * Checks whether a value is one of the group's check values.
+ * 
+ * @param rs prepared raw salt
+ * @param b value of b after step 59
+ * @return true if some target could still match
+ */
+static inline bool anyCheck( RawSalt const *rs, word b )
+{
+  int lo = 0;
+  int hi = rs->checkCount;
+
+  while ( lo < hi ) {
+    int mid = ( lo + hi ) / 2;
+    if ( rs->checks[ mid ] < b ) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo < rs->checkCount && rs->checks[ lo ] == b;
+}
+
+/**
+ * Hashes a password with a prepared raw MD5 salt.  The hash stops
+ * after RAW_CHECK_STEPS steps unless the state could still lead to
+ * one of the group's digests, so most candidates cost less than a
+ * full MD5.
+ * 
+ * @param rs prepared raw salt
+ * @param pw prepared password
+ * @param hash where md5( salt . password ) is stored, if it is finished
+ * @return false if no target of the group can match
+ */
+bool rawHash( RawSalt const *rs, PreparedWord const *pw, byte hash[ HASH_SIZE ] )
+{
+  word m[ DATA_WORDS ];
+  memcpy( m, rs->block, sizeof( m ) );
+
+  int end = rs->saltLen + pw->len;
+  for ( int i = 0; i < pw->len; i++ ) {
+    putByte( m, rs->saltLen + i, pw->str[ i ] );
+  }
+  putByte( m, end, FIRST_VALUE_AFTER_DATA );
+  word len = end * BITS_IN_A_BYTE;
+
+  word a = rs->mid[ 0 ];
+  word b = rs->mid[ 1 ];
+  word c = rs->mid[ 2 ];
+  word d = rs->mid[ 3 ];
+
+  /**
+   * Round 1, starting after the steps already run for the salt
+   */
+  switch ( rs->midSteps ) {
+  case 0:
+    STEP( F, a, b, c, d, m[ 0 ], 0, 7 );
+  case 1:
+    STEP( F, d, a, b, c, m[ 1 ], 1, 12 );
+  case 2:
+    STEP( F, c, d, a, b, m[ 2 ], 2, 17 );
+  case 3:
+    STEP( F, b, c, d, a, m[ 3 ], 3, 22 );
+  case 4:
+    STEP( F, a, b, c, d, m[ 4 ], 4, 7 );
+  case 5:
+    STEP( F, d, a, b, c, m[ 5 ], 5, 12 );
+  }
+  STEP( F, c, d, a, b, m[ 6 ], 6, 17 );
+  STEP( F, b, c, d, a, m[ 7 ], 7, 22 );
+  STEP( F, a, b, c, d, m[ 8 ], 8, 7 );
+  STEP( F, d, a, b, c, 0, 9, 12 );
+  STEP( F, c, d, a, b, 0, 10, 17 );
+  STEP( F, b, c, d, a, 0, 11, 22 );
+  STEP( F, a, b, c, d, 0, 12, 7 );
+  STEP( F, d, a, b, c, 0, 13, 12 );
+  STEP( F, c, d, a, b, len, 14, 17 );
+  STEP( F, b, c, d, a, 0, 15, 22 );
+
+  /**
+   * Round 2
+   */
+  STEP( G, a, b, c, d, m[ 1 ], 16, 5 );
+  STEP( G, d, a, b, c, m[ 6 ], 17, 9 );
+  STEP( G, c, d, a, b, 0, 18, 14 );
+  STEP( G, b, c, d, a, m[ 0 ], 19, 20 );
+  STEP( G, a, b, c, d, m[ 5 ], 20, 5 );
+  STEP( G, d, a, b, c, 0, 21, 9 );
+  STEP( G, c, d, a, b, 0, 22, 14 );
+  STEP( G, b, c, d, a, m[ 4 ], 23, 20 );
+  STEP( G, a, b, c, d, 0, 24, 5 );
+  STEP( G, d, a, b, c, len, 25, 9 );
+  STEP( G, c, d, a, b, m[ 3 ], 26, 14 );
+  STEP( G, b, c, d, a, m[ 8 ], 27, 20 );
+  STEP( G, a, b, c, d, 0, 28, 5 );
+  STEP( G, d, a, b, c, m[ 2 ], 29, 9 );
+  STEP( G, c, d, a, b, m[ 7 ], 30, 14 );
+  STEP( G, b, c, d, a, 0, 31, 20 );
+
+  /**
+   * Round 3
+   */
+  STEP( H, a, b, c, d, m[ 5 ], 32, 4 );
+  STEP( H, d, a, b, c, m[ 8 ], 33, 11 );
+  STEP( H, c, d, a, b, 0, 34, 16 );
+  STEP( H, b, c, d, a, len, 35, 23 );
+  STEP( H, a, b, c, d, m[ 1 ], 36, 4 );
+  STEP( H, d, a, b, c, m[ 4 ], 37, 11 );
+  STEP( H, c, d, a, b, m[ 7 ], 38, 16 );
+  STEP( H, b, c, d, a, 0, 39, 23 );
+  STEP( H, a, b, c, d, 0, 40, 4 );
+  STEP( H, d, a, b, c, m[ 0 ], 41, 11 );
+  STEP( H, c, d, a, b, m[ 3 ], 42, 16 );
+  STEP( H, b, c, d, a, m[ 6 ], 43, 23 );
+  STEP( H, a, b, c, d, 0, 44, 4 );
+  STEP( H, d, a, b, c, 0, 45, 11 );
+  STEP( H, c, d, a, b, 0, 46, 16 );
+  STEP( H, b, c, d, a, m[ 2 ], 47, 23 );
+
+  /**
+   * Round 4, checking the state against the targets before the last steps
+   */
+  STEP( I, a, b, c, d, m[ 0 ], 48, 6 );
+  STEP( I, d, a, b, c, m[ 7 ], 49, 10 );
+  STEP( I, c, d, a, b, len, 50, 15 );
+  STEP( I, b, c, d, a, m[ 5 ], 51, 21 );
+  STEP( I, a, b, c, d, 0, 52, 6 );
+  STEP( I, d, a, b, c, m[ 3 ], 53, 10 );
+  STEP( I, c, d, a, b, 0, 54, 15 );
+  STEP( I, b, c, d, a, m[ 1 ], 55, 21 );
+  STEP( I, a, b, c, d, m[ 8 ], 56, 6 );
+  STEP( I, d, a, b, c, 0, 57, 10 );
+  STEP( I, c, d, a, b, m[ 6 ], 58, 15 );
+  STEP( I, b, c, d, a, 0, 59, 21 );
+
+  if ( !anyCheck( rs, b ) ) {
+    return false;
+  }
+
+  STEP( I, a, b, c, d, m[ 4 ], 60, 6 );
+  STEP( I, d, a, b, c, 0, 61, 10 );
+  STEP( I, c, d, a, b, m[ 2 ], 62, 15 );
+  STEP( I, b, c, d, a, 0, 63, 21 );
+
+  putDigestWord( hash, 0, a + INIT_VALUE_A );
+  putDigestWord( hash, 1, b + INIT_VALUE_B );
+  putDigestWord( hash, 2, c + INIT_VALUE_C );
+  putDigestWord( hash, 3, d + INIT_VALUE_D );
+  return true;
+}
+
+/**
+ * Hashes salt and password with the plain MD5 code, the slow way.
+ * 
+ * @param salt salt string
+ * @param pass password
+ * @param hash where md5( salt . password ) is stored
+ */
+void rawHashSlow( char const *salt, char const *pass, byte hash[ HASH_SIZE ] )
+{
+  Block block;
+  block.len = 0;
+  appendString( &block, salt );
+  appendString( &block, pass );
+  md5Hash( &block, hash );
+}
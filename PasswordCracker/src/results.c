@@ -0,0 +1,132 @@
+/**
+ * @file results.c
+ * @author Luke Early
+ * Collects and reports the passwords that have been cracked.
+ */
+
+#include "results.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/** initial capacity of the hits array */
+#define INIT_HIT_CAP 16
+
+/** factor by which to resize things that are resizeable */
+#define RESIZE_FACTOR 2
+
+/**
+ * Prints a single hit to the results' output stream.
+ * 
+ * @param results results the hit belongs to
+ * @param hit hit to print
+ */
+static void printHit( Results const *results, Hit const *hit )
+{
+  fprintf( results->out, "%s : %s\n", targetName( results->store, hit->target ), hit->pass );
+}
+
+/**
+ * Comparison function for sorting hits by target, then by position.
+ * 
+ * @param a pointer to the first hit
+ * @param b pointer to the second hit
+ * @return negative, zero or positive as a sorts before, with or after b
+ */
+static int compareHits( void const *a, void const *b )
+{
+  Hit const *ha = (Hit const *)a;
+  Hit const *hb = (Hit const *)b;
+
+  if ( ha->target != hb->target ) {
+    return ha->target < hb->target ? -1 : 1;
+  }
+  if ( ha->word != hb->word ) {
+    return ha->word < hb->word ? -1 : 1;
+  }
+  return 0;
+}
+
+/**
+ * Dynamically allocates an empty set of results.
+ * 
+ * @param store store the targets come from
+ * @param stream print each hit as soon as it is added
+ * @return pointer to the newly created results
+ */
+Results *makeResults( TargetStore const *store, bool stream )
+{
+  Results *results = (Results *)malloc( sizeof( Results ) );
+
+  results->store = store;
+  results->stream = stream;
+  results->out = stdout;
+  results->count = 0;
+  results->cap = INIT_HIT_CAP;
+  results->hits = (Hit *)malloc( results->cap * sizeof( Hit ) );
+  pthread_mutex_init( &results->lock, NULL );
+
+  return results;
+}
+
+/**
+ * Frees the memory previously allocated to the given results.
+ * 
+ * @param results results to free
+ */
+void freeResults( Results *results )
+{
+  pthread_mutex_destroy( &results->lock );
+  free( results->hits );
+  free( results );
+}
+
+/**
+ * Records that the given password matches the given target.
+ * 
+ * @param results results to add to
+ * @param target index of the cracked target
+ * @param word position of the password among the candidates
+ * @param pass the password
+ */
+void addHit( Results *results, int target, long long word, char const *pass )
+{
+  Hit hit;
+  hit.target = target;
+  hit.word = word;
+  strncpy( hit.pass, pass, sizeof( Password ) );
+  hit.pass[ PW_LIMIT ] = '\0';
+
+  long long span = traceBegin();
+  pthread_mutex_lock( &results->lock );
+
+  if ( results->stream ) {
+    printHit( results, &hit );
+    fflush( results->out );
+  } else {
+    if ( results->count >= results->cap ) {
+      results->cap *= RESIZE_FACTOR;
+      results->hits = (Hit *)realloc( results->hits, results->cap * sizeof( Hit ) );
+    }
+    results->hits[ results->count++ ] = hit;
+  }
+
+  pthread_mutex_unlock( &results->lock );
+  traceEnd( "report hit", span );
+}
+
+/**
+ * Prints every kept hit, ordered by target and then by candidate
+ * position, as "user : password" lines.
+ * 
+ * @param results results to print
+ */
+void printResults( Results *results )
+{
+  qsort( results->hits, results->count, sizeof( Hit ), compareHits );
+
+  for ( int i = 0; i < results->count; i++ ) {
+    printHit( results, &results->hits[ i ] );
+  }
+}
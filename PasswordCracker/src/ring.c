@@ -0,0 +1,125 @@
+/**
+ * @file ring.c
+ * @author Luke Early
+ * Implements a bounded, lock-free, multi-producer multi-consumer
+ * queue of pointers.
+ * 
+ * Each cell carries a sequence number.  A producer may fill the cell
+ * at position pos once its sequence equals pos, and a consumer may
+ * empty it once its sequence equals pos + 1.  Claiming a position is
+ * a single compare-and-swap on head or tail, so no thread ever waits
+ * on a lock held by another.
+ */
+
+#include "ring.h"
+#include <stdlib.h>
+#include <stdint.h>
+
+/**
+ * Dynamically allocates an empty ring able to hold at least
+ * capacity items.
+ * 
+ * @param capacity minimum number of items the ring can hold
+ * @return pointer to the newly created ring
+ */
+Ring *makeRing( size_t capacity )
+{
+  size_t size = 1;
+  while ( size < capacity ) {
+    size <<= 1;
+  }
+
+  Ring *ring = (Ring *)calloc( 1, sizeof( Ring ) );
+  ring->cells = (RingCell *)malloc( size * sizeof( RingCell ) );
+  ring->mask = size - 1;
+
+  for ( size_t i = 0; i < size; i++ ) {
+    ring->cells[ i ].seq = i;
+    ring->cells[ i ].item = NULL;
+  }
+
+  return ring;
+}
+
+/**
+ * Frees the memory previously allocated to the given ring.
+ * 
+ * @param ring ring to free
+ */
+void freeRing( Ring *ring )
+{
+  free( ring->cells );
+  free( ring );
+}
+
+/**
+ * Adds an item to the ring without blocking.
+ * 
+ * @param ring ring to add to
+ * @param item item to add
+ * @return true if the item was added, false if the ring is full
+ */
+bool ringPush( Ring *ring, void *item )
+{
+  size_t pos = __atomic_load_n( &ring->head, __ATOMIC_RELAXED );
+  RingCell *cell;
+
+  while ( true ) {
+    cell = &ring->cells[ pos & ring->mask ];
+    size_t seq = __atomic_load_n( &cell->seq, __ATOMIC_ACQUIRE );
+    intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+
+    if ( diff == 0 ) {
+      // cell is free for this position, try to claim it
+      if ( __atomic_compare_exchange_n( &ring->head, &pos, pos + 1, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED ) ) {
+        break;
+      }
+    } else if ( diff < 0 ) {
+      // cell still holds an item from the previous lap
+      return false;
+    } else {
+      pos = __atomic_load_n( &ring->head, __ATOMIC_RELAXED );
+    }
+  }
+
+  cell->item = item;
+  __atomic_store_n( &cell->seq, pos + 1, __ATOMIC_RELEASE );
+  return true;
+}
+
+/**
+ * Removes the oldest item from the ring without blocking.
+ * 
+ * @param ring ring to remove from
+ * @param item where the removed item is stored
+ * @return true if an item was removed, false if the ring is empty
+ */
+bool ringPop( Ring *ring, void **item )
+{
+  size_t pos = __atomic_load_n( &ring->tail, __ATOMIC_RELAXED );
+  RingCell *cell;
+
+  while ( true ) {
+    cell = &ring->cells[ pos & ring->mask ];
+    size_t seq = __atomic_load_n( &cell->seq, __ATOMIC_ACQUIRE );
+    intptr_t diff = (intptr_t) seq - (intptr_t) ( pos + 1 );
+
+    if ( diff == 0 ) {
+      // cell holds the item for this position, try to claim it
+      if ( __atomic_compare_exchange_n( &ring->tail, &pos, pos + 1, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED ) ) {
+        break;
+      }
+    } else if ( diff < 0 ) {
+      // nothing has been pushed to this position yet
+      return false;
+    } else {
+      pos = __atomic_load_n( &ring->tail, __ATOMIC_RELAXED );
+    }
+  }
+
+  *item = cell->item;
+  __atomic_store_n( &cell->seq, pos + ring->mask + 1, __ATOMIC_RELEASE );
+  return true;
+}
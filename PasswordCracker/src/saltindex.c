@@ -0,0 +1,271 @@
+/**
+ * @file saltindex.c
+ * @author Luke Early
+ * Builds and reads precomputed digest indexes for a single salt.
+ * 
+ * When the same salt turns up audit after audit, every dictionary
+ * word can be hashed with it once and the digests kept on disk,
+ * sorted.  Any later target with that salt is then answered by a
+ * binary search of the mapped file instead of hashing the whole
+ * dictionary again.
+ */
+
+#include "saltindex.h"
+#include "workers.h"
+#include "bloom.h"
+#include "fileutil.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** Marks a file as holding a salt index, "SIX2" read as bytes. */
+#define SALT_INDEX_MAGIC 0x32584953
+
+/** State shared by the workers building an index, and the writer saving it. */
+typedef struct {
+  SaltIndexHeader hdr;
+  WordPool const *dict;
+  PreparedSalt salt;
+  SaltIndexEntry *entries;
+  int threads;
+} IndexBuild;
+
+/**
+ * Returns a fingerprint of the words of a dictionary, so an index
+ * can only be used with the dictionary it was built from.
+ * 
+ * @param dict dictionary words
+ * @return the dictionary's fingerprint
+ */
+uint64_t dictPrint( WordPool const *dict )
+{
+  return hashBytes( dict->slots, dict->count * sizeof( Password ) );
+}
+
+/**
+ * Worker thread body: hashes every threads-th word, starting at id.
+ * 
+ * @param id worker number
+ * @param ctx the shared IndexBuild
+ */
+static void buildWorker( int id, void *ctx )
+{
+  IndexBuild *build = (IndexBuild *)ctx;
+  WordPool const *dict = build->dict;
+
+  for ( long long i = id; i < dict->count; i += build->threads ) {
+    PreparedWord pw = { dict->slots[ i ], dict->lens[ i ] };
+    hashPrepared( &pw, &build->salt, build->entries[ i ].digest );
+    build->entries[ i ].word = i;
+  }
+}
+
+/**
+ * Comparison function for sorting entries by digest, then by word.
+ * 
+ * @param a pointer to the first entry
+ * @param b pointer to the second entry
+ * @return negative, zero or positive as a sorts before, with or after b
+ */
+static int compareEntries( void const *a, void const *b )
+{
+  SaltIndexEntry const *ea = (SaltIndexEntry const *)a;
+  SaltIndexEntry const *eb = (SaltIndexEntry const *)b;
+
+  int cmp = memcmp( ea->digest, eb->digest, HASH_SIZE );
+  if ( cmp != 0 ) {
+    return cmp;
+  }
+  return ea->word < eb->word ? -1 : ea->word > eb->word;
+}
+
+/**
+ * Writes a built index to a stream: the header and then the sorted
+ * entries.
+ * 
+ * @param fp stream to write to
+ * @param ctx the IndexBuild
+ * @return true if all of it was written
+ */
+static bool writeSaltIndex( FILE *fp, void const *ctx )
+{
+  IndexBuild const *build = (IndexBuild const *)ctx;
+  WordPool const *dict = build->dict;
+
+  return fwrite( &build->hdr, sizeof( SaltIndexHeader ), 1, fp ) == 1 &&
+         (long long) fwrite( build->entries, sizeof( SaltIndexEntry ), dict->count, fp ) == dict->count;
+}
+
+/**
+ * Hashes every dictionary word with the given salt and writes the
+ * sorted digests, with the position of each one's word, to the named
+ * file.
+ * 
+ * @param name index file name
+ * @param salt salt to hash with
+ * @param dict dictionary words
+ * @param threads number of hashing workers
+ * @return true if the file was written
+ */
+bool buildSaltIndex( char const *name, char const *salt, WordPool const *dict, int threads )
+{
+  if ( !isValidSalt( salt ) || dict->count > UINT32_MAX ) {
+    return false;
+  }
+
+  IndexBuild build;
+  memset( &build.hdr, 0, sizeof( SaltIndexHeader ) );
+  build.hdr.magic = SALT_INDEX_MAGIC;
+  strcpy( build.hdr.salt, salt );
+  build.hdr.wordCount = dict->count;
+  build.hdr.dictPrint = dictPrint( dict );
+
+  build.dict = dict;
+  prepareSalt( &build.salt, build.hdr.salt );
+  build.entries = (SaltIndexEntry *)calloc( dict->count + 1, sizeof( SaltIndexEntry ) );
+  build.threads = threads;
+
+  runWorkers( threads, buildWorker, &build );
+  qsort( build.entries, dict->count, sizeof( SaltIndexEntry ), compareEntries );
+
+  bool ok = replaceFile( name, writeSaltIndex, &build );
+  free( build.entries );
+  return ok;
+}
+
+/**
+ * Maps the named index file into memory.
+ * 
+ * @param name index file name
+ * @return the index, or NULL if the file is missing or not a valid index
+ */
+SaltIndex *openSaltIndex( char const *name )
+{
+  int fd = open( name, O_RDONLY );
+  if ( fd < 0 ) {
+    return NULL;
+  }
+
+  struct stat st;
+  void *base = MAP_FAILED;
+  if ( fstat( fd, &st ) == 0 && st.st_size >= (off_t) sizeof( SaltIndexHeader ) ) {
+    base = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+  }
+  close( fd );
+  if ( base == MAP_FAILED ) {
+    return NULL;
+  }
+
+  SaltIndexHeader const *hdr = (SaltIndexHeader const *)base;
+  size_t entryBytes = hdr->wordCount * sizeof( SaltIndexEntry );
+  if ( hdr->magic != SALT_INDEX_MAGIC || hdr->salt[ SALT_LENGTH ] != '\0' ||
+       hdr->wordCount > UINT32_MAX ||
+       (size_t) st.st_size != sizeof( SaltIndexHeader ) + entryBytes ) {
+    munmap( base, st.st_size );
+    return NULL;
+  }
+
+  SaltIndex *index = (SaltIndex *)malloc( sizeof( SaltIndex ) );
+  index->hdr = hdr;
+  index->entries = (SaltIndexEntry const *)( hdr + 1 );
+  index->mapLen = st.st_size;
+  return index;
+}
+
+/**
+ * Unmaps an index and frees its memory.
+ * 
+ * @param index index to close
+ */
+void closeSaltIndex( SaltIndex *index )
+{
+  munmap( (void *)index->hdr, index->mapLen );
+  free( index );
+}
+
+/**
+ * Finds the first entry with the given digest.
+ * 
+ * @param index the index
+ * @param digest digest to look for
+ * @return position of the entry, or the number of entries if there is none
+ */
+static uint64_t findDigest( SaltIndex const *index, byte const digest[ HASH_SIZE ] )
+{
+  uint64_t lo = 0;
+  uint64_t hi = index->hdr->wordCount;
+
+  while ( lo < hi ) {
+    uint64_t mid = lo + ( hi - lo ) / 2;
+    if ( memcmp( index->entries[ mid ].digest, digest, HASH_SIZE ) < 0 ) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+/**
+ * Answers every wanted target that uses the index's salt by looking
+ * its digest up, instead of hashing the dictionary again.  Targets
+ * answered are cleared in wanted, so the rest of the run can skip
+ * them.
+ * 
+ * @param index the index
+ * @param dict dictionary words, the ones the index was built from
+ * @param store targets
+ * @param wanted which targets are still to be cracked
+ * @param results where matches are reported
+ * @param policy policy words must meet, or NULL to allow them all
+ * @param firstOnly report only the first matching word of a target
+ * @return number of targets answered
+ */
+int lookupSaltIndex( SaltIndex const *index, WordPool const *dict, TargetStore const *store,
+                     bool *wanted, Results *results, Policy const *policy, bool firstOnly )
+{
+  int group = 0;
+  while ( group < store->saltCount && ( store->saltFormats[ group ] != FORMAT_MD5CRYPT ||
+                                       strcmp( store->salts[ group ], index->hdr->salt ) != 0 ) ) {
+    group++;
+  }
+  if ( group == store->saltCount ) {
+    return 0;
+  }
+
+  int answered = 0;
+  for ( int k = store->groupStart[ group ]; k < store->groupStart[ group + 1 ]; k++ ) {
+    int target = store->order[ k ];
+    if ( !wanted[ target ] ) {
+      continue;
+    }
+    wanted[ target ] = false;
+    answered++;
+
+    if ( !store->valid[ target ] ) {
+      continue;
+    }
+
+    byte const *digest = store->digests[ target ];
+    for ( uint64_t e = findDigest( index, digest );
+          e < index->hdr->wordCount && memcmp( index->entries[ e ].digest, digest, HASH_SIZE ) == 0;
+          e++ ) {
+      uint32_t w = index->entries[ e ].word;
+      if ( policy != NULL && !meetsPolicy( policy, dict->slots[ w ], dict->lens[ w ] ) ) {
+        continue;
+      }
+
+      addHit( results, target, w, dict->slots[ w ] );
+      if ( firstOnly ) {
+        break;
+      }
+    }
+  }
+
+  return answered;
+}
@@ -0,0 +1,517 @@
+/**
+ * @file sha2.c
+ * @author Luke Early
+ * Implements SHA-256 and SHA-512 hash computation, one message at a
+ * time or several side by side.
+ * 
+ * The multi-buffer functions keep one message in each lane of a GCC
+ * vector, so every operation of the compression function works on
+ * SHA_LANES messages at once.  The compiler turns the vector
+ * operations into whatever SIMD instructions the target has.
+ */
+
+#include "sha2.h"
+#include <string.h>
+
+/** Number of steps in a SHA-256 compression */
+#define SHA256_STEPS 64
+
+/** Number of steps in a SHA-512 compression */
+#define SHA512_STEPS 80
+
+/** Number of message words in a block */
+#define BLOCK_MESSAGE_WORDS 16
+
+/** Bytes at the end of the last SHA-256 block holding the message length */
+#define SHA256_LENGTH_BYTES 8
+
+/** Bytes at the end of the last SHA-512 block holding the message length */
+#define SHA512_LENGTH_BYTES 16
+
+/** Number of bits in a byte */
+#define BITS_PER_BYTE 8
+
+/** First byte of padding after the message */
+#define PAD_START 0x80
+
+/**
+ * Builds the multi-buffer functions a second time for AVX2, used
+ * when the CPU running them has it.  Plain SSE2 has no room for four
+ * 64-bit lanes, so SHA-512 gains little without it.
+ */
+#if defined( __GNUC__ ) && defined( __x86_64__ )
+#define LANE_CLONES __attribute__ (( target_clones( "avx2", "default" ) ))
+#else
+#define LANE_CLONES
+#endif
+
+/** A word from each of SHA_LANES SHA-256 hashes. */
+typedef word Lanes32 __attribute__ (( vector_size( SHA_LANES * sizeof( word ) ) ));
+
+/** A word from each of SHA_LANES SHA-512 hashes. */
+typedef uint64_t Lanes64 __attribute__ (( vector_size( SHA_LANES * sizeof( uint64_t ) ) ));
+
+/** Rotates x, of the given number of bits, right by n bits.  Works on lanes too. */
+#define ROTR( x, n, bits ) ( ( ( x ) >> ( n ) ) | ( ( x ) << ( ( bits ) - ( n ) ) ) )
+
+/** Choice function. */
+#define CH( x, y, z ) ( ( z ) ^ ( ( x ) & ( ( y ) ^ ( z ) ) ) )
+
+/** Majority function. */
+#define MAJ( x, y, z ) ( ( ( x ) & ( y ) ) | ( ( z ) & ( ( x ) | ( y ) ) ) )
+
+/** SHA-256 sigma functions on the state. */
+#define BSIG0_256( x ) ( ROTR( x, 2, 32 ) ^ ROTR( x, 13, 32 ) ^ ROTR( x, 22, 32 ) )
+#define BSIG1_256( x ) ( ROTR( x, 6, 32 ) ^ ROTR( x, 11, 32 ) ^ ROTR( x, 25, 32 ) )
+
+/** SHA-256 sigma functions on the message schedule. */
+#define SSIG0_256( x ) ( ROTR( x, 7, 32 ) ^ ROTR( x, 18, 32 ) ^ ( ( x ) >> 3 ) )
+#define SSIG1_256( x ) ( ROTR( x, 17, 32 ) ^ ROTR( x, 19, 32 ) ^ ( ( x ) >> 10 ) )
+
+/** SHA-512 sigma functions on the state. */
+#define BSIG0_512( x ) ( ROTR( x, 28, 64 ) ^ ROTR( x, 34, 64 ) ^ ROTR( x, 39, 64 ) )
+#define BSIG1_512( x ) ( ROTR( x, 14, 64 ) ^ ROTR( x, 18, 64 ) ^ ROTR( x, 41, 64 ) )
+
+/** SHA-512 sigma functions on the message schedule. */
+#define SSIG0_512( x ) ( ROTR( x, 1, 64 ) ^ ROTR( x, 8, 64 ) ^ ( ( x ) >> 7 ) )
+#define SSIG1_512( x ) ( ROTR( x, 19, 64 ) ^ ROTR( x, 61, 64 ) ^ ( ( x ) >> 6 ) )
+
+/**
+ * Runs the steps of a compression on state variables a to h with
+ * message schedule w, whatever type they are.
+ */
+#define SHA_STEPS( steps, K, BSIG0, BSIG1 ) \
+  for ( int t = 0; t < ( steps ); t++ ) { \
+    t1 = hh + BSIG1( e ) + CH( e, f, g ) + K[ t ] + w[ t ]; \
+    t2 = BSIG0( a ) + MAJ( a, b, c ); \
+    hh = g; \
+    g = f; \
+    f = e; \
+    e = d + t1; \
+    d = c; \
+    c = b; \
+    b = a; \
+    a = t1 + t2; \
+  }
+
+/** SHA-256 round constants, from the cube roots of the first 64 primes. */
+static word const K256[ SHA256_STEPS ] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+  0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+  0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+  0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/** SHA-512 round constants, from the cube roots of the first 80 primes. */
+static uint64_t const K512[ SHA512_STEPS ] = {
+  0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL,
+  0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+  0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+  0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+  0xd807aa98a3030242ULL, 0x12835b0145706fbeULL,
+  0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+  0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL,
+  0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+  0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+  0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+  0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL,
+  0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+  0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL,
+  0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+  0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+  0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+  0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL,
+  0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+  0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL,
+  0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+  0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+  0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+  0xd192e819d6ef5218ULL, 0xd69906245565a910ULL,
+  0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+  0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL,
+  0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+  0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+  0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+  0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL,
+  0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+  0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL,
+  0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+  0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+  0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+  0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL,
+  0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+  0x28db77f523047d84ULL, 0x32caab7b40c72493ULL,
+  0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+  0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+  0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+/** SHA-256 initial values, from the square roots of the first 8 primes. */
+static word const IV256[ 8 ] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+/** SHA-512 initial values, from the square roots of the first 8 primes. */
+static uint64_t const IV512[ 8 ] = {
+  0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+  0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+  0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+  0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+
+};
+
+/**
+ * Reads a big-endian word.
+ * 
+ * @param p first byte of the word
+ * @return the word
+ */
+static inline word load32( byte const *p )
+{
+  return (word) p[ 0 ] << 24 | (word) p[ 1 ] << 16 | (word) p[ 2 ] << 8 | p[ 3 ];
+}
+
+/**
+ * Reads a big-endian 64-bit word.
+ * 
+ * @param p first byte of the word
+ * @return the word
+ */
+static inline uint64_t load64( byte const *p )
+{
+  return (uint64_t) load32( p ) << 32 | load32( p + 4 );
+}
+
+/**
+ * Stores a big-endian word.
+ * 
+ * @param p where the first byte goes
+ * @param v the word
+ */
+static inline void store32( byte *p, word v )
+{
+  p[ 0 ] = v >> 24;
+  p[ 1 ] = v >> 16;
+  p[ 2 ] = v >> 8;
+  p[ 3 ] = v;
+}
+
+/**
+ * Stores a big-endian 64-bit word.
+ * 
+ * @param p where the first byte goes
+ * @param v the word
+ */
+static inline void store64( byte *p, uint64_t v )
+{
+  store32( p, v >> 32 );
+  store32( p + 4, v );
+}
+
+/**
+ * Compresses one SHA-256 block into the chaining values.
+ * 
+ * @param h chaining values
+ * @param block the block
+ */
+static void compress256( word h[ 8 ], byte const block[ SHA256_BLOCK ] )
+{
+  word w[ SHA256_STEPS ];
+  for ( int t = 0; t < BLOCK_MESSAGE_WORDS; t++ ) {
+    w[ t ] = load32( block + t * sizeof( word ) );
+  }
+  for ( int t = BLOCK_MESSAGE_WORDS; t < SHA256_STEPS; t++ ) {
+    w[ t ] = SSIG1_256( w[ t - 2 ] ) + w[ t - 7 ] + SSIG0_256( w[ t - 15 ] ) + w[ t - 16 ];
+  }
+
+  word a = h[ 0 ], b = h[ 1 ], c = h[ 2 ], d = h[ 3 ];
+  word e = h[ 4 ], f = h[ 5 ], g = h[ 6 ], hh = h[ 7 ];
+  word t1, t2;
+  SHA_STEPS( SHA256_STEPS, K256, BSIG0_256, BSIG1_256 );
+
+  h[ 0 ] += a;
+  h[ 1 ] += b;
+  h[ 2 ] += c;
+  h[ 3 ] += d;
+  h[ 4 ] += e;
+  h[ 5 ] += f;
+  h[ 6 ] += g;
+  h[ 7 ] += hh;
+}
+
+/**
+ * Compresses one SHA-512 block into the chaining values.
+ * 
+ * @param h chaining values
+ * @param block the block
+ */
+static void compress512( uint64_t h[ 8 ], byte const block[ SHA512_BLOCK ] )
+{
+  uint64_t w[ SHA512_STEPS ];
+  for ( int t = 0; t < BLOCK_MESSAGE_WORDS; t++ ) {
+    w[ t ] = load64( block + t * sizeof( uint64_t ) );
+  }
+  for ( int t = BLOCK_MESSAGE_WORDS; t < SHA512_STEPS; t++ ) {
+    w[ t ] = SSIG1_512( w[ t - 2 ] ) + w[ t - 7 ] + SSIG0_512( w[ t - 15 ] ) + w[ t - 16 ];
+  }
+
+  uint64_t a = h[ 0 ], b = h[ 1 ], c = h[ 2 ], d = h[ 3 ];
+  uint64_t e = h[ 4 ], f = h[ 5 ], g = h[ 6 ], hh = h[ 7 ];
+  uint64_t t1, t2;
+  SHA_STEPS( SHA512_STEPS, K512, BSIG0_512, BSIG1_512 );
+
+  h[ 0 ] += a;
+  h[ 1 ] += b;
+  h[ 2 ] += c;
+  h[ 3 ] += d;
+  h[ 4 ] += e;
+  h[ 5 ] += f;
+  h[ 6 ] += g;
+  h[ 7 ] += hh;
+}
+
+/**
+ * Starts a SHA-256 hash.
+ * 
+ * @param ctx hash state to start
+ */
+void sha256Init( Sha256 *ctx )
+{
+  memcpy( ctx->h, IV256, sizeof( IV256 ) );
+  ctx->len = 0;
+  ctx->total = 0;
+}
+
+/**
+ * Adds bytes to a SHA-256 hash.
+ * 
+ * @param ctx hash state
+ * @param src bytes to add
+ * @param n number of bytes
+ */
+void sha256Update( Sha256 *ctx, void const *src, size_t n )
+{
+  byte const *p = (byte const *)src;
+  ctx->total += n;
+
+  while ( n > 0 ) {
+    size_t take = SHA256_BLOCK - ctx->len < n ? SHA256_BLOCK - ctx->len : n;
+    memcpy( ctx->buf + ctx->len, p, take );
+    ctx->len += take;
+    p += take;
+    n -= take;
+
+    if ( ctx->len == SHA256_BLOCK ) {
+      compress256( ctx->h, ctx->buf );
+      ctx->len = 0;
+    }
+  }
+}
+
+/**
+ * Pads and finishes a SHA-256 hash.
+ * 
+ * @param ctx hash state
+ * @param digest where the SHA256_DIGEST byte hash is stored
+ */
+void sha256Final( Sha256 *ctx, byte digest[ SHA256_DIGEST ] )
+{
+  uint64_t bits = ctx->total * BITS_PER_BYTE;
+
+  ctx->buf[ ctx->len++ ] = PAD_START;
+  if ( ctx->len > SHA256_BLOCK - SHA256_LENGTH_BYTES ) {
+    memset( ctx->buf + ctx->len, 0, SHA256_BLOCK - ctx->len );
+    compress256( ctx->h, ctx->buf );
+    ctx->len = 0;
+  }
+  memset( ctx->buf + ctx->len, 0, SHA256_BLOCK - ctx->len );
+  store64( ctx->buf + SHA256_BLOCK - sizeof( uint64_t ), bits );
+  compress256( ctx->h, ctx->buf );
+
+  for ( int i = 0; i < 8; i++ ) {
+    store32( digest + i * sizeof( word ), ctx->h[ i ] );
+  }
+}
+
+/**
+ * Starts a SHA-512 hash.
+ * 
+ * @param ctx hash state to start
+ */
+void sha512Init( Sha512 *ctx )
+{
+  memcpy( ctx->h, IV512, sizeof( IV512 ) );
+  ctx->len = 0;
+  ctx->total = 0;
+}
+
+/**
+ * Adds bytes to a SHA-512 hash.
+ * 
+ * @param ctx hash state
+ * @param src bytes to add
+ * @param n number of bytes
+ */
+void sha512Update( Sha512 *ctx, void const *src, size_t n )
+{
+  byte const *p = (byte const *)src;
+  ctx->total += n;
+
+  while ( n > 0 ) {
+    size_t take = SHA512_BLOCK - ctx->len < n ? SHA512_BLOCK - ctx->len : n;
+    memcpy( ctx->buf + ctx->len, p, take );
+    ctx->len += take;
+    p += take;
+    n -= take;
+
+    if ( ctx->len == SHA512_BLOCK ) {
+      compress512( ctx->h, ctx->buf );
+      ctx->len = 0;
+    }
+  }
+}
+
+/**
+ * Pads and finishes a SHA-512 hash.
+ * 
+ * @param ctx hash state
+ * @param digest where the SHA512_DIGEST byte hash is stored
+ */
+void sha512Final( Sha512 *ctx, byte digest[ SHA512_DIGEST ] )
+{
+  uint64_t bits = ctx->total * BITS_PER_BYTE;
+
+  ctx->buf[ ctx->len++ ] = PAD_START;
+  if ( ctx->len > SHA512_BLOCK - SHA512_LENGTH_BYTES ) {
+    memset( ctx->buf + ctx->len, 0, SHA512_BLOCK - ctx->len );
+    compress512( ctx->h, ctx->buf );
+    ctx->len = 0;
+  }
+  memset( ctx->buf + ctx->len, 0, SHA512_BLOCK - ctx->len );
+  store64( ctx->buf + SHA512_BLOCK - sizeof( uint64_t ), bits );
+  compress512( ctx->h, ctx->buf );
+
+  for ( int i = 0; i < 8; i++ ) {
+    store64( digest + i * sizeof( uint64_t ), ctx->h[ i ] );
+  }
+}
+
+/**
+ * Hashes SHA_LANES messages at once, one in each lane of a vector.
+ * The messages must already be padded and all take the same number
+ * of blocks.
+ * 
+ * @param msgs padded messages
+ * @param blocks number of SHA256_BLOCK byte blocks in each message
+ * @param digests where the hashes are stored, in the first
+ *                SHA256_DIGEST bytes of each row
+ */
+LANE_CLONES
+void sha256Lanes( byte msgs[ SHA_LANES ][ SHA_LANE_BYTES ], int blocks,
+                  byte digests[ SHA_LANES ][ SHA512_DIGEST ] )
+{
+  Lanes32 h[ 8 ];
+  for ( int i = 0; i < 8; i++ ) {
+    for ( int lane = 0; lane < SHA_LANES; lane++ ) {
+      h[ i ][ lane ] = IV256[ i ];
+    }
+  }
+
+  for ( int blk = 0; blk < blocks; blk++ ) {
+    Lanes32 w[ SHA256_STEPS ];
+    for ( int t = 0; t < BLOCK_MESSAGE_WORDS; t++ ) {
+      for ( int lane = 0; lane < SHA_LANES; lane++ ) {
+        w[ t ][ lane ] = load32( msgs[ lane ] + blk * SHA256_BLOCK + t * sizeof( word ) );
+      }
+    }
+    for ( int t = BLOCK_MESSAGE_WORDS; t < SHA256_STEPS; t++ ) {
+      w[ t ] = SSIG1_256( w[ t - 2 ] ) + w[ t - 7 ] + SSIG0_256( w[ t - 15 ] ) + w[ t - 16 ];
+    }
+
+    Lanes32 a = h[ 0 ], b = h[ 1 ], c = h[ 2 ], d = h[ 3 ];
+    Lanes32 e = h[ 4 ], f = h[ 5 ], g = h[ 6 ], hh = h[ 7 ];
+    Lanes32 t1, t2;
+    SHA_STEPS( SHA256_STEPS, K256, BSIG0_256, BSIG1_256 );
+
+    h[ 0 ] += a;
+    h[ 1 ] += b;
+    h[ 2 ] += c;
+    h[ 3 ] += d;
+    h[ 4 ] += e;
+    h[ 5 ] += f;
+    h[ 6 ] += g;
+    h[ 7 ] += hh;
+  }
+
+  for ( int lane = 0; lane < SHA_LANES; lane++ ) {
+    for ( int i = 0; i < 8; i++ ) {
+      store32( digests[ lane ] + i * sizeof( word ), h[ i ][ lane ] );
+    }
+  }
+}
+
+/**
+ * Hashes SHA_LANES messages at once, one in each lane of a vector.
+ * The messages must already be padded and all take the same number
+ * of blocks.
+ * 
+ * @param msgs padded messages
+ * @param blocks number of SHA512_BLOCK byte blocks in each message
+ * @param digests where the hashes are stored
+ */
+LANE_CLONES
+void sha512Lanes( byte msgs[ SHA_LANES ][ SHA_LANE_BYTES ], int blocks,
+                  byte digests[ SHA_LANES ][ SHA512_DIGEST ] )
+{
+  Lanes64 h[ 8 ];
+  for ( int i = 0; i < 8; i++ ) {
+    for ( int lane = 0; lane < SHA_LANES; lane++ ) {
+      h[ i ][ lane ] = IV512[ i ];
+    }
+  }
+
+  for ( int blk = 0; blk < blocks; blk++ ) {
+    Lanes64 w[ SHA512_STEPS ];
+    for ( int t = 0; t < BLOCK_MESSAGE_WORDS; t++ ) {
+      for ( int lane = 0; lane < SHA_LANES; lane++ ) {
+        w[ t ][ lane ] = load64( msgs[ lane ] + blk * SHA512_BLOCK + t * sizeof( uint64_t ) );
+      }
+    }
+    for ( int t = BLOCK_MESSAGE_WORDS; t < SHA512_STEPS; t++ ) {
+      w[ t ] = SSIG1_512( w[ t - 2 ] ) + w[ t - 7 ] + SSIG0_512( w[ t - 15 ] ) + w[ t - 16 ];
+    }
+
+    Lanes64 a = h[ 0 ], b = h[ 1 ], c = h[ 2 ], d = h[ 3 ];
+    Lanes64 e = h[ 4 ], f = h[ 5 ], g = h[ 6 ], hh = h[ 7 ];
+    Lanes64 t1, t2;
+    SHA_STEPS( SHA512_STEPS, K512, BSIG0_512, BSIG1_512 );
+
+    h[ 0 ] += a;
+    h[ 1 ] += b;
+    h[ 2 ] += c;
+    h[ 3 ] += d;
+    h[ 4 ] += e;
+    h[ 5 ] += f;
+    h[ 6 ] += g;
+    h[ 7 ] += hh;
+  }
+
+  for ( int lane = 0; lane < SHA_LANES; lane++ ) {
+    for ( int i = 0; i < 8; i++ ) {
+      store64( digests[ lane ] + i * sizeof( uint64_t ), h[ i ][ lane ] );
+    }
+  }
+}
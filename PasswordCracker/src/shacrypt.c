@@ -0,0 +1,463 @@
+/**
+ * @file shacrypt.c
+ * @author Luke Early
+ * Implements the SHA-crypt password hashes, "$5$" with SHA-256 and
+ * "$6$" with SHA-512.
+ * 
+ * Thousands of rounds make these hashes slow on purpose.  Passwords
+ * of the same length hashed with the same setting give messages of
+ * the same length in every round, so SHA_LANES of them can go
+ * through the rounds together on the multi-buffer SHA-2 functions.
+ */
+
+#include "shacrypt.h"
+#include "magic.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/** Start of a setting that gives the number of rounds */
+#define ROUNDS_PREFIX "rounds="
+
+/** Salt repeats added to the salt digest beyond the first digest byte */
+#define SALT_REPEAT_BASE 16
+
+/** First byte of padding after a message */
+#define PAD_START 0x80
+
+/** Number of bits in a byte */
+#define BITS_PER_BYTE 8
+
+/** Bytes at the end of a SHA-256 message holding its length */
+#define SHA256_LENGTH_BYTES 8
+
+/** Bytes at the end of a SHA-512 message holding its length */
+#define SHA512_LENGTH_BYTES 16
+
+/** Number of digest bytes encoded by each group of characters */
+#define GROUP_BYTES 3
+
+/** Number of characters for a full group of bytes */
+#define GROUP_CHARS 4
+
+/** Number of bits each character encodes */
+#define CHAR_BITS 6
+
+/** Mask for the bits of one character */
+#define CHAR_MASK 0x3F
+
+/** Number of characters in the last group of a SHA-256 hash */
+#define SHA256_TAIL_CHARS 3
+
+/** Number of characters in the last group of a SHA-512 hash */
+#define SHA512_TAIL_CHARS 2
+
+/** Rounds whose number is a multiple of this leave the salt out */
+#define SALT_SKIP_PERIOD 3
+
+/** Rounds whose number is a multiple of this leave the second password out */
+#define PASS_SKIP_PERIOD 7
+
+/**
+ * Order the bytes of a SHA-256 digest are printed in, three to a
+ * group of characters; -1 stands for a zero byte.
+ */
+static int const ORDER256[ 33 ] = {
+   0, 10, 20,
+  21,  1, 11,
+  12, 22,  2,
+   3, 13, 23,
+  24,  4, 14,
+  15, 25,  5,
+   6, 16, 26,
+  27,  7, 17,
+  18, 28,  8,
+   9, 19, 29,
+  -1, 31, 30
+};
+
+/**
+ * Order the bytes of a SHA-512 digest are printed in, three to a
+ * group of characters; -1 stands for a zero byte.
+ */
+static int const ORDER512[ 66 ] = {
+   0, 21, 42,
+  22, 43,  1,
+  44,  2, 23,
+   3, 24, 45,
+  25, 46,  4,
+  47,  5, 26,
+   6, 27, 48,
+  28, 49,  7,
+  50,  8, 29,
+   9, 30, 51,
+  31, 52, 10,
+  53, 11, 32,
+  12, 33, 54,
+  34, 55, 13,
+  56, 14, 35,
+  15, 36, 57,
+  37, 58, 16,
+  59, 17, 38,
+  18, 39, 60,
+  40, 61, 19,
+  62, 20, 41,
+  -1, -1, 63
+};
+
+/** A SHA-256 or SHA-512 hash being computed. */
+typedef struct {
+  int digestLen;
+  Sha256 s256;
+  Sha512 s512;
+} ShaContext;
+
+/**
+ * Starts a hash.
+ * 
+ * @param ctx hash to start
+ * @param digestLen SHA256_DIGEST or SHA512_DIGEST
+ */
+static void ctxInit( ShaContext *ctx, int digestLen )
+{
+  ctx->digestLen = digestLen;
+  if ( digestLen == SHA512_DIGEST ) {
+    sha512Init( &ctx->s512 );
+  } else {
+    sha256Init( &ctx->s256 );
+  }
+}
+
+/**
+ * Adds bytes to a hash.
+ * 
+ * @param ctx the hash
+ * @param src bytes to add
+ * @param n number of bytes
+ */
+static void ctxUpdate( ShaContext *ctx, void const *src, size_t n )
+{
+  if ( ctx->digestLen == SHA512_DIGEST ) {
+    sha512Update( &ctx->s512, src, n );
+  } else {
+    sha256Update( &ctx->s256, src, n );
+  }
+}
+
+/**
+ * Finishes a hash.
+ * 
+ * @param ctx the hash
+ * @param digest where the digest is stored
+ */
+static void ctxFinal( ShaContext *ctx, byte digest[ SHA512_DIGEST ] )
+{
+  if ( ctx->digestLen == SHA512_DIGEST ) {
+    sha512Final( &ctx->s512, digest );
+  } else {
+    sha256Final( &ctx->s256, digest );
+  }
+}
+
+/**
+ * Parses a SHA-crypt setting, the part of a hash between the "$5$"
+ * or "$6$" and the final '$'.
+ * 
+ * @param ss where the setting is stored
+ * @param digestLen SHA256_DIGEST for "$5$" or SHA512_DIGEST for "$6$"
+ * @param setting "salt" or "rounds=N$salt"
+ * @return true if the setting is valid
+ */
+bool parseShaSetting( ShaSalt *ss, int digestLen, char const *setting )
+{
+  ss->digestLen = digestLen;
+  ss->rounds = SHA_ROUNDS_DEFAULT;
+
+  size_t prefixLen = strlen( ROUNDS_PREFIX );
+  if ( strncmp( setting, ROUNDS_PREFIX, prefixLen ) == 0 ) {
+    char *end;
+    if ( !isdigit( (unsigned char) setting[ prefixLen ] ) ) {
+      return false;
+    }
+    unsigned long rounds = strtoul( setting + prefixLen, &end, 10 );
+    if ( *end != '$' ) {
+      return false;
+    }
+
+    ss->rounds = rounds < SHA_ROUNDS_MIN ? SHA_ROUNDS_MIN :
+                 rounds > SHA_ROUNDS_MAX ? SHA_ROUNDS_MAX : (long) rounds;
+    setting = end + 1;
+  }
+
+  size_t saltLen = strlen( setting );
+  if ( saltLen > SHA_SALT_MAX || strchr( setting, '$' ) != NULL ) {
+    return false;
+  }
+
+  strcpy( ss->salt, setting );
+  ss->saltLen = saltLen;
+  return true;
+}
+
+/**
+ * Returns the print order and last group size for a digest length.
+ * 
+ * @param digestLen SHA256_DIGEST or SHA512_DIGEST
+ * @param groups where the number of groups is stored
+ * @param tailChars where the number of characters of the last group is stored
+ * @return the print order
+ */
+static int const *printOrder( int digestLen, int *groups, int *tailChars )
+{
+  if ( digestLen == SHA512_DIGEST ) {
+    *groups = sizeof( ORDER512 ) / sizeof( int ) / GROUP_BYTES;
+    *tailChars = SHA512_TAIL_CHARS;
+    return ORDER512;
+  }
+
+  *groups = sizeof( ORDER256 ) / sizeof( int ) / GROUP_BYTES;
+  *tailChars = SHA256_TAIL_CHARS;
+  return ORDER256;
+}
+
+/**
+ * Converts a SHA-crypt digest to its printable form.
+ * 
+ * @param digestLen SHA256_DIGEST or SHA512_DIGEST
+ * @param digest the digest
+ * @param result printable hash
+ */
+void shaHashToString( int digestLen, byte const digest[ SHA512_DIGEST ], char result[ SHA_HASH_LIMIT + 1 ] )
+{
+  int groups, tailChars;
+  int const *order = printOrder( digestLen, &groups, &tailChars );
+  int len = 0;
+
+  for ( int g = 0; g < groups; g++ ) {
+    word w = 0;
+    for ( int j = 0; j < GROUP_BYTES; j++ ) {
+      int at = order[ g * GROUP_BYTES + j ];
+      w = w << BITS_PER_BYTE | ( at < 0 ? 0 : digest[ at ] );
+    }
+
+    int chars = g == groups - 1 ? tailChars : GROUP_CHARS;
+    for ( int j = 0; j < chars; j++ ) {
+      result[ len++ ] = pwCode64[ w & CHAR_MASK ];
+      w >>= CHAR_BITS;
+    }
+  }
+
+  result[ len ] = '\0';
+}
+
+/**
+ * Converts a printable SHA-crypt hash back into the digest it encodes.
+ * 
+ * @param digestLen SHA256_DIGEST or SHA512_DIGEST
+ * @param str printable hash
+ * @param digest where the digest is stored
+ * @return true if str is a valid hash of that length
+ */
+bool shaStringToHash( int digestLen, char const *str, byte digest[ SHA512_DIGEST ] )
+{
+  int groups, tailChars;
+  int const *order = printOrder( digestLen, &groups, &tailChars );
+  if ( strlen( str ) != ( groups - 1 ) * GROUP_CHARS + tailChars ) {
+    return false;
+  }
+
+  memset( digest, 0, SHA512_DIGEST );
+  for ( int g = 0; g < groups; g++ ) {
+    int chars = g == groups - 1 ? tailChars : GROUP_CHARS;
+    word w = 0;
+    for ( int j = chars - 1; j >= 0; j-- ) {
+      char const *ch = strchr( pwCode64, str[ g * GROUP_CHARS + j ] );
+      if ( str[ g * GROUP_CHARS + j ] == '\0' || ch == NULL ) {
+        return false;
+      }
+      w = w << CHAR_BITS | ( ch - pwCode64 );
+    }
+
+    for ( int j = GROUP_BYTES - 1; j >= 0; j-- ) {
+      int at = order[ g * GROUP_BYTES + j ];
+      if ( at >= 0 ) {
+        digest[ at ] = w;
+      }
+      w >>= BITS_PER_BYTE;
+    }
+  }
+
+  // the last group has spare bits, which must be clear
+  char check[ SHA_HASH_LIMIT + 1 ];
+  shaHashToString( digestLen, digest, check );
+  return strcmp( check, str ) == 0;
+}
+
+/**
+ * Works out the digest the rounds start from and the byte strings
+ * that stand in for the password and salt during the rounds.
+ * 
+ * @param ss prepared setting
+ * @param pass password
+ * @param len length of the password
+ * @param start where the starting digest is stored
+ * @param pBytes where the password's stand-in is stored, len bytes
+ * @param sBytes where the salt's stand-in is stored, ss->saltLen bytes
+ */
+static void shaPrepare( ShaSalt const *ss, char const *pass, int len, byte start[ SHA512_DIGEST ],
+                        byte pBytes[ SHA512_DIGEST ], byte sBytes[ SHA512_DIGEST ] )
+{
+  int dl = ss->digestLen;
+  ShaContext ctx;
+  byte alt[ SHA512_DIGEST ];
+
+  ctxInit( &ctx, dl );
+  ctxUpdate( &ctx, pass, len );
+  ctxUpdate( &ctx, ss->salt, ss->saltLen );
+  ctxUpdate( &ctx, pass, len );
+  ctxFinal( &ctx, alt );
+
+  ctxInit( &ctx, dl );
+  ctxUpdate( &ctx, pass, len );
+  ctxUpdate( &ctx, ss->salt, ss->saltLen );
+  int cnt;
+  for ( cnt = len; cnt > dl; cnt -= dl ) {
+    ctxUpdate( &ctx, alt, dl );
+  }
+  ctxUpdate( &ctx, alt, cnt );
+  for ( cnt = len; cnt > 0; cnt >>= 1 ) {
+    if ( cnt & 1 ) {
+      ctxUpdate( &ctx, alt, dl );
+    } else {
+      ctxUpdate( &ctx, pass, len );
+    }
+  }
+  ctxFinal( &ctx, start );
+
+  // passwords are never longer than a digest, so one copy covers them
+  ctxInit( &ctx, dl );
+  for ( cnt = 0; cnt < len; cnt++ ) {
+    ctxUpdate( &ctx, pass, len );
+  }
+  ctxFinal( &ctx, pBytes );
+
+  ctxInit( &ctx, dl );
+  for ( cnt = 0; cnt < SALT_REPEAT_BASE + start[ 0 ]; cnt++ ) {
+    ctxUpdate( &ctx, ss->salt, ss->saltLen );
+  }
+  ctxFinal( &ctx, sBytes );
+}
+
+/**
+ * Computes the SHA-crypt digest of one password, the plain way.
+ * 
+ * @param ss prepared setting
+ * @param pass password
+ * @param len length of the password, at most SHA_PASS_MAX
+ * @param digest where the digest is stored
+ */
+void shaCrypt( ShaSalt const *ss, char const *pass, int len, byte digest[ SHA512_DIGEST ] )
+{
+  int dl = ss->digestLen;
+  byte pBytes[ SHA512_DIGEST ];
+  byte sBytes[ SHA512_DIGEST ];
+  shaPrepare( ss, pass, len, digest, pBytes, sBytes );
+
+  ShaContext ctx;
+  for ( long r = 0; r < ss->rounds; r++ ) {
+    ctxInit( &ctx, dl );
+    if ( r & 1 ) {
+      ctxUpdate( &ctx, pBytes, len );
+    } else {
+      ctxUpdate( &ctx, digest, dl );
+    }
+    if ( r % SALT_SKIP_PERIOD != 0 ) {
+      ctxUpdate( &ctx, sBytes, ss->saltLen );
+    }
+    if ( r % PASS_SKIP_PERIOD != 0 ) {
+      ctxUpdate( &ctx, pBytes, len );
+    }
+    if ( r & 1 ) {
+      ctxUpdate( &ctx, digest, dl );
+    } else {
+      ctxUpdate( &ctx, pBytes, len );
+    }
+    ctxFinal( &ctx, digest );
+  }
+}
+
+/**
+ * Computes the SHA-crypt digests of SHA_LANES passwords of the same
+ * length at once.  Every round hashes a message of the same length
+ * for each of them, so the rounds run on all the lanes together.
+ * 
+ * @param ss prepared setting
+ * @param pass passwords, which may repeat
+ * @param len length of every password, at most SHA_PASS_MAX
+ * @param digests where the digests are stored
+ */
+void shaCryptLanes( ShaSalt const *ss, char const *pass[ SHA_LANES ], int len,
+                    byte digests[ SHA_LANES ][ SHA512_DIGEST ] )
+{
+  int dl = ss->digestLen;
+  int blockLen = dl == SHA512_DIGEST ? SHA512_BLOCK : SHA256_BLOCK;
+  int lengthBytes = dl == SHA512_DIGEST ? SHA512_LENGTH_BYTES : SHA256_LENGTH_BYTES;
+  byte pBytes[ SHA_LANES ][ SHA512_DIGEST ];
+  byte sBytes[ SHA_LANES ][ SHA512_DIGEST ];
+  byte msgs[ SHA_LANES ][ SHA_LANE_BYTES ];
+
+  for ( int lane = 0; lane < SHA_LANES; lane++ ) {
+    shaPrepare( ss, pass[ lane ], len, digests[ lane ], pBytes[ lane ], sBytes[ lane ] );
+  }
+
+  for ( long r = 0; r < ss->rounds; r++ ) {
+    int n = 0;
+    for ( int lane = 0; lane < SHA_LANES; lane++ ) {
+      byte *msg = msgs[ lane ];
+      n = 0;
+      if ( r & 1 ) {
+        memcpy( msg, pBytes[ lane ], len );
+        n = len;
+      } else {
+        memcpy( msg, digests[ lane ], dl );
+        n = dl;
+      }
+      if ( r % SALT_SKIP_PERIOD != 0 ) {
+        memcpy( msg + n, sBytes[ lane ], ss->saltLen );
+        n += ss->saltLen;
+      }
+      if ( r % PASS_SKIP_PERIOD != 0 ) {
+        memcpy( msg + n, pBytes[ lane ], len );
+        n += len;
+      }
+      if ( r & 1 ) {
+        memcpy( msg + n, digests[ lane ], dl );
+        n += dl;
+      } else {
+        memcpy( msg + n, pBytes[ lane ], len );
+        n += len;
+      }
+    }
+
+    /**
+     * Pad every message the same way, since they're all n bytes
+     */
+    int blocks = ( n + 1 + lengthBytes + blockLen - 1 ) / blockLen;
+    int end = blocks * blockLen;
+    uint64_t bits = (uint64_t) n * BITS_PER_BYTE;
+    for ( int lane = 0; lane < SHA_LANES; lane++ ) {
+      byte *msg = msgs[ lane ];
+      msg[ n ] = PAD_START;
+      memset( msg + n + 1, 0, end - n - 1 );
+      for ( int j = 1; j <= (int) sizeof( uint64_t ); j++ ) {
+        msg[ end - j ] = bits >> ( BITS_PER_BYTE * ( j - 1 ) );
+      }
+    }
+
+    if ( dl == SHA512_DIGEST ) {
+      sha512Lanes( msgs, blocks, digests );
+    } else {
+      sha256Lanes( msgs, blocks, digests );
+    }
+  }
+}
@@ -0,0 +1,390 @@
+/**
+ * @file shadow.c
+ * @author Luke Early
+ * Reads the user entries of a shadow file.
+ */
+
+#include "shadow.h"
+#include "shacrypt.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** number of excess shadow file characters */
+#define EXCESS_SHADOW 18
+
+/** length of the MD5 ID */
+#define MD5_ID_HASH_LENGTH 3
+
+/** ID that starts a raw MD5 hash */
+#define RAW_ID "$raw-md5$"
+
+/** length of the rest of the raw MD5 ID, after its first three characters */
+#define RAW_ID_LENGTH 6
+
+/** ID that starts a SHA-256 crypt hash */
+#define SHA256_ID "$5$"
+
+/** ID that starts a SHA-512 crypt hash */
+#define SHA512_ID "$6$"
+
+/** longest "salt$hash" part of a raw MD5 or SHA-crypt entry that is read */
+#define TOKEN_LIMIT 128
+
+/** TOKEN_LIMIT, as a scanf field width */
+#define TOKEN_FORMAT "128"
+
+/** initial capacity of a shadow file set */
+#define INIT_SET_CAP 8
+
+/** factor by which to resize things that are resizeable */
+#define RESIZE_FACTOR 2
+
+/** character between a file name and a username in a label */
+#define LABEL_SEPARATOR ':'
+
+/**
+ * Reads the "salt$hash:" part of an entry, splits it at the last
+ * '$' and skips the rest of the line.
+ * 
+ * @param fp pointer to input stream
+ * @param token where the part read is stored, cut short at the split
+ * @return the part after the last '$', token itself if there is no
+ *         '$', or NULL if the entry is badly formed
+ */
+static char *readSplitToken( FILE *fp, char token[ TOKEN_LIMIT + 1 ] )
+{
+  if ( fscanf( fp, "%" TOKEN_FORMAT "[^:\n]:", token ) != 1 ) {
+    return NULL;
+  }
+  fscanf( fp, "%*[^\n]\n" );
+
+  char *hash = strrchr( token, '$' );
+  if ( hash == NULL ) {
+    return token;
+  }
+
+  *hash = '\0';
+  return hash + 1;
+}
+
+/**
+ * Reads the "$raw-md5$[salt$]hex:" part of a raw MD5 entry, whose
+ * first three characters have already been read.
+ * 
+ * @param fp pointer to input stream
+ * @param saltStr where the salt is stored, empty if there is none
+ * @param hexStr where the hex digest is stored
+ * @return true if the entry is well formed
+ */
+static bool parseRawHash( FILE *fp, char saltStr[ SALT_LIMIT + 1 ], char hexStr[ TOKEN_LIMIT + 1 ] )
+{
+  char rest[ RAW_ID_LENGTH + 1 ] = "";
+  char token[ TOKEN_LIMIT + 1 ] = "";
+
+  if ( fscanf( fp, "%6c", rest ) != 1 || strcmp( rest, RAW_ID + MD5_ID_HASH_LENGTH ) != 0 ) {
+    return false;
+  }
+
+  char *hex = readSplitToken( fp, token );
+  if ( hex == NULL ) {
+    return false;
+  }
+
+  // without a '$' there is no salt
+  char const *salt = hex == token ? "" : token;
+  if ( strlen( salt ) > RAW_SALT_LIMIT || strchr( salt, '$' ) != NULL ) {
+    return false;
+  }
+
+  strcpy( saltStr, salt );
+  strcpy( hexStr, hex );
+  return true;
+}
+
+/**
+ * Reads the "[rounds=N$]salt$hash:" part of a SHA-crypt entry, whose
+ * "$5$" or "$6$" has already been read.
+ * 
+ * @param fp pointer to input stream
+ * @param format FORMAT_SHA256CRYPT or FORMAT_SHA512CRYPT
+ * @param settingStr where the setting is stored
+ * @param hashStr where the printable hash is stored
+ * @return true if the entry is well formed
+ */
+static bool parseShaHash( FILE *fp, int format, char settingStr[ SALT_LIMIT + 1 ],
+                          char hashStr[ TOKEN_LIMIT + 1 ] )
+{
+  char token[ TOKEN_LIMIT + 1 ] = "";
+  ShaSalt ss;
+
+  char *hash = readSplitToken( fp, token );
+  if ( hash == NULL || hash == token || strlen( token ) > SALT_LIMIT ||
+       !parseShaSetting( &ss, shaDigestLength( format ), token ) ) {
+    return false;
+  }
+
+  strcpy( settingStr, token );
+  strcpy( hashStr, hash );
+  return true;
+}
+
+/**
+ * Parses a single line of input from shadow file.
+ * 
+ * Adds the user it describes to the given target store, unless the
+ * entry is invalid.  If a source is given, the user is named
+ * "source:name" so it can be told apart from users of other files.
+ * Entries are md5crypt, "$1$salt$hash", raw MD5, "$raw-md5$hex" or
+ * "$raw-md5$salt$hex", or SHA-crypt, "$5$" or "$6$" followed by
+ * "[rounds=N$]salt$hash".
+ * 
+ * @param store store to add the user to
+ * @param fp pointer to input stream
+ * @param source name of the file the entry came from, or NULL
+ * @return true if the entry was valid
+ */
+bool parseUser( TargetStore *store, FILE *fp, char const *source )
+{
+  char nameStr[ USERNAME_LIMIT + 1 ] = "";
+  char saltStr[ SALT_LIMIT + 2 ] = "";
+  char hashStr[ TOKEN_LIMIT + 1 ] = ""; 
+  char trash[ EXCESS_SHADOW + 1 ] = "";
+  char md5IdHash[ MD5_ID_HASH_LENGTH + 1 ] = "";
+  int format = FORMAT_MD5CRYPT;
+
+  fscanf( fp, "%32[a-zA-Z]:", nameStr );
+
+  if ( fscanf( fp, "%3c", md5IdHash ) == 1 ) {
+    if ( strncmp( md5IdHash, RAW_ID, MD5_ID_HASH_LENGTH ) == 0 ) {
+      format = FORMAT_RAW_MD5;
+    } else if ( strcmp( md5IdHash, SHA256_ID ) == 0 ) {
+      format = FORMAT_SHA256CRYPT;
+    } else if ( strcmp( md5IdHash, SHA512_ID ) == 0 ) {
+      format = FORMAT_SHA512CRYPT;
+    } else if ( strncmp( md5IdHash, "$1$", MD5_ID_HASH_LENGTH ) != 0 ) {
+      return false;
+    }
+  }
+
+  if ( format == FORMAT_RAW_MD5 ) {
+    if ( !parseRawHash( fp, saltStr, hashStr ) ) {
+      return false;
+    }
+  } else if ( format != FORMAT_MD5CRYPT ) {
+    if ( !parseShaHash( fp, format, saltStr, hashStr ) ) {
+      return false;
+    }
+  } else {
+    if ( fscanf( fp, "%9[a-zA-Z0-9./]$", saltStr ) == 1 ) {
+      if ( strlen( saltStr ) > SALT_LENGTH ) {
+        return false;
+      }
+    }
+
+    if ( fscanf( fp, "%22[a-zA-z0-9./]:", hashStr ) == 1 ) {
+      fscanf( fp, "%18c\n", trash );
+    }
+  }
+
+  char *label = nameStr;
+  if ( source != NULL ) {
+    size_t sourceLen = strlen( source );
+    label = (char *)malloc( sourceLen + 1 + USERNAME_LIMIT + 1 );
+    strcpy( label, source );
+    label[ sourceLen ] = LABEL_SEPARATOR;
+    strcpy( label + sourceLen + 1, nameStr );
+  }
+
+  if ( format == FORMAT_RAW_MD5 ) {
+    addRawTarget( store, label, saltStr, hashStr );
+  } else if ( format != FORMAT_MD5CRYPT ) {
+    addShaTarget( store, label, format, saltStr, hashStr );
+  } else {
+    addTarget( store, label, saltStr, hashStr );
+  }
+
+  if ( label != nameStr ) {
+    free( label );
+  }
+  return true;
+}
+
+/**
+ * Reads in a single line of input from shadow file.
+ * 
+ * Adds the user it describes to the given target store.
+ * 
+ * @param store store to add the user to
+ * @param fp pointer to input stream
+ */
+void readUserFromFile( TargetStore *store, FILE *fp )
+{
+  if ( !parseUser( store, fp, NULL ) ) {
+    fprintf( stderr, "Invalid shadow file entry\n" );
+    exit( EXIT_FAILURE );
+  }
+}
+
+/**
+ * Parses every entry of the shadow file into a new target store,
+ * grouped by salt.
+ * 
+ * @param fp pointer to input stream
+ * @return store holding the users, or NULL if an entry was invalid
+ */
+TargetStore *parseShadowFile( FILE *fp )
+{
+  TargetStore *store = makeTargets();
+  
+  while ( true ) {
+    if ( feof( fp ) ) {
+      break;
+    }
+    
+    if ( !parseUser( store, fp, NULL ) ) {
+      freeTargets( store );
+      return NULL;
+    }
+  }
+
+  finishTargets( store );
+  return store;
+}
+
+/**
+ * Reads every entry of the shadow file into a new target store,
+ * grouped by salt.
+ * 
+ * @param fp pointer to input stream
+ * @return store holding the users
+ */
+TargetStore *readShadowFile( FILE *fp )
+{
+  TargetStore *store = parseShadowFile( fp );
+  if ( store == NULL ) {
+    fprintf( stderr, "Invalid shadow file entry\n" );
+    exit( EXIT_FAILURE );
+  }
+
+  return store;
+}
+
+/**
+ * Adds a file name to a shadow file set, checking that it can be
+ * opened.  If it can't, exit unsuccessfully.
+ * 
+ * @param set set to add to
+ * @param name shadow file name
+ */
+static void addShadowFile( ShadowSet *set, char const *name )
+{
+  FILE *fp = fopen( name, "r" );
+  if ( fp == NULL ) {
+    perror( name );
+    exit( EXIT_FAILURE );
+  }
+  fclose( fp );
+
+  if ( set->count >= set->cap ) {
+    set->cap *= RESIZE_FACTOR;
+    set->names = (char **)realloc( set->names, set->cap * sizeof( char * ) );
+  }
+  set->names[ set->count++ ] = strdup( name );
+}
+
+/**
+ * Collects the shadow files to crack together: the named ones, then
+ * those listed in the manifest, one per line.  If any of them can't
+ * be opened, exit unsuccessfully.
+ * 
+ * @param names shadow file names
+ * @param count number of names
+ * @param manifest name of a file listing more shadow files, or NULL
+ * @return the set of shadow files
+ */
+ShadowSet *openShadowFiles( char const *const *names, int count, char const *manifest )
+{
+  ShadowSet *set = (ShadowSet *)malloc( sizeof( ShadowSet ) );
+  set->count = 0;
+  set->cap = INIT_SET_CAP;
+  set->names = (char **)malloc( set->cap * sizeof( char * ) );
+
+  for ( int i = 0; i < count; i++ ) {
+    addShadowFile( set, names[ i ] );
+  }
+
+  if ( manifest != NULL ) {
+    FILE *fp = fopen( manifest, "r" );
+    if ( fp == NULL ) {
+      perror( manifest );
+      exit( EXIT_FAILURE );
+    }
+
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    while ( ( len = getline( &line, &cap, fp ) ) > 0 ) {
+      if ( line[ len - 1 ] == '\n' ) {
+        line[ --len ] = '\0';
+      }
+      if ( len > 0 ) {
+        addShadowFile( set, line );
+      }
+    }
+    free( line );
+    fclose( fp );
+  }
+
+  return set;
+}
+
+/**
+ * Reads every entry of every file in the set into one target store,
+ * so users of all the files are grouped by salt together.  When
+ * there is more than one file, each user is named "file:name".
+ * 
+ * @param set the shadow files
+ * @return store holding the users
+ */
+TargetStore *readShadowSet( ShadowSet const *set )
+{
+  TargetStore *store = makeTargets();
+  char const *source = NULL;
+
+  for ( int i = 0; i < set->count; i++ ) {
+    FILE *fp = fopen( set->names[ i ], "r" );
+    if ( fp == NULL ) {
+      perror( set->names[ i ] );
+      exit( EXIT_FAILURE );
+    }
+
+    if ( set->count > 1 ) {
+      source = set->names[ i ];
+    }
+    while ( !feof( fp ) ) {
+      if ( !parseUser( store, fp, source ) ) {
+        fprintf( stderr, "Invalid shadow file entry\n" );
+        exit( EXIT_FAILURE );
+      }
+    }
+    fclose( fp );
+  }
+
+  finishTargets( store );
+  return store;
+}
+
+/**
+ * Frees the memory previously allocated to the given set.
+ * 
+ * @param set set to free
+ */
+void freeShadowSet( ShadowSet *set )
+{
+  for ( int i = 0; i < set->count; i++ ) {
+    free( set->names[ i ] );
+  }
+  free( set->names );
+  free( set );
+}
@@ -0,0 +1,285 @@
+/**
+ * @file shmdict.c
+ * @author Luke Early
+ * Shares a loaded dictionary between concurrent processes through a
+ * named POSIX shared-memory segment.
+ * 
+ * The first process to load a dictionary publishes it; later ones
+ * attach to the same pages instead of reading and storing their own
+ * copy.  The words are kept in the same fixed-size slots as a
+ * WordPool, so an attached segment is used in place through
+ * viewWordPool().  A reference count in the segment header tracks attached
+ * processes, and the last one out marks the segment dead before it
+ * removes it, so a process that opened it just then backs off rather
+ * than keeping it alive under a name that may be reused.  A process
+ * killed while attached leaves its reference behind, in which case
+ * the segment stays until removed by hand (rm /dev/shm/NAME).
+ */
+
+#include "shmdict.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** Marks a segment as a shared dictionary, layout version 2. */
+#define SHM_DICT_MAGIC 0x44435032
+
+/** Permissions for a newly published segment. */
+#define SHM_DICT_MODE 0644
+
+/** Microseconds to wait between checks for a segment being published. */
+#define SHM_READY_POLL_US 1000
+
+/** Number of checks before giving up on a segment being published. */
+#define SHM_READY_POLLS 10000
+
+/**
+ * Copies the shared-memory object name, adding the leading slash
+ * POSIX requires if it's missing.
+ * 
+ * @param dest where the full name is stored
+ * @param name name given on the command line
+ */
+static void objectName( char dest[ SHM_NAME_LIMIT + 1 ], char const *name )
+{
+  if ( name[ 0 ] == '/' ) {
+    snprintf( dest, SHM_NAME_LIMIT + 1, "%s", name );
+  } else {
+    snprintf( dest, SHM_NAME_LIMIT + 1, "/%s", name );
+  }
+}
+
+/**
+ * Returns the offset of the word array in a segment: the header
+ * gets a page to itself, so the words can be made read-only.
+ * 
+ * @return offset of the first word, in bytes
+ */
+static size_t wordsOffset()
+{
+  return (size_t) sysconf( _SC_PAGESIZE );
+}
+
+/**
+ * Records the identity of the open dictionary file in a header.
+ * 
+ * @param fp open dictionary stream
+ * @param hdr header to fill in
+ */
+static void fileIdentity( FILE *fp, ShmDictHeader *hdr )
+{
+  struct stat st;
+
+  memset( hdr, 0, sizeof( ShmDictHeader ) );
+  if ( fstat( fileno( fp ), &st ) == 0 ) {
+    hdr->fileDev = st.st_dev;
+    hdr->fileIno = st.st_ino;
+    hdr->fileSize = st.st_size;
+    hdr->fileMtime = st.st_mtime;
+  }
+}
+
+/**
+ * Adds a reference to a segment, unless its last process has already
+ * detached and is removing it.
+ * 
+ * @param hdr header of the segment
+ * @return false if the segment is being removed
+ */
+static bool addRef( ShmDictHeader *hdr )
+{
+  int refs = __atomic_load_n( &hdr->refs, __ATOMIC_ACQUIRE );
+  do {
+    if ( refs == SHM_DICT_DEAD ) {
+      return false;
+    }
+  } while ( !__atomic_compare_exchange_n( &hdr->refs, &refs, refs + 1, false,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) );
+  return true;
+}
+
+/**
+ * Maps a whole segment, making its words read-only, and wraps it
+ * in a SharedDict.
+ * 
+ * @param fd open shared-memory object
+ * @param name full object name
+ * @param count number of words in the segment
+ * @return the mapped dictionary, or NULL if it couldn't be mapped
+ */
+static SharedDict *mapSegment( int fd, char const *name, long long count )
+{
+  size_t len = wordsOffset() + count * sizeof( Password );
+  void *base = mmap( NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+  if ( base == MAP_FAILED ) {
+    return NULL;
+  }
+
+  SharedDict *dict = (SharedDict *)malloc( sizeof( SharedDict ) );
+  snprintf( dict->name, sizeof( dict->name ), "%s", name );
+  dict->hdr = (ShmDictHeader *)base;
+  dict->words = (Password const *)( (char *)base + wordsOffset() );
+  dict->mapLen = len;
+
+  return dict;
+}
+
+/**
+ * Attaches to the named shared dictionary, if another process has
+ * already published one built from the same file with the same
+ * limit on its words.
+ * 
+ * @param name shared-memory object name
+ * @param fp open dictionary stream, used to identify the file
+ * @param maxWords most words to read from the file
+ * @return the mapped dictionary, or NULL if there isn't a usable one
+ */
+SharedDict *attachSharedDict( char const *name, FILE *fp, long long maxWords )
+{
+  char full[ SHM_NAME_LIMIT + 1 ];
+  objectName( full, name );
+
+  int fd = shm_open( full, O_RDWR, 0 );
+  if ( fd < 0 ) {
+    return NULL;
+  }
+
+  /**
+   * Wait for the publisher to size the segment and finish writing it
+   */
+  ShmDictHeader *hdr = MAP_FAILED;
+  for ( int i = 0; i < SHM_READY_POLLS; i++ ) {
+    struct stat st;
+    if ( hdr == MAP_FAILED && fstat( fd, &st ) == 0 && st.st_size >= (off_t) wordsOffset() ) {
+      hdr = mmap( NULL, wordsOffset(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    }
+    if ( hdr != MAP_FAILED && __atomic_load_n( &hdr->ready, __ATOMIC_ACQUIRE ) ) {
+      break;
+    }
+    usleep( SHM_READY_POLL_US );
+  }
+
+  if ( hdr == MAP_FAILED ) {
+    close( fd );
+    return NULL;
+  }
+
+  ShmDictHeader expect;
+  fileIdentity( fp, &expect );
+
+  SharedDict *dict = NULL;
+  if ( hdr->magic != SHM_DICT_MAGIC || !hdr->ready ) {
+    fprintf( stderr, "%s: not a shared dictionary\n", full );
+  } else if ( hdr->fileDev != expect.fileDev || hdr->fileIno != expect.fileIno ||
+              hdr->fileSize != expect.fileSize || hdr->fileMtime != expect.fileMtime ) {
+    fprintf( stderr, "%s: shared dictionary was built from a different file\n", full );
+  } else if ( hdr->maxWords != maxWords ) {
+    fprintf( stderr, "%s: shared dictionary was read with a different word limit\n", full );
+  } else {
+    dict = mapSegment( fd, full, hdr->wordCount );
+  }
+
+  munmap( hdr, wordsOffset() );
+  close( fd );
+
+  // a segment on its way out is treated as not shared at all
+  if ( dict != NULL && !addRef( dict->hdr ) ) {
+    munmap( dict->hdr, dict->mapLen );
+    free( dict );
+    dict = NULL;
+  }
+
+  if ( dict != NULL ) {
+    mprotect( (void *)dict->words, dict->mapLen - wordsOffset(), PROT_READ );
+  }
+
+  return dict;
+}
+
+/**
+ * Publishes the given words under the given name so later processes
+ * can attach to them.  Nothing is published if the name is already
+ * taken.
+ * 
+ * @param name shared-memory object name
+ * @param fp open dictionary stream, used to identify the file
+ * @param pool words read from the dictionary
+ * @param maxWords most words that were read from the file
+ * @return the mapped dictionary, or NULL if it couldn't be published
+ */
+SharedDict *publishSharedDict( char const *name, FILE *fp, WordPool const *pool,
+                               long long maxWords )
+{
+  char full[ SHM_NAME_LIMIT + 1 ];
+  objectName( full, name );
+
+  int fd = shm_open( full, O_RDWR | O_CREAT | O_EXCL, SHM_DICT_MODE );
+  if ( fd < 0 ) {
+    // someone else has published under this name since we looked
+    if ( errno != EEXIST ) {
+      perror( full );
+    }
+    return NULL;
+  }
+
+  long long count = pool->count;
+  SharedDict *dict = NULL;
+  if ( ftruncate( fd, wordsOffset() + count * sizeof( Password ) ) == 0 ) {
+    dict = mapSegment( fd, full, count );
+  }
+  close( fd );
+
+  if ( dict == NULL ) {
+    perror( full );
+    shm_unlink( full );
+    return NULL;
+  }
+
+  ShmDictHeader *hdr = dict->hdr;
+  fileIdentity( fp, hdr );
+  hdr->magic = SHM_DICT_MAGIC;
+  hdr->wordCount = count;
+  hdr->maxWords = maxWords;
+  hdr->refs = 1;
+
+  // the pool's slots already have the segment's layout
+  Password *dest = (Password *)dict->words;
+  memcpy( dest, pool->slots, count * sizeof( Password ) );
+
+  __atomic_store_n( &hdr->ready, 1, __ATOMIC_RELEASE );
+  mprotect( dest, dict->mapLen - wordsOffset(), PROT_READ );
+
+  return dict;
+}
+
+/**
+ * Detaches from a shared dictionary.  The last process to detach
+ * removes the segment unless keep is set.
+ * 
+ * @param dict dictionary to detach from
+ * @param keep leave the segment in place for future runs
+ */
+void detachSharedDict( SharedDict *dict, bool keep )
+{
+  // the last one out marks the segment dead in the same step as it
+  // drops its reference, so no one can attach to it after that
+  int *refs = &dict->hdr->refs;
+  int old = __atomic_load_n( refs, __ATOMIC_ACQUIRE );
+  int now;
+  do {
+    now = old == 1 && !keep ? SHM_DICT_DEAD : old - 1;
+  } while ( !__atomic_compare_exchange_n( refs, &old, now, false,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) );
+
+  if ( now == SHM_DICT_DEAD ) {
+    shm_unlink( dict->name );
+  }
+
+  munmap( dict->hdr, dict->mapLen );
+  free( dict );
+}
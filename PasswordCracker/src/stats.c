@@ -0,0 +1,98 @@
+/**
+ * @file stats.c
+ * @author Luke Early
+ * Keeps and reports counters describing a run of the program.
+ */
+
+#include "stats.h"
+#include <string.h>
+
+/** Nanoseconds in a second. */
+#define NS_PER_SEC 1e9
+
+/** Length of the longest label of a NUMA node's line. */
+#define NODE_LABEL_LIMIT 23
+
+/**
+ * Clears all counters and starts the run's clock.
+ * 
+ * @param stats stats to initialize
+ */
+void initStats( Stats *stats )
+{
+  memset( stats, 0, sizeof( Stats ) );
+  clock_gettime( CLOCK_MONOTONIC, &stats->start );
+}
+
+/**
+ * Adds to one of the counters; safe to call from any thread.
+ * 
+ * @param counter counter to add to
+ * @param n amount to add
+ */
+void countStat( long long *counter, long long n )
+{
+  __atomic_add_fetch( counter, n, __ATOMIC_RELAXED );
+}
+
+/**
+ * Returns the number of seconds since the run started.
+ * 
+ * @param stats stats for the run
+ * @return elapsed wall-clock time in seconds
+ */
+double elapsedSeconds( Stats const *stats )
+{
+  struct timespec now;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+
+  return ( now.tv_sec - stats->start.tv_sec ) +
+         ( now.tv_nsec - stats->start.tv_nsec ) / NS_PER_SEC;
+}
+
+/**
+ * Prints a report of the counters.
+ * 
+ * @param stats stats to report
+ * @param fp stream to print to
+ */
+void printStats( Stats const *stats, FILE *fp )
+{
+  double secs = elapsedSeconds( stats );
+
+  fprintf( fp, "candidates:  %lld\n", stats->candidates );
+  if ( stats->audit ) {
+    fprintf( fp, "re-audit:    %lld old words not retried on %d old targets\n",
+             stats->oldWords, stats->oldTargets );
+  }
+  if ( stats->policy ) {
+    fprintf( fp, "policy:      %lld rejected (%.1f%% of candidates)\n", stats->violations,
+             stats->candidates > 0 ? 100.0 * stats->violations / stats->candidates : 0.0 );
+  }
+  if ( stats->dedupe ) {
+    fprintf( fp, "repeats:     %lld dropped (%.1f%% of candidates)\n", stats->repeats,
+             stats->candidates > 0 ? 100.0 * stats->repeats / stats->candidates : 0.0 );
+  }
+  fprintf( fp, "targets:     %d in %d salt groups\n", stats->targets, stats->saltGroups );
+  if ( stats->indexed > 0 ) {
+    fprintf( fp, "indexed:     %d targets looked up\n", stats->indexed );
+  }
+  fprintf( fp, "threads:     %d\n", stats->threads );
+  if ( stats->tiles > 0 ) {
+    fprintf( fp, "tiles:       %lld of %d words x %d salt groups\n",
+             stats->tiles, stats->tileWords, stats->tileSalts );
+  }
+  if ( stats->tiers > 0 ) {
+    fprintf( fp, "tiers:       %d, %d salt groups fully cracked\n",
+             stats->tiers, stats->groupsDone );
+  }
+  fprintf( fp, "hashes:      %lld\n", stats->hashes );
+  fprintf( fp, "elapsed:     %.3f s\n", secs );
+  fprintf( fp, "rate:        %.0f hashes/s\n", secs > 0 ? stats->hashes / secs : 0.0 );
+  for ( int n = 0; n < stats->nodes; n++ ) {
+    char label[ NODE_LABEL_LIMIT + 1 ];
+    snprintf( label, sizeof( label ), "node %d:", stats->nodeIds[ n ] );
+    fprintf( fp, "%-13s%lld hashes, %.0f hashes/s\n", label, stats->nodeHashes[ n ],
+             secs > 0 ? stats->nodeHashes[ n ] / secs : 0.0 );
+  }
+}
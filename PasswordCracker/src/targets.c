@@ -0,0 +1,475 @@
+/**
+ * @file targets.c
+ * @author Luke Early
+ * Implements the target store, which holds the accounts being
+ * cracked as parallel arrays with a deduplicated salt table.
+ */
+
+#include "targets.h"
+#include "shacrypt.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** initial capacity of the target arrays */
+#define INIT_TARGET_CAP 16
+
+/** initial capacity of the names pool, in bytes */
+#define INIT_NAMES_CAP 256
+
+/** initial capacity of the salt table */
+#define INIT_SALT_CAP 16
+
+/** factor by which to resize things that are resizeable */
+#define RESIZE_FACTOR 2
+
+/** A target's digest paired with the target, for sorting a group. */
+typedef struct {
+  byte digest[ HASH_SIZE ];
+  int target;
+} DigestEntry;
+
+/** FNV-1a offset basis, used to hash salt strings */
+#define FNV_OFFSET 2166136261u
+
+/** FNV-1a prime, used to hash salt strings */
+#define FNV_PRIME 16777619u
+
+/**
+ * Hashes a salt string and its format for the salt index.
+ * 
+ * @param salt salt string
+ * @param format hash format the salt is used with
+ * @return hash of the salt
+ */
+static unsigned int saltHash( char const *salt, int format )
+{
+  unsigned int h = ( FNV_OFFSET ^ format ) * FNV_PRIME;
+  for ( int i = 0; salt[ i ]; i++ ) {
+    h = ( h ^ (byte) salt[ i ] ) * FNV_PRIME;
+  }
+  return h;
+}
+
+/**
+ * Rebuilds the salt index with room for the given number of buckets.
+ * 
+ * @param store store whose index is rebuilt
+ * @param cap number of buckets, a power of two
+ */
+static void rebuildSaltIndex( TargetStore *store, int cap )
+{
+  free( store->saltIndex );
+  store->saltIndex = (int *)malloc( cap * sizeof( int ) );
+  store->saltIndexCap = cap;
+  memset( store->saltIndex, -1, cap * sizeof( int ) );
+
+  for ( int id = 0; id < store->saltCount; id++ ) {
+    unsigned int b = saltHash( store->salts[ id ], store->saltFormats[ id ] ) & ( cap - 1 );
+    while ( store->saltIndex[ b ] >= 0 ) {
+      b = ( b + 1 ) & ( cap - 1 );
+    }
+    store->saltIndex[ b ] = id;
+  }
+}
+
+/**
+ * Returns the id of the given salt for the given format, adding it to
+ * the salt table if it isn't there already.
+ * 
+ * @param store store holding the salt table
+ * @param salt salt string
+ * @param format hash format the salt is used with
+ * @param limit longest salt the format allows
+ * @return id of the salt
+ */
+static int saltId( TargetStore *store, char const *salt, int format, int limit )
+{
+  Salt key;
+  strncpy( key, salt, limit );
+  key[ limit ] = '\0';
+
+  unsigned int mask = store->saltIndexCap - 1;
+  unsigned int b = saltHash( key, format ) & mask;
+
+  while ( store->saltIndex[ b ] >= 0 ) {
+    int id = store->saltIndex[ b ];
+    if ( store->saltFormats[ id ] == format && strcmp( store->salts[ id ], key ) == 0 ) {
+      return id;
+    }
+    b = ( b + 1 ) & mask;
+  }
+
+  if ( store->saltCount >= store->saltCap ) {
+    store->saltCap *= RESIZE_FACTOR;
+    store->salts = (Salt *)realloc( store->salts, store->saltCap * sizeof( Salt ) );
+    store->saltFormats = (byte *)realloc( store->saltFormats, store->saltCap * sizeof( byte ) );
+  }
+
+  int id = store->saltCount++;
+  strcpy( store->salts[ id ], key );
+  store->saltFormats[ id ] = format;
+  store->saltIndex[ b ] = id;
+
+  // keep the index at most half full
+  if ( store->saltCount * RESIZE_FACTOR > store->saltIndexCap ) {
+    rebuildSaltIndex( store, store->saltIndexCap * RESIZE_FACTOR );
+  }
+
+  return id;
+}
+
+/**
+ * Dynamically allocates an empty target store.
+ * 
+ * @return pointer to the newly created store
+ */
+TargetStore *makeTargets()
+{
+  TargetStore *store = (TargetStore *)calloc( 1, sizeof( TargetStore ) );
+
+  store->cap = INIT_TARGET_CAP;
+  store->digests = malloc( store->cap * sizeof( *store->digests ) );
+  store->saltIds = (int *)malloc( store->cap * sizeof( int ) );
+  store->nameOffsets = (int *)malloc( store->cap * sizeof( int ) );
+  store->valid = (bool *)malloc( store->cap * sizeof( bool ) );
+
+  store->namesCap = INIT_NAMES_CAP;
+  store->names = (char *)malloc( store->namesCap );
+
+  store->saltCap = INIT_SALT_CAP;
+  store->salts = (Salt *)malloc( store->saltCap * sizeof( Salt ) );
+  store->saltFormats = (byte *)malloc( store->saltCap * sizeof( byte ) );
+  rebuildSaltIndex( store, INIT_SALT_CAP * RESIZE_FACTOR );
+
+  return store;
+}
+
+/**
+ * Frees the memory previously allocated to the given store.
+ * 
+ * @param store store to free
+ */
+void freeTargets( TargetStore *store )
+{
+  free( store->digests );
+  free( store->saltIds );
+  free( store->nameOffsets );
+  free( store->valid );
+  free( store->names );
+  free( store->salts );
+  free( store->saltFormats );
+  free( store->saltIndex );
+  free( store->order );
+  free( store->groupStart );
+  free( store->groupDigests );
+  free( store );
+}
+
+/**
+ * Adds an account to the store, leaving its hash to be filled in.
+ * 
+ * @param store store to add to
+ * @param name username
+ * @return index of the new target
+ */
+static int newTarget( TargetStore *store, char const *name )
+{
+  if ( store->count >= store->cap ) {
+    store->cap *= RESIZE_FACTOR;
+    store->digests = realloc( store->digests, store->cap * sizeof( *store->digests ) );
+    store->saltIds = (int *)realloc( store->saltIds, store->cap * sizeof( int ) );
+    store->nameOffsets = (int *)realloc( store->nameOffsets, store->cap * sizeof( int ) );
+    store->valid = (bool *)realloc( store->valid, store->cap * sizeof( bool ) );
+  }
+
+  int nameLen = strlen( name ) + 1;
+  while ( store->namesLen + nameLen > store->namesCap ) {
+    store->namesCap *= RESIZE_FACTOR;
+    store->names = (char *)realloc( store->names, store->namesCap );
+  }
+
+  int t = store->count++;
+  memcpy( store->names + store->namesLen, name, nameLen );
+  store->nameOffsets[ t ] = store->namesLen;
+  store->namesLen += nameLen;
+
+  return t;
+}
+
+/**
+ * Adds an account to the store.
+ * 
+ * @param store store to add to
+ * @param name username
+ * @param salt salt string
+ * @param hash password hash string, as made by hashPassword()
+ * @return index of the new target
+ */
+int addTarget( TargetStore *store, char const *name, char const *salt, char const *hash )
+{
+  int t = newTarget( store, name );
+
+  store->saltIds[ t ] = saltId( store, salt, FORMAT_MD5CRYPT, SALT_LENGTH );
+  store->valid[ t ] = stringToHash( hash, store->digests[ t ] );
+
+  return t;
+}
+
+/**
+ * Returns the value of a hex digit.
+ * 
+ * @param ch the digit
+ * @return its value, or -1 if ch is not a hex digit
+ */
+static int hexValue( char ch )
+{
+  if ( ch >= '0' && ch <= '9' ) {
+    return ch - '0';
+  }
+  if ( ch >= 'a' && ch <= 'f' ) {
+    return ch - 'a' + 10;
+  }
+  if ( ch >= 'A' && ch <= 'F' ) {
+    return ch - 'A' + 10;
+  }
+  return -1;
+}
+
+/**
+ * Adds an account with a raw MD5 hash to the store.
+ * 
+ * @param store store to add to
+ * @param name username
+ * @param salt salt put in front of the password, up to RAW_SALT_LIMIT characters
+ * @param hex hash of the salted password, as 32 hex digits
+ * @return index of the new target
+ */
+int addRawTarget( TargetStore *store, char const *name, char const *salt, char const *hex )
+{
+  int t = newTarget( store, name );
+
+  store->saltIds[ t ] = saltId( store, salt, FORMAT_RAW_MD5, RAW_SALT_LIMIT );
+  store->valid[ t ] = strlen( hex ) == RAW_HEX_LENGTH;
+  for ( int i = 0; i < HASH_SIZE && store->valid[ t ]; i++ ) {
+    int hi = hexValue( hex[ 2 * i ] );
+    int lo = hexValue( hex[ 2 * i + 1 ] );
+    store->valid[ t ] = hi >= 0 && lo >= 0;
+    store->digests[ t ][ i ] = hi * 16 + lo;
+  }
+
+  return t;
+}
+
+/**
+ * Returns the number of bytes in the digests of a SHA-crypt format.
+ * 
+ * @param format FORMAT_SHA256CRYPT or FORMAT_SHA512CRYPT
+ * @return SHA256_DIGEST or SHA512_DIGEST
+ */
+int shaDigestLength( int format )
+{
+  return format == FORMAT_SHA512CRYPT ? SHA512_DIGEST : SHA256_DIGEST;
+}
+
+/**
+ * Adds an account with a SHA-crypt hash to the store.  Only the
+ * first HASH_SIZE bytes of the digest are kept and compared.
+ * 
+ * @param store store to add to
+ * @param name username
+ * @param format FORMAT_SHA256CRYPT or FORMAT_SHA512CRYPT
+ * @param setting valid setting, "salt" or "rounds=N$salt"
+ * @param hash printable hash
+ * @return index of the new target
+ */
+int addShaTarget( TargetStore *store, char const *name, int format, char const *setting, char const *hash )
+{
+  int t = newTarget( store, name );
+  byte digest[ SHA512_DIGEST ];
+
+  store->saltIds[ t ] = saltId( store, setting, format, SALT_LIMIT );
+  store->valid[ t ] = shaStringToHash( shaDigestLength( format ), hash, digest );
+  memcpy( store->digests[ t ], digest, HASH_SIZE );
+
+  return t;
+}
+
+/**
+ * Comparison function for sorting digest entries by digest, then by
+ * target.
+ * 
+ * @param a pointer to the first entry
+ * @param b pointer to the second entry
+ * @return negative, zero or positive as a sorts before, with or after b
+ */
+static int compareDigests( void const *a, void const *b )
+{
+  DigestEntry const *ea = (DigestEntry const *)a;
+  DigestEntry const *eb = (DigestEntry const *)b;
+
+  int cmp = memcmp( ea->digest, eb->digest, HASH_SIZE );
+  if ( cmp != 0 ) {
+    return cmp;
+  }
+  return ea->target - eb->target;
+}
+
+/**
+ * Groups the targets by salt and sorts each group by digest.  Call
+ * once after the last target is added; targets with the same digest
+ * keep the order they were added.
+ * 
+ * @param store store to group
+ */
+void finishTargets( TargetStore *store )
+{
+  free( store->order );
+  free( store->groupStart );
+  free( store->groupDigests );
+  store->order = (int *)malloc( ( store->count + 1 ) * sizeof( int ) );
+  store->groupStart = (int *)calloc( store->saltCount + 1, sizeof( int ) );
+  store->groupDigests = malloc( ( store->count + 1 ) * sizeof( *store->groupDigests ) );
+
+  /**
+   * Counting sort by salt id
+   */
+  for ( int t = 0; t < store->count; t++ ) {
+    store->groupStart[ store->saltIds[ t ] + 1 ]++;
+  }
+  for ( int g = 0; g < store->saltCount; g++ ) {
+    store->groupStart[ g + 1 ] += store->groupStart[ g ];
+  }
+
+  int *next = (int *)malloc( ( store->saltCount + 1 ) * sizeof( int ) );
+  memcpy( next, store->groupStart, ( store->saltCount + 1 ) * sizeof( int ) );
+  for ( int t = 0; t < store->count; t++ ) {
+    store->order[ next[ store->saltIds[ t ] ]++ ] = t;
+  }
+  free( next );
+
+  /**
+   * Sort each group by digest, and lay the digests out in that order
+   */
+  DigestEntry *entries = (DigestEntry *)malloc( ( store->count + 1 ) * sizeof( DigestEntry ) );
+  for ( int k = 0; k < store->count; k++ ) {
+    memcpy( entries[ k ].digest, store->digests[ store->order[ k ] ], HASH_SIZE );
+    entries[ k ].target = store->order[ k ];
+  }
+  for ( int g = 0; g < store->saltCount; g++ ) {
+    qsort( entries + store->groupStart[ g ], store->groupStart[ g + 1 ] - store->groupStart[ g ],
+           sizeof( DigestEntry ), compareDigests );
+  }
+  for ( int k = 0; k < store->count; k++ ) {
+    store->order[ k ] = entries[ k ].target;
+    memcpy( store->groupDigests[ k ], entries[ k ].digest, HASH_SIZE );
+  }
+  free( entries );
+}
+
+/**
+ * Makes a copy of the parts of a finished store that cracking reads
+ * for every hash: the digests, which targets are valid and the
+ * grouping by salt.  The rest is shared with the original, which
+ * must outlive the copy.  Memory is first touched by the calling
+ * thread.
+ * 
+ * @param store targets, finished
+ * @return the copy
+ */
+TargetStore *copyDigestIndex( TargetStore const *store )
+{
+  TargetStore *copy = (TargetStore *)malloc( sizeof( TargetStore ) );
+  *copy = *store;
+
+  copy->digests = malloc( ( store->count + 1 ) * HASH_SIZE );
+  memcpy( copy->digests, store->digests, store->count * HASH_SIZE );
+  copy->valid = (bool *)malloc( ( store->count + 1 ) * sizeof( bool ) );
+  memcpy( copy->valid, store->valid, store->count * sizeof( bool ) );
+  copy->order = (int *)malloc( ( store->count + 1 ) * sizeof( int ) );
+  memcpy( copy->order, store->order, store->count * sizeof( int ) );
+  copy->groupDigests = malloc( ( store->count + 1 ) * HASH_SIZE );
+  memcpy( copy->groupDigests, store->groupDigests, store->count * HASH_SIZE );
+  copy->groupStart = (int *)malloc( ( store->saltCount + 1 ) * sizeof( int ) );
+  memcpy( copy->groupStart, store->groupStart, ( store->saltCount + 1 ) * sizeof( int ) );
+
+  return copy;
+}
+
+/**
+ * Frees a copy made by copyDigestIndex().
+ * 
+ * @param copy the copy
+ */
+void freeDigestIndex( TargetStore *copy )
+{
+  free( copy->digests );
+  free( copy->valid );
+  free( copy->order );
+  free( copy->groupStart );
+  free( copy->groupDigests );
+  free( copy );
+}
+
+/**
+ * Looks for targets in a salt group whose hash matches the given one.
+ * Starting from the beginning of the group, the group's sorted
+ * digests are bisected; starting from just after a match, only the
+ * next position can hold another.
+ * 
+ * @param store store holding the targets
+ * @param group salt group to search
+ * @param hash 16-byte hash to look for
+ * @param from start of the group, or the position after the last match
+ * @return position in order[] of the next match, or -1 if there isn't one
+ */
+int findInGroup( TargetStore const *store, int group, byte const hash[ HASH_SIZE ], int from )
+{
+  int k = from;
+  int end = store->groupStart[ group + 1 ];
+
+  if ( from == store->groupStart[ group ] ) {
+    // first digest not below the hash
+    int hi = end;
+    while ( k < hi ) {
+      int mid = k + ( hi - k ) / 2;
+      if ( memcmp( store->groupDigests[ mid ], hash, HASH_SIZE ) < 0 ) {
+        k = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+  }
+
+  for ( ; k < end && memcmp( store->groupDigests[ k ], hash, HASH_SIZE ) == 0; k++ ) {
+    if ( store->valid[ store->order[ k ] ] ) {
+      return k;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Returns the username of the given target.
+ * 
+ * @param store store holding the target
+ * @param target index of the target
+ * @return the target's username
+ */
+char const *targetName( TargetStore const *store, int target )
+{
+  return store->names + store->nameOffsets[ target ];
+}
+
+/**
+ * Returns the number of bytes of memory the store occupies.
+ * 
+ * @param store store to measure
+ * @return bytes used by all of the store's arrays
+ */
+size_t targetBytes( TargetStore const *store )
+{
+  size_t perTarget = 2 * HASH_SIZE + 3 * sizeof( int ) + sizeof( bool );
+  return store->cap * perTarget + store->namesCap +
+         store->saltCap * ( sizeof( Salt ) + sizeof( byte ) ) + store->saltIndexCap * sizeof( int ) +
+         ( store->saltCount + 1 ) * sizeof( int );
+}
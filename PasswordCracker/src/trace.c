@@ -0,0 +1,190 @@
+/**
+ * @file trace.c
+ * @author Luke Early
+ * Records how long each thread spends in each stage of a run, for
+ * viewing in Perfetto or chrome://tracing.
+ * 
+ * Every thread keeps its spans in a buffer of its own, so recording
+ * one takes no lock.  The buffers are kept when their threads exit,
+ * and all of them are written out together when the program does.
+ */
+
+#include "trace.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+/** Nanoseconds in a second and in a microsecond. */
+#define NS_PER_SEC 1000000000LL
+#define NS_PER_US 1000.0
+
+/** Factor a full buffer grows by. */
+#define RESIZE_FACTOR 2
+
+/** A span of time a thread spent in one stage. */
+typedef struct {
+  char const *name;
+  long long start;
+  long long dur;
+} TraceEvent;
+
+/** The spans of one thread. */
+typedef struct TraceBufferStruct {
+  // Kernel id and name of the thread.
+  long tid;
+  char name[ TRACE_NAME_LIMIT + 1 ];
+
+  // Spans recorded, and room for how many.
+  TraceEvent *events;
+  int count;
+  int cap;
+
+  // Next buffer in the list of every thread's.
+  struct TraceBufferStruct *next;
+} TraceBuffer;
+
+/** File the trace is written to, or NULL if nothing is being traced. */
+static char const *traceName = NULL;
+
+/** Every thread's buffer, and the lock for adding to the list. */
+static TraceBuffer *buffers = NULL;
+static pthread_mutex_t buffersLock = PTHREAD_MUTEX_INITIALIZER;
+
+/** The calling thread's buffer, once it has recorded something. */
+static __thread TraceBuffer *ownBuffer = NULL;
+
+/**
+ * Reads the clock spans are timed with.
+ * 
+ * @return the time in nanoseconds
+ */
+static long long traceClock( void )
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+/**
+ * Returns the calling thread's buffer, making it the first time.
+ * 
+ * @return the buffer
+ */
+static TraceBuffer *threadBuffer( void )
+{
+  if ( ownBuffer == NULL ) {
+    TraceBuffer *buf = (TraceBuffer *)calloc( 1, sizeof( TraceBuffer ) );
+    buf->tid = syscall( SYS_gettid );
+    snprintf( buf->name, sizeof( buf->name ), "thread %ld", buf->tid );
+    buf->cap = INIT_TRACE_CAP;
+    buf->events = (TraceEvent *)malloc( buf->cap * sizeof( TraceEvent ) );
+
+    pthread_mutex_lock( &buffersLock );
+    buf->next = buffers;
+    buffers = buf;
+    pthread_mutex_unlock( &buffersLock );
+
+    ownBuffer = buf;
+  }
+  return ownBuffer;
+}
+
+/**
+ * Writes every thread's spans to the trace file.  Run when the
+ * program exits.
+ */
+static void writeTrace( void )
+{
+  FILE *fp = fopen( traceName, "w" );
+  if ( fp == NULL ) {
+    perror( traceName );
+    return;
+  }
+
+  long pid = getpid();
+  fprintf( fp, "{\"traceEvents\":[\n" );
+
+  bool first = true;
+  pthread_mutex_lock( &buffersLock );
+  for ( TraceBuffer *buf = buffers; buf != NULL; buf = buf->next ) {
+    fprintf( fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,"
+             "\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", pid, buf->tid, buf->name );
+    first = false;
+
+    for ( int i = 0; i < buf->count; i++ ) {
+      TraceEvent const *ev = &buf->events[ i ];
+      fprintf( fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%ld,\"tid\":%ld}",
+               ev->name, ev->start / NS_PER_US, ev->dur / NS_PER_US, pid, buf->tid );
+    }
+  }
+  pthread_mutex_unlock( &buffersLock );
+
+  fprintf( fp, "\n],\"displayTimeUnit\":\"ms\"}\n" );
+  if ( fclose( fp ) != 0 ) {
+    perror( traceName );
+  }
+}
+
+/**
+ * Starts recording spans, to be written to the named file in Chrome
+ * trace_event JSON when the program exits.
+ * 
+ * @param name file the trace is written to
+ */
+void startTrace( char const *name )
+{
+  traceName = name;
+  atexit( writeTrace );
+  traceThreadName( "main" );
+}
+
+/**
+ * Names the calling thread in the trace.
+ * 
+ * @param name name of the thread
+ */
+void traceThreadName( char const *name )
+{
+  if ( traceName != NULL ) {
+    snprintf( threadBuffer()->name, TRACE_NAME_LIMIT + 1, "%s", name );
+  }
+}
+
+/**
+ * Returns the time a span starts at, for traceEnd().
+ * 
+ * @return the time in nanoseconds, or 0 if nothing is being traced
+ */
+long long traceBegin( void )
+{
+  return traceName != NULL ? traceClock() : 0;
+}
+
+/**
+ * Records a span of the calling thread, from the given start to now,
+ * in the thread's own buffer.
+ * 
+ * @param name name of the span, which must outlive the program
+ * @param start what traceBegin() returned at the start of the span
+ */
+void traceEnd( char const *name, long long start )
+{
+  if ( traceName == NULL ) {
+    return;
+  }
+
+  TraceBuffer *buf = threadBuffer();
+  if ( buf->count >= buf->cap ) {
+    buf->cap *= RESIZE_FACTOR;
+    buf->events = (TraceEvent *)realloc( buf->events, buf->cap * sizeof( TraceEvent ) );
+  }
+
+  TraceEvent *ev = &buf->events[ buf->count++ ];
+  ev->name = name;
+  ev->start = start;
+  ev->dur = traceClock() - start;
+}
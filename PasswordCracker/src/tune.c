@@ -0,0 +1,439 @@
+/**
+ * @file tune.c
+ * @author Luke Early
+ * Finds the worker count and MD5 backend that hash
+ * fastest on this host, and remembers them for later runs.
+ * 
+ * The best settings differ between hosts with different CPUs, so
+ * each tuning is cached under the CPU model and count it was
+ * measured on, and a host only runs the trials when the cache has
+ * nothing for it yet.
+ */
+
+#include "tune.h"
+#include "engine.h"
+#include "workers.h"
+#include "batch.h"
+#include "md5.h"
+#include "stats.h"
+#include "fileutil.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/** File the CPU model and core counts are read from. */
+#define CPUINFO_NAME "/proc/cpuinfo"
+
+/** Model named when /proc/cpuinfo doesn't give one. */
+#define UNKNOWN_MODEL "unknown"
+
+/** Nanoseconds in a second and in a millisecond. */
+#define NS_PER_SEC 1000000000LL
+#define NS_PER_MS 1000000LL
+
+/** Salt the trial passwords are hashed with. */
+#define TRIAL_SALT "tuneSalt"
+
+/**
+ * Words per tile of the trials.  Tile size is not tuned: a trial
+ * hashing against one salt never crosses tiles with salt groups, so
+ * it can't tell tile sizes apart, and one that does takes seconds
+ * per size at md5crypt speeds.
+ */
+#define TRIAL_TILE_WORDS DEFAULT_TILE_WORDS
+
+/** State shared by the workers of one trial. */
+typedef struct {
+  PreparedSalt salt;
+
+  // When workers stop taking tiles.
+  struct timespec deadline;
+
+  // Next tile to take, and the number of passwords hashed.
+  long long next;
+  long long hashes;
+} Trial;
+
+/**
+ * Returns the value of a "name : value" line of /proc/cpuinfo, if
+ * the line has the given name.
+ * 
+ * @param line the line, without its newline
+ * @param name field name
+ * @return start of the value, or NULL if the line is for another field
+ */
+static char const *cpuinfoValue( char const *line, char const *name )
+{
+  size_t len = strlen( name );
+  if ( strncmp( line, name, len ) != 0 ) {
+    return NULL;
+  }
+
+  line += strspn( line + len, " \t" ) + len;
+  if ( *line != ':' ) {
+    return NULL;
+  }
+  return line + 1 + strspn( line + 1, " \t" );
+}
+
+/**
+ * Works out the key of the host this is running on.
+ * 
+ * @param key where the key is stored
+ */
+void hostKey( HostKey *key )
+{
+  strcpy( key->model, UNKNOWN_MODEL );
+  key->cpus = workerCount( 0 );
+  key->cores = key->cpus;
+
+  FILE *fp = fopen( CPUINFO_NAME, "r" );
+  if ( fp == NULL ) {
+    return;
+  }
+
+  // siblings and cpu cores count one package's logical and physical CPUs
+  int siblings = 0;
+  int perPackage = 0;
+  bool named = false;
+  char *line = NULL;
+  size_t cap = 0;
+  ssize_t len;
+  while ( ( len = getline( &line, &cap, fp ) ) > 0 ) {
+    if ( line[ len - 1 ] == '\n' ) {
+      line[ --len ] = '\0';
+    }
+
+    char const *val;
+    if ( !named && ( val = cpuinfoValue( line, "model name" ) ) != NULL ) {
+      snprintf( key->model, sizeof( key->model ), "%s", val );
+      named = true;
+    } else if ( siblings == 0 && ( val = cpuinfoValue( line, "siblings" ) ) != NULL ) {
+      siblings = atoi( val );
+    } else if ( perPackage == 0 && ( val = cpuinfoValue( line, "cpu cores" ) ) != NULL ) {
+      perPackage = atoi( val );
+    }
+  }
+  free( line );
+  fclose( fp );
+
+  // the cache is tab-separated
+  for ( char *c = key->model; *c; c++ ) {
+    if ( *c == '\t' ) {
+      *c = ' ';
+    }
+  }
+
+  if ( siblings > 0 && perPackage > 0 && perPackage <= siblings ) {
+    key->cores = key->cpus * perPackage / siblings;
+    if ( key->cores < 1 ) {
+      key->cores = 1;
+    }
+  }
+}
+
+/**
+ * Reads the host key and tuning from a line of a cache file.
+ * 
+ * @param line the line
+ * @param key where the line's host is stored
+ * @param tuning where the line's settings are stored
+ * @return false if the line is not valid
+ */
+static bool parseTuneLine( char const *line, HostKey *key, Tuning *tuning )
+{
+  return sscanf( line, "%127[^\t]\t%d\t%d\t%d\t%15s\t%lf", key->model, &key->cpus,
+                 &key->cores, &tuning->threads, tuning->backend, &tuning->rate ) == 6 &&
+         tuning->threads > 0 && tuning->rate >= 0;
+}
+
+/**
+ * Returns true if two host keys are for the same kind of host.
+ * 
+ * @param a first key
+ * @param b second key
+ * @return true if the model and CPU counts all match
+ */
+static bool sameHost( HostKey const *a, HostKey const *b )
+{
+  return strcmp( a->model, b->model ) == 0 && a->cpus == b->cpus && a->cores == b->cores;
+}
+
+/**
+ * Finds the tuning saved for a host in a cache file.
+ * 
+ * @param name cache file name
+ * @param key host to look for
+ * @param tuning where the tuning is stored, if there is one
+ * @return true if the file has a tuning for the host
+ */
+bool loadTuning( char const *name, HostKey const *key, Tuning *tuning )
+{
+  FILE *fp = fopen( name, "r" );
+  if ( fp == NULL ) {
+    return false;
+  }
+
+  bool found = false;
+  char line[ TUNE_LINE_LIMIT + 1 ];
+  while ( !found && fgets( line, sizeof( line ), fp ) != NULL ) {
+    HostKey lineKey;
+    found = parseTuneLine( line, &lineKey, tuning ) && sameHost( &lineKey, key );
+  }
+
+  fclose( fp );
+  return found;
+}
+
+/** What saveTuning() writes to a new cache. */
+typedef struct {
+  char const *name;
+  HostKey const *key;
+  Tuning const *tuning;
+} TuneSave;
+
+/**
+ * Writes a new cache to a stream: the lines of the old cache for
+ * other hosts, then this host's tuning.
+ * 
+ * @param out stream to write to
+ * @param ctx the TuneSave
+ * @return true if all of it was written
+ */
+static bool writeTuning( FILE *out, void const *ctx )
+{
+  TuneSave const *save = (TuneSave const *)ctx;
+  HostKey const *key = save->key;
+  Tuning const *tuning = save->tuning;
+
+  FILE *in = fopen( save->name, "r" );
+  if ( in != NULL ) {
+    char line[ TUNE_LINE_LIMIT + 1 ];
+    while ( fgets( line, sizeof( line ), in ) != NULL ) {
+      HostKey lineKey;
+      Tuning lineTuning;
+      if ( parseTuneLine( line, &lineKey, &lineTuning ) && !sameHost( &lineKey, key ) ) {
+        fputs( line, out );
+      }
+    }
+    fclose( in );
+  }
+
+  return fprintf( out, "%s\t%d\t%d\t%d\t%s\t%.0f\n", key->model, key->cpus, key->cores,
+                  tuning->threads, tuning->backend, tuning->rate ) > 0;
+}
+
+/**
+ * Saves the tuning for a host in a cache file, replacing any tuning
+ * it already has for that host and keeping those of other hosts.
+ * 
+ * @param name cache file name
+ * @param key host the tuning is for
+ * @param tuning settings to save
+ * @return true if the file was written
+ */
+bool saveTuning( char const *name, HostKey const *key, Tuning const *tuning )
+{
+  TuneSave save = { name, key, tuning };
+  return replaceFile( name, writeTuning, &save );
+}
+
+/**
+ * Returns true once the clock passes the given time.
+ * 
+ * @param deadline time to check against
+ * @return true if it is now later than deadline
+ */
+static bool pastDeadline( struct timespec const *deadline )
+{
+  struct timespec now;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  return now.tv_sec > deadline->tv_sec ||
+         ( now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec );
+}
+
+/**
+ * Worker thread body: fills and hashes tiles of made-up passwords,
+ * the way the engine does, until the trial's time is up.
+ * 
+ * @param id worker number
+ * @param ctx the shared Trial
+ */
+static void trialWorker( int id, void *ctx )
+{
+  Trial *trial = (Trial *)ctx;
+  Batch *batch = makeBatch( TRIAL_TILE_WORDS );
+  byte hash[ HASH_SIZE ];
+
+  while ( !pastDeadline( &trial->deadline ) ) {
+    long long tile = __atomic_fetch_add( &trial->next, 1, __ATOMIC_RELAXED );
+
+    batch->count = 0;
+    for ( int i = 0; i < TRIAL_TILE_WORDS; i++ ) {
+      Password word;
+      memset( word, 0, sizeof( word ) );
+      int len = snprintf( word, sizeof( word ), "t%lld", tile * TRIAL_TILE_WORDS + i );
+      addCandidate( batch, word, len, tile * TRIAL_TILE_WORDS + i );
+    }
+
+    for ( int i = 0; i < batch->count; i++ ) {
+      PreparedWord pw = { batch->words[ i ], batch->lens[ i ] };
+      hashPrepared( &pw, &trial->salt, hash );
+    }
+    __atomic_fetch_add( &trial->hashes, batch->count, __ATOMIC_RELAXED );
+  }
+
+  freeBatch( batch );
+}
+
+/**
+ * Times one configuration with the current MD5 backend.
+ * 
+ * @param threads number of workers
+ * @return passwords hashed per second
+ */
+static double runTrial( int threads )
+{
+  Trial trial;
+  prepareSalt( &trial.salt, TRIAL_SALT );
+  trial.next = 0;
+  trial.hashes = 0;
+
+  Stats timer;
+  initStats( &timer );
+  long long end = timer.start.tv_nsec + TUNE_TRIAL_MS * NS_PER_MS;
+  trial.deadline.tv_sec = timer.start.tv_sec + end / NS_PER_SEC;
+  trial.deadline.tv_nsec = end % NS_PER_SEC;
+
+  runWorkers( threads, trialWorker, &trial );
+
+  double secs = elapsedSeconds( &timer );
+  return secs > 0 ? trial.hashes / secs : 0;
+}
+
+/**
+ * Times short md5crypt trials over the MD5 backends and then the
+ * worker counts, the second stage keeping the winner of the first,
+ * and stores the fastest settings.
+ * 
+ * @param key host being tuned
+ * @param tuning where the fastest settings are stored
+ * @param log stream progress is reported on, or NULL
+ */
+void runTrials( HostKey const *key, Tuning *tuning, FILE *log )
+{
+  char const *current = md5BackendName();
+  tuning->threads = 1;
+
+  double best = -1;
+  for ( int i = 0; md5BackendAt( i ) != NULL; i++ ) {
+    setMd5Backend( md5BackendAt( i ) );
+    double rate = runTrial( tuning->threads );
+    if ( log != NULL ) {
+      fprintf( log, "autotune: md5 backend %s: %.0f hashes/s\n", md5BackendAt( i ), rate );
+    }
+    if ( rate > best ) {
+      best = rate;
+      snprintf( tuning->backend, sizeof( tuning->backend ), "%s", md5BackendAt( i ) );
+    }
+  }
+  setMd5Backend( tuning->backend );
+
+  // one worker per core, one per CPU, and none of the SMT siblings or all of them
+  int counts[] = { 1, key->cores, key->cpus };
+  best = -1;
+  for ( int i = 0; i < (int) ( sizeof( counts ) / sizeof( counts[ 0 ] ) ); i++ ) {
+    if ( i > 0 && counts[ i ] <= counts[ i - 1 ] ) {
+      continue;
+    }
+    double rate = runTrial( counts[ i ] );
+    if ( log != NULL ) {
+      fprintf( log, "autotune: %d threads: %.0f hashes/s\n", counts[ i ], rate );
+    }
+    if ( rate > best ) {
+      best = rate;
+      tuning->threads = counts[ i ];
+    }
+  }
+  tuning->rate = best / tuning->threads;
+
+  setMd5Backend( current );
+}
+
+/**
+ * Returns the name of the tuning cache file the options choose.
+ * 
+ * @param opts options naming the cache file
+ * @return the name, which the caller frees
+ */
+static char *tuneFileName( Options const *opts )
+{
+  char const *home = getenv( "HOME" );
+  if ( opts->tuneName != NULL || home == NULL ) {
+    return strdup( opts->tuneName != NULL ? opts->tuneName : TUNE_FILE_NAME );
+  }
+
+  char *name = (char *)malloc( strlen( home ) + sizeof( TUNE_FILE_NAME ) + 1 );
+  sprintf( name, "%s/%s", home, TUNE_FILE_NAME );
+  return name;
+}
+
+/**
+ * Finds this host's tuning in the cache file the options name.
+ * 
+ * @param opts options naming the cache file
+ * @param tuning where the tuning is stored, if there is one
+ * @return true if the cache has a tuning for this host
+ */
+bool cachedTuning( Options const *opts, Tuning *tuning )
+{
+  HostKey key;
+  hostKey( &key );
+
+  char *name = tuneFileName( opts );
+  bool found = loadTuning( name, &key, tuning );
+  free( name );
+  return found;
+}
+
+/**
+ * Fills in the settings the command line left at their defaults from
+ * this host's cached tuning, measuring and caching one first if there
+ * isn't any.
+ * 
+ * @param opts options to tune
+ * @param log stream the settings used are reported on, or NULL
+ */
+void autotune( Options *opts, FILE *log )
+{
+  HostKey key;
+  hostKey( &key );
+
+  char *name = tuneFileName( opts );
+  Tuning tuning;
+  if ( loadTuning( name, &key, &tuning ) ) {
+    if ( log != NULL ) {
+      fprintf( log, "autotune: cached settings for %s, %d CPUs\n", key.model, key.cpus );
+    }
+  } else {
+    runTrials( &key, &tuning, log );
+    if ( !saveTuning( name, &key, &tuning ) ) {
+      perror( name );
+    }
+  }
+  free( name );
+
+  // a backend this build lacks is left at the default
+  if ( opts->md5Backend == NULL && setMd5Backend( tuning.backend ) ) {
+    opts->md5Backend = md5BackendName();
+  }
+  if ( opts->threads == 0 ) {
+    opts->threads = tuning.threads;
+  }
+
+  if ( log != NULL ) {
+    fprintf( log, "autotune: %d threads, md5 backend %s\n",
+             workerCount( opts->threads ), md5BackendName() );
+  }
+}
@@ -12,9 +12,20 @@
 #include "block.h"
 #include "md5.h"
 #include "password.h"
+#include "pool.h"
+#include "targets.h"
+#include "mask.h"
+#include "markov.h"
+#include "bloom.h"
+#include "policy.h"
+#include "rawmd5.h"
+#include "shacrypt.h"
+#include "tune.h"
+#include "plan.h"
+#include "workers.h"
 
 /** Number of tests we should have, if they're all turned on. */
-#define EXPECTED_TOTAL 60
+#define EXPECTED_TOTAL 126
 
 /** Total number or tests we tried. */
 static int totalTests = 0;
@@ -394,6 +405,31 @@ int main()
     freeBlock( block );
   }
 
+  // Test the MD5 backends.
+
+  {
+    TestCase( !setMd5Backend( "bogus" ) );
+    TestCase( strcmp( md5BackendName(), MD5_BACKEND_INTREE ) == 0 );
+
+    // Every backend in this build must give the same digest.
+    byte expected[] = { 0x9E, 0x10, 0x7D, 0x9D, 0x37, 0x2B, 0xB6, 0x82,
+                        0x6B, 0xD8, 0x1D, 0x35, 0x42, 0xA4, 0x19, 0xD6 };
+    bool same = true;
+    for ( int i = 0; md5BackendAt( i ) != NULL; i++ ) {
+      same = same && setMd5Backend( md5BackendAt( i ) );
+
+      Block *block = makeBlock();
+      appendString( block, "The quick brown fox jumps over the lazy dog" );
+      byte hash[ HASH_SIZE ];
+      md5Hash( block, hash );
+      same = same && cmpBytes( hash, expected, sizeof( hash ) );
+      freeBlock( block );
+    }
+    TestCase( same );
+
+    TestCase( setMd5Backend( MD5_BACKEND_INTREE ) );
+  }
+
   ///////////////////////////////////////////////////////////////
   // Test the password component
 
@@ -555,6 +591,338 @@ int main()
     TestCase( strcmp( result, "JKUg1ByWFvKwjFHwMFLcD1" ) == 0 );
   }
 
+  {
+    // Converting a hash string back to bytes gives the raw hash.
+    byte raw[ HASH_SIZE ];
+    byte decoded[ HASH_SIZE ];
+    char result[ PW_HASH_LIMIT + 1 ];
+
+    hashPasswordRaw( "abc123", "abcdefgh", raw );
+    hashToString( raw, result );
+    TestCase( strcmp( result, "MPPZJeod4Sk89awLhwv591" ) == 0 );
+    TestCase( stringToHash( "MPPZJeod4Sk89awLhwv591", decoded ) );
+    TestCase( cmpBytes( raw, decoded, HASH_SIZE ) );
+
+    // Short strings and leftover bits in the last letter are rejected.
+    TestCase( !stringToHash( "MPPZJeod4Sk89awLhwv59", decoded ) );
+    TestCase( !stringToHash( "MPPZJeod4Sk89awLhwv59z", decoded ) );
+  }
+
+  ///////////////////////////////////////////////////////////////
+  // Tests for the target store component
+
+  {
+    TargetStore *store = makeTargets();
+
+    addTarget( store, "bob", "abcdefgh", "MPPZJeod4Sk89awLhwv591" );
+    addTarget( store, "alice", "rVu9zC1N", "JKUg1ByWFvKwjFHwMFLcD1" );
+    addTarget( store, "eve", "abcdefgh", "MPPZJeod4Sk89awLhwv591" );
+    finishTargets( store );
+
+    // Targets sharing a salt land in one group, in the order added.
+    TestCase( store->saltCount == 2 && store->groupStart[ 1 ] == 2 &&
+              store->order[ 0 ] == 0 && store->order[ 1 ] == 2 &&
+              strcmp( targetName( store, store->order[ 1 ] ), "eve" ) == 0 );
+
+    // A copy of the digest index finds the same targets as the store.
+    TargetStore *copy = copyDigestIndex( store );
+    byte hash[ HASH_SIZE ];
+    memcpy( hash, store->digests[ 1 ], HASH_SIZE );
+    TestCase( findInGroup( copy, 1, hash, copy->groupStart[ 1 ] ) == 2 &&
+              copy->digests != store->digests );
+    freeDigestIndex( copy );
+
+    freeTargets( store );
+  }
+
+  {
+    TargetStore *store = makeTargets();
+
+    addRawTarget( store, "a", "s", "ff000000000000000000000000000000" );
+    addRawTarget( store, "b", "s", "00000000000000000000000000000001" );
+    addRawTarget( store, "c", "s", "80000000000000000000000000000000" );
+    addRawTarget( store, "d", "s", "80000000000000000000000000000000" );
+    addRawTarget( store, "e", "s", "0000000000000000000000000000000g" );
+    finishTargets( store );
+
+    // A group's digests are sorted, and a search starts by bisecting them.
+    byte hash[ HASH_SIZE ];
+    memcpy( hash, store->digests[ 0 ], HASH_SIZE );
+    TestCase( store->order[ 4 ] == 0 && findInGroup( store, 0, hash, 0 ) == 4 );
+
+    // Equal digests sit next to each other, in the order added.
+    memcpy( hash, store->digests[ 2 ], HASH_SIZE );
+    int k = findInGroup( store, 0, hash, 0 );
+    TestCase( store->order[ k ] == 2 && store->order[ k + 1 ] == 3 &&
+              findInGroup( store, 0, hash, k + 1 ) == k + 1 &&
+              findInGroup( store, 0, hash, k + 2 ) == -1 );
+
+    // Invalid targets are never found.
+    memcpy( hash, store->digests[ 4 ], HASH_SIZE );
+    TestCase( !store->valid[ 4 ] && findInGroup( store, 0, hash, 0 ) == -1 );
+
+    freeTargets( store );
+  }
+
+  ///////////////////////////////////////////////////////////////
+  // Tests for the word pool component
+
+  {
+    WordPool *pool = makeWordPool();
+
+    appendWord( pool, "abc123" );
+    appendWord( pool, "fifteencharsxyz" );
+    TestCase( pool->count == 2 );
+    TestCase( strcmp( pool->slots[ 0 ], "abc123" ) == 0 );
+    TestCase( pool->lens[ 1 ] == 15 );
+
+    // Words are padded with zeros to the end of their slot.
+    TestCase( pool->slots[ 0 ][ PW_LIMIT ] == '\0' && pool->slots[ 0 ][ 6 ] == '\0' );
+
+    // Growing the pool keeps the words it already has.
+    for ( int i = 0; i < 5000; i++ )
+      appendWord( pool, "x" );
+    TestCase( pool->count == 5002 && strcmp( pool->slots[ 1 ], "fifteencharsxyz" ) == 0 );
+
+    freeWordPool( pool );
+  }
+
+  ///////////////////////////////////////////////////////////////
+  // Tests for the mask component
+
+  {
+    Mask mask;
+    int digits[ PW_LIMIT ];
+    char out[ PW_LIMIT + 1 ] = "";
+
+    TestCase( parseMask( "x?d?l", &mask ) );
+    TestCase( mask.len == 3 && mask.size == 260 );
+
+    // The last position changes fastest.
+    seekMask( &mask, 27, digits, out );
+    TestCase( strncmp( out, "x1b", 3 ) == 0 );
+    nextMask( &mask, digits, out );
+    TestCase( strncmp( out, "x1c", 3 ) == 0 );
+    seekMask( &mask, 25, digits, out );
+    nextMask( &mask, digits, out );
+    TestCase( strncmp( out, "x1a", 3 ) == 0 );
+
+    // Unknown classes and masks longer than a password are refused.
+    TestCase( !parseMask( "?q", &mask ) );
+    TestCase( !parseMask( "?d?d?d?d?d?d?d?d?d?d?d?d?d?d?d?d", &mask ) );
+  }
+
+  ///////////////////////////////////////////////////////////////
+  // Tests for the Markov component
+
+  {
+    WordPool *pool = makeWordPool();
+    appendWord( pool, "ab" );
+    appendWord( pool, "ab" );
+    appendWord( pool, "ac" );
+
+    MarkovStats *markov = (MarkovStats *)calloc( 1, sizeof( MarkovStats ) );
+    trainMarkov( markov, pool );
+    TestCase( markov->counts[ 0 ][ 0 ][ 'a' - MARKOV_FIRST_CHAR ] == 3 );
+    TestCase( markov->counts[ 1 ][ 1 + 'a' - MARKOV_FIRST_CHAR ][ 'b' - MARKOV_FIRST_CHAR ] == 2 );
+
+    // Candidates come by total rank, then length; unseen characters rank last.
+    Keyspace *ks = makeMarkovKeyspace( markov, 2, 2 );
+    TestCase( ks->size == 6 );
+
+    Batch *batch = makeBatch( ks->size );
+    ks->fill( ks, 0, ks->size, batch );
+    TestCase( strcmp( batch->words[ 0 ], "a" ) == 0 && strcmp( batch->words[ 1 ], "ab" ) == 0 &&
+              strcmp( batch->words[ 2 ], " " ) == 0 && strcmp( batch->words[ 3 ], "ac" ) == 0 &&
+              strcmp( batch->words[ 4 ], "  " ) == 0 && strcmp( batch->words[ 5 ], " !" ) == 0 );
+
+    // Any range can be produced on its own.
+    batch->count = 0;
+    ks->fill( ks, 3, 4, batch );
+    TestCase( batch->count == 1 && strcmp( batch->words[ 0 ], "ac" ) == 0 && batch->index[ 0 ] == 3 );
+
+    freeBatch( batch );
+    freeKeyspace( ks );
+    free( markov );
+    freeWordPool( pool );
+  }
+
+  ///////////////////////////////////////////////////////////////
+  // Tests for the repeat filter component
+
+  {
+    BloomFilter *bf = makeBloomFilter( BLOOM_BLOCK_BYTES * 4 );
+
+    // A candidate is new the first time only; length counts too.
+    TestCase( !bloomTestAndSet( bf, "batman", 6 ) );
+    TestCase( bloomTestAndSet( bf, "batman", 6 ) );
+    TestCase( !bloomTestAndSet( bf, "batman", 3 ) );
+
+    Password hello = "hello";
+    Password batman = "batman";
+    Password ninja = "ninja";
+    Batch *batch = makeBatch( 4 );
+    addCandidate( batch, hello, 5, 10 );
+    addCandidate( batch, batman, 6, 11 );
+    addCandidate( batch, ninja, 5, 12 );
+    addCandidate( batch, hello, 5, 13 );
+    TestCase( dropRepeats( bf, batch ) == 2 && batch->count == 2 &&
+              strcmp( batch->words[ 1 ], "ninja" ) == 0 && batch->index[ 1 ] == 12 );
+
+    freeBatch( batch );
+    freeBloomFilter( bf );
+  }
+
+  ///////////////////////////////////////////////////////////////
+  // Tests for the password policy component
+
+  {
+    Policy policy;
+    Password weak = "password";
+    Password strong = "Passw0rd!";
+    Password spaced = "Pass w0rd";
+
+    TestCase( parsePolicy( "min=8,upper,digit,forbid= ", &policy ) );
+    TestCase( !meetsPolicy( &policy, weak, 8 ) );
+    TestCase( meetsPolicy( &policy, strong, 9 ) );
+    TestCase( !meetsPolicy( &policy, spaced, 9 ) );
+
+    // Counting classes looks only at the candidate's own characters.
+    TestCase( parsePolicy( "classes=4", &policy ) );
+    TestCase( meetsPolicy( &policy, strong, 9 ) && !meetsPolicy( &policy, strong, 8 ) );
+
+    TestCase( !parsePolicy( "min=9,max=8", &policy ) );
+    TestCase( !parsePolicy( "lowercase", &policy ) );
+  }
+
+  ///////////////////////////////////////////////////////////////
+  // Tests for the raw MD5 component
+
+  {
+    byte hash[ HASH_SIZE ];
+    byte expected[ HASH_SIZE ] = { 0x5f, 0x4d, 0xcc, 0x3b, 0x5a, 0xa7, 0x65, 0xd6,
+                                   0x1d, 0x83, 0x27, 0xde, 0xb8, 0x82, 0xcf, 0x99 };
+    rawHashSlow( "", "password", hash );
+    TestCase( cmpBytes( hash, expected, HASH_SIZE ) );
+
+    TargetStore *store = makeTargets();
+    addRawTarget( store, "alice", "", "5f4dcc3b5aa765d61d8327deb882cf99" );
+    addRawTarget( store, "bob", "abcdefghijklmnopqrst", "67B927D1F95D4E71930BA9F12851139F" );
+    addRawTarget( store, "carol", "salt", "5f4dcc3b5aa765d61d8327deb882cf9" );
+    finishTargets( store );
+    TestCase( store->saltCount == 3 && store->valid[ 1 ] && !store->valid[ 2 ] );
+
+    // The fast hash matches the slow one, even for the longest salt and password.
+    RawSalt rs;
+    PreparedWord pw = { "fifteencharsxyz", 15 };
+    prepareRawSalt( &rs, store, store->saltIds[ 1 ] );
+    rawHashSlow( "abcdefghijklmnopqrst", "fifteencharsxyz", expected );
+    TestCase( rawHash( &rs, &pw, hash ) && cmpBytes( hash, expected, HASH_SIZE ) );
+
+    // Candidates that can't match any target are given up early.
+    PreparedWord wrong = { "fifteencharsxyy", 15 };
+    TestCase( !rawHash( &rs, &wrong, hash ) );
+    freeRawSalt( &rs );
+
+    // A group with no valid targets never finishes a hash.
+    PreparedWord pass = { "password", 8 };
+    prepareRawSalt( &rs, store, store->saltIds[ 2 ] );
+    TestCase( rs.checkCount == 0 && !rawHash( &rs, &pass, hash ) );
+    freeRawSalt( &rs );
+
+    freeTargets( store );
+  }
+
+  ///////////////////////////////////////////////////////////////
+  // Tests for the SHA-crypt component
+
+  {
+    ShaSalt ss;
+    byte digest[ SHA512_DIGEST ];
+    byte expected[ SHA512_DIGEST ];
+
+    // Published test vectors, with the default 5000 rounds.
+    TestCase( parseShaSetting( &ss, SHA512_DIGEST, "saltstring" ) && ss.rounds == SHA_ROUNDS_DEFAULT );
+    shaCrypt( &ss, "Hello world!", 12, digest );
+    TestCase( shaStringToHash( SHA512_DIGEST, "svn8UoSVapNtMuq1ukKS4tPQd8iKwSMHWjl/O817G3uBnIFNjnQJuesI68u4OTLiBFdcbYEdFCoEOfaS35inz1", expected ) &&
+              cmpBytes( digest, expected, SHA512_DIGEST ) );
+
+    parseShaSetting( &ss, SHA256_DIGEST, "saltstring" );
+    shaCrypt( &ss, "Hello world!", 12, digest );
+    TestCase( shaStringToHash( SHA256_DIGEST, "5B8vYYiY.CVt1RlTTf8KbXBH3hsxY/GNooZaBBGWEc5", expected ) &&
+              cmpBytes( digest, expected, SHA256_DIGEST ) );
+
+    // Each lane gets the same digest as hashing its password alone.
+    char const *pass[ SHA_LANES ] = { "ninja", "hello", "ninja", "bliss" };
+    byte digests[ SHA_LANES ][ SHA512_DIGEST ];
+    TestCase( parseShaSetting( &ss, SHA512_DIGEST, "rounds=1000$abc" ) );
+    shaCryptLanes( &ss, pass, 5, digests );
+    shaCrypt( &ss, "hello", 5, digest );
+    TestCase( cmpBytes( digests[ 1 ], digest, SHA512_DIGEST ) &&
+              cmpBytes( digests[ 0 ], digests[ 2 ], SHA512_DIGEST ) &&
+              !cmpBytes( digests[ 0 ], digests[ 1 ], SHA512_DIGEST ) );
+
+    // Rounds are kept within limits; bad settings and hashes are refused.
+    TestCase( parseShaSetting( &ss, SHA512_DIGEST, "rounds=10$roundstoolow" ) &&
+              ss.rounds == SHA_ROUNDS_MIN && strcmp( ss.salt, "roundstoolow" ) == 0 );
+    TestCase( !parseShaSetting( &ss, SHA512_DIGEST, "rounds=x$salt" ) &&
+              !parseShaSetting( &ss, SHA512_DIGEST, "seventeencharsalt" ) &&
+              !shaStringToHash( SHA256_DIGEST, "5B8vYYiY.CVt1RlTTf8KbXBH3hsxY/GNooZaBBGWEcz", expected ) );
+  }
+
+  // Test saving and loading host tunings.
+
+  {
+    char const *name = "unitTest-tune.tmp";
+    remove( name );
+
+    HostKey small = { "Test CPU", 8, 4 };
+    HostKey big = { "Test CPU", 64, 32 };
+    Tuning tuning = { 4, MD5_BACKEND_INTREE };
+    Tuning found;
+
+    TestCase( !loadTuning( name, &small, &found ) );
+
+    saveTuning( name, &small, &tuning );
+    tuning.threads = 64;
+    saveTuning( name, &big, &tuning );
+    TestCase( loadTuning( name, &small, &found ) && found.threads == 4 &&
+              strcmp( found.backend, MD5_BACKEND_INTREE ) == 0 );
+
+    // Saving a host again replaces its tuning and keeps the others.
+    tuning.threads = 48;
+    saveTuning( name, &big, &tuning );
+    TestCase( loadTuning( name, &big, &found ) && found.threads == 48 );
+    TestCase( loadTuning( name, &small, &found ) && found.threads == 4 );
+
+    remove( name );
+  }
+
+  // Test the formatDuration() function.
+
+  {
+    char buf[ DURATION_LIMIT + 1 ];
+    formatDuration( 12.54, buf );
+    TestCase( strcmp( buf, "12.5s" ) == 0 );
+
+    formatDuration( 3 * 86400 + 4 * 3600 + 5 * 60 + 6, buf );
+    TestCase( strcmp( buf, "3d 04h 05m" ) == 0 );
+
+    formatDuration( 3600 + 59.6, buf );
+    TestCase( strcmp( buf, "1h 01m 00s" ) == 0 );
+  }
+
+  // Test the parseCpuList() function.
+
+  {
+    WorkerLimits limits;
+    TestCase( parseCpuList( "0-3,8", &limits ) && limits.cpuCount == 5 &&
+              limits.cpus[ 0 ] == 0 && limits.cpus[ 3 ] == 3 && limits.cpus[ 4 ] == 8 );
+    TestCase( !parseCpuList( "3-1", &limits ) );
+    TestCase( !parseCpuList( "1,,2", &limits ) );
+    TestCase( !parseCpuList( "", &limits ) );
+  }
+
   // Once you move the #ifdef DISABLE_TESTS to here, you've enabled
   // all the tests.
   
@@ -0,0 +1,371 @@
+/**
+ * @file workers.c
+ * @author Luke Early
+ * Starts and joins the threads that do the hashing work, and keeps
+ * them within the share of the host they are allowed.
+ */
+
+#include "workers.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+/** Where a cgroup v2 hierarchy is mounted, and its CPU quota file. */
+#define CGROUP2_ROOT "/sys/fs/cgroup"
+#define CGROUP2_CPU_MAX "cpu.max"
+
+/** Files holding a cgroup v1 CPU quota and its period, in microseconds. */
+#define CGROUP1_QUOTA "/sys/fs/cgroup/cpu/cpu.cfs_quota_us"
+#define CGROUP1_PERIOD "/sys/fs/cgroup/cpu/cpu.cfs_period_us"
+
+/** File naming the cgroups of this process. */
+#define PROC_CGROUP "/proc/self/cgroup"
+
+/** Start of the line of PROC_CGROUP for the cgroup v2 hierarchy. */
+#define CGROUP2_LINE "0::"
+
+/** Length of the longest cgroup path used. */
+#define CGROUP_PATH_LIMIT 4095
+
+/** ioprio_set() arguments for the lowest best-effort I/O priority of this process. */
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_BE 2
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_LOWEST 7
+
+/** Nanoseconds in a second. */
+#define NS_PER_SEC 1000000000LL
+
+/** Arguments handed to each worker thread. */
+typedef struct {
+  int id;
+  WorkerFunction fn;
+  void *ctx;
+} WorkerArgs;
+
+/** Limits workers run under. */
+static WorkerLimits limits = { .maxCpu = FULL_CPU };
+
+/** When the calling worker last called throttleWorker(), by the clock and by its CPU time. */
+static __thread long long windowWall;
+static __thread long long windowCpu;
+
+/**
+ * Reads a clock in nanoseconds.
+ * 
+ * @param clock clock to read
+ * @return the clock's time
+ */
+static long long clockNs( clockid_t clock )
+{
+  struct timespec ts;
+  clock_gettime( clock, &ts );
+  return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+/**
+ * Start routine for every worker thread.
+ * 
+ * @param arg this thread's WorkerArgs
+ * @return always NULL
+ */
+static void *workerMain( void *arg )
+{
+  WorkerArgs *args = (WorkerArgs *)arg;
+
+  if ( limits.cpuCount > 0 ) {
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    CPU_SET( limits.cpus[ args->id % limits.cpuCount ], &set );
+    pthread_setaffinity_np( pthread_self(), sizeof( set ), &set );
+  }
+
+  // on Linux, each thread has its own niceness
+  if ( limits.nice > 0 ) {
+    setpriority( PRIO_PROCESS, syscall( SYS_gettid ), limits.nice );
+  }
+
+  char name[ TRACE_NAME_LIMIT + 1 ];
+  snprintf( name, sizeof( name ), "worker %d", args->id );
+  traceThreadName( name );
+
+  windowWall = clockNs( CLOCK_MONOTONIC );
+  windowCpu = clockNs( CLOCK_THREAD_CPUTIME_ID );
+
+  args->fn( args->id, args->ctx );
+  return NULL;
+}
+
+/**
+ * Parses a list of CPUs such as "0-3,8,10-11".
+ * 
+ * @param str the list
+ * @param limits where the CPUs are stored
+ * @return false if the list is not valid
+ */
+bool parseCpuList( char const *str, WorkerLimits *limits )
+{
+  limits->cpuCount = 0;
+
+  while ( true ) {
+    char *end;
+    long first = strtol( str, &end, 10 );
+    long last = first;
+    if ( end == str || *str == '-' || *str == '+' ) {
+      return false;
+    }
+    if ( *end == '-' ) {
+      str = end + 1;
+      last = strtol( str, &end, 10 );
+      if ( end == str || *str == '-' || *str == '+' ) {
+        return false;
+      }
+    }
+    if ( last < first || last >= CPU_SETSIZE ) {
+      return false;
+    }
+
+    for ( long cpu = first; cpu <= last; cpu++ ) {
+      if ( limits->cpuCount == MAX_AFFINITY ) {
+        return false;
+      }
+      limits->cpus[ limits->cpuCount++ ] = cpu;
+    }
+
+    if ( *end == '\0' ) {
+      return true;
+    }
+    if ( *end != ',' ) {
+      return false;
+    }
+    str = end + 1;
+  }
+}
+
+/**
+ * Sets the limits every worker started afterwards runs under.  A
+ * positive niceness also gives the whole process the lowest
+ * best-effort I/O priority, so its reading yields to other services.
+ * 
+ * @param newLimits the limits
+ */
+void setWorkerLimits( WorkerLimits const *newLimits )
+{
+  limits = *newLimits;
+
+  if ( limits.nice > 0 ) {
+    syscall( SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+             IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT | IOPRIO_LOWEST );
+  }
+}
+
+/**
+ * Reads a cgroup v2 cpu.max file.
+ * 
+ * @param name file name
+ * @param quota where the quota is stored
+ * @param period where the period is stored
+ * @return false if the file is missing or has no quota
+ */
+static bool readCpuMax( char const *name, long long *quota, long long *period )
+{
+  FILE *fp = fopen( name, "r" );
+  if ( fp == NULL ) {
+    return false;
+  }
+
+  // a file reading "max 100000" has no quota
+  bool ok = fscanf( fp, "%lld %lld", quota, period ) == 2;
+  fclose( fp );
+  return ok;
+}
+
+/**
+ * Reads a number from a cgroup v1 file.
+ * 
+ * @param name file name
+ * @return the number, or -1 if there isn't one
+ */
+static long long readCgroupValue( char const *name )
+{
+  FILE *fp = fopen( name, "r" );
+  if ( fp == NULL ) {
+    return -1;
+  }
+
+  long long val;
+  if ( fscanf( fp, "%lld", &val ) != 1 ) {
+    val = -1;
+  }
+  fclose( fp );
+  return val;
+}
+
+/**
+ * Finds the tightest CPU quota on a cgroup v2 cgroup and the cgroups
+ * above it, since a quota on a parent, such as a systemd slice's
+ * CPUQuota=, limits everything below it too.
+ * 
+ * @param dir path of the cgroup below CGROUP2_ROOT, cut short in place
+ * @param quota where the tightest quota is stored
+ * @param period where its period is stored
+ * @return false if none of the cgroups has a quota
+ */
+static bool cgroup2Quota( char *dir, long long *quota, long long *period )
+{
+  bool found = false;
+
+  while ( true ) {
+    char path[ CGROUP_PATH_LIMIT + sizeof( CGROUP2_ROOT ) + sizeof( CGROUP2_CPU_MAX ) ];
+    snprintf( path, sizeof( path ), "%s%s/%s", CGROUP2_ROOT, dir, CGROUP2_CPU_MAX );
+
+    // keep whichever quota is worth the fewest CPUs
+    long long q, p;
+    if ( readCpuMax( path, &q, &p ) && q > 0 && p > 0 &&
+         ( !found || q * *period < *quota * p ) ) {
+      *quota = q;
+      *period = p;
+      found = true;
+    }
+
+    char *slash = strrchr( dir, '/' );
+    if ( slash == NULL ) {
+      return found;
+    }
+    *slash = '\0';
+  }
+}
+
+/**
+ * Returns the number of CPUs the process's cgroup CPU quota is worth,
+ * rounded up.
+ * 
+ * @return CPUs of quota, or 0 if there is no quota
+ */
+int cpuQuota( void )
+{
+  long long quota = -1;
+  long long period = -1;
+
+  // cgroup v2: the process's own cgroup and every one above it
+  bool found = false;
+  FILE *fp = fopen( PROC_CGROUP, "r" );
+  if ( fp != NULL ) {
+    char line[ CGROUP_PATH_LIMIT + 1 ];
+    while ( !found && fgets( line, sizeof( line ), fp ) != NULL ) {
+      if ( strncmp( line, CGROUP2_LINE, strlen( CGROUP2_LINE ) ) == 0 ) {
+        line[ strcspn( line, "\n" ) ] = '\0';
+        found = cgroup2Quota( line + strlen( CGROUP2_LINE ), &quota, &period );
+      }
+    }
+    fclose( fp );
+  }
+
+  if ( !found && !readCpuMax( CGROUP2_ROOT "/" CGROUP2_CPU_MAX, &quota, &period ) ) {
+    quota = readCgroupValue( CGROUP1_QUOTA );
+    period = readCgroupValue( CGROUP1_PERIOD );
+  }
+
+  if ( quota <= 0 || period <= 0 ) {
+    return 0;
+  }
+  return (int) ( ( quota + period - 1 ) / period );
+}
+
+/**
+ * Returns the number of worker threads to use.
+ * 
+ * @param requested count asked for on the command line, 0 for the default
+ * @return requested if it is positive, otherwise one per CPU the
+ *         process may run on, as the affinity list, the CPU mask and
+ *         the cgroup quota allow
+ */
+int workerCount( int requested )
+{
+  if ( requested > 0 ) {
+    return requested;
+  }
+
+  long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+
+  cpu_set_t set;
+  if ( sched_getaffinity( 0, sizeof( set ), &set ) == 0 && CPU_COUNT( &set ) < cpus ) {
+    cpus = CPU_COUNT( &set );
+  }
+  if ( limits.cpuCount > 0 && limits.cpuCount < cpus ) {
+    cpus = limits.cpuCount;
+  }
+
+  int quota = cpuQuota();
+  if ( quota > 0 && quota < cpus ) {
+    cpus = quota;
+  }
+
+  return cpus > 0 ? (int) cpus : 1;
+}
+
+/**
+ * Sleeps long enough, if there is a --max-cpu limit, to bring the
+ * calling worker's time hashing since it last called down to the
+ * limit.  Workers call this between tiles or batches of work.
+ */
+void throttleWorker( void )
+{
+  if ( limits.maxCpu >= FULL_CPU ) {
+    return;
+  }
+
+  long long busy = clockNs( CLOCK_THREAD_CPUTIME_ID ) - windowCpu;
+  long long wall = clockNs( CLOCK_MONOTONIC ) - windowWall;
+  long long owed = busy * FULL_CPU / limits.maxCpu - wall;
+  if ( owed > 0 ) {
+    long long span = traceBegin();
+    struct timespec ts = { owed / NS_PER_SEC, owed % NS_PER_SEC };
+    nanosleep( &ts, NULL );
+    traceEnd( "throttle", span );
+  }
+
+  windowWall = clockNs( CLOCK_MONOTONIC );
+  windowCpu = clockNs( CLOCK_THREAD_CPUTIME_ID );
+}
+
+/**
+ * Runs fn on count threads at once and waits for all of them to
+ * finish.  Each thread is passed its id, from 0 to count - 1, and
+ * the shared ctx pointer.  Each thread is pinned and reniced as the
+ * worker limits say.
+ * 
+ * @param count number of threads
+ * @param fn function run by each thread
+ * @param ctx state shared by every thread
+ */
+void runWorkers( int count, WorkerFunction fn, void *ctx )
+{
+  pthread_t *threads = (pthread_t *)malloc( count * sizeof( pthread_t ) );
+  WorkerArgs *args = (WorkerArgs *)malloc( count * sizeof( WorkerArgs ) );
+
+  for ( int i = 0; i < count; i++ ) {
+    args[ i ].id = i;
+    args[ i ].fn = fn;
+    args[ i ].ctx = ctx;
+
+    if ( pthread_create( &threads[ i ], NULL, workerMain, &args[ i ] ) != 0 ) {
+      perror( "pthread_create" );
+      exit( EXIT_FAILURE );
+    }
+  }
+
+  for ( int i = 0; i < count; i++ ) {
+    pthread_join( threads[ i ], NULL );
+  }
+
+  free( args );
+  free( threads );
+}
@@ -126,8 +126,8 @@ runTest() {
     echo "Test $TESTNO"
     rm -f stdout.txt stderr.txt
 
-    echo "   ./crack ${args[@]} > stdout.txt 2> stderr.txt"
-    ./crack ${args[@]} > stdout.txt 2> stderr.txt
+    echo "   ./crack ${args[@]} < ${input:-/dev/null} > stdout.txt 2> stderr.txt"
+    ./crack ${args[@]} < ${input:-/dev/null} > stdout.txt 2> stderr.txt
     ASTATUS=$?
 
     if ! checkStatus "$ESTATUS" "$ASTATUS" ||
@@ -205,6 +205,177 @@ if [ -x crack ]; then
     args=(-extra dictionary-13.txt shadow-13.txt)
     runTest 13 1
     
+    args=(--pipeline --threads 1 dictionary-05.txt shadow-05.txt)
+    runTest 14 0
+    
+    input=dictionary-04.txt
+    args=(--pipeline --threads 2 - shadow-04.txt)
+    runTest 15 0
+    unset input
+    
+    args=(--hybrid-suffix ?d?d dictionary-16.txt shadow-16.txt)
+    runTest 16 0
+    
+    args=(--combine dictionary-17a.txt dictionary-17b.txt shadow-17.txt)
+    runTest 17 0
+    
+    rm -f markov-18.stats
+    args=(--markov-train markov-18.stats dictionary-18.txt)
+    runTest 18 0
+    
+    args=(--markov markov-18.stats --markov-length 3 shadow-19.txt)
+    runTest 19 0
+    rm -f markov-18.stats
+    
+    args=(--prince dictionary-20.txt shadow-20.txt)
+    runTest 20 0
+    
+    args=(--tiers 100,400 dictionary-07.txt shadow-07.txt)
+    runTest 21 0
+    
+    args=(--dedupe 1 dictionary-22.txt shadow-05.txt)
+    runTest 22 0
+    
+    args=(--policy min=6,max=8,lower dictionary-05.txt shadow-05.txt)
+    runTest 23 0
+    
+    rm -f audit-24.state
+    args=(--state audit-24.state dictionary-05.txt shadow-05.txt)
+    runTest 24 0
+    
+    args=(--state audit-24.state dictionary-25.txt shadow-25.txt)
+    runTest 25 0
+    rm -f audit-24.state
+    
+    rm -f daemon-26.sock
+    ./crack --daemon daemon-26.sock --threads 1 dictionary-05.txt &
+    for try in {1..50}; do [ -S daemon-26.sock ] && break; sleep 0.1; done
+    input=daemon-26.txt
+    args=(--connect daemon-26.sock)
+    runTest 26 0
+    wait
+    input=
+    
+    args=(--manifest manifest-27.txt dictionary-05.txt shadow-05.txt)
+    runTest 27 0
+    
+    rm -f salt-28.index
+    args=(--build-index salt-28.index --index-salt dBufmvX4 dictionary-05.txt)
+    runTest 28 0
+    
+    args=(--index salt-28.index dictionary-05.txt shadow-05.txt)
+    runTest 29 0
+    rm -f salt-28.index
+    
+    args=(--hash hash-30.txt --threads 2)
+    runTest 30 0
+    
+    args=(dictionary-05.txt shadow-31.txt)
+    runTest 31 0
+    
+    args=(dictionary-05.txt shadow-32.txt)
+    runTest 32 0
+    
+    rm -f tune-33.txt
+    args=(--autotune --tune-file tune-33.txt dictionary-01.txt shadow-01.txt)
+    runTest 33 0
+    runTest 33 0
+    rm -f tune-33.txt
+    
+    rm -f trace-34.json
+    args=(--trace trace-34.json --threads 2 dictionary-05.txt shadow-05.txt)
+    runTest 34 0
+    if [ ! -s trace-34.json ]; then
+	fail "FAILED - no trace written"
+    fi
+    rm -f trace-34.json
+    
+    # a slow job holds the daemon's only worker, one word at a time
+    rm -f daemon-35.sock order-35.txt
+    cp dictionary-05.txt dictionary-35.txt
+    ./crack --daemon daemon-35.sock --threads 1 --tile-words 1 dictionary-35.txt &
+    for try in {1..50}; do [ -S daemon-35.sock ] && break; sleep 0.1; done
+    ./crack --connect daemon-35.sock < daemon-35a.txt > slow-35.txt &
+    slow=$!
+    for try in {1..50}; do grep -q QUEUED slow-35.txt && break; sleep 0.1; done
+
+    # jobs queued behind it are worked on highest priority first
+    ( ./crack --connect daemon-35.sock < daemon-35b.txt > /dev/null; echo low >> order-35.txt ) &
+    ( ./crack --connect daemon-35.sock < daemon-35c.txt > /dev/null; echo high >> order-35.txt ) &
+    for try in {1..100}; do [ -f order-35.txt ] && [ "$(wc -l < order-35.txt)" = 2 ] && break; sleep 0.1; done
+    if [ "$(cat order-35.txt 2>/dev/null)" != "$(printf 'high\nlow')" ]; then
+	fail "FAILED - daemon jobs not run in priority order"
+    fi
+
+    # a client hanging up cancels its job
+    ./crack --connect daemon-35.sock < daemon-35a.txt > hangup-35.txt &
+    client=$!
+    for try in {1..50}; do grep -q QUEUED hangup-35.txt && break; sleep 0.1; done
+    kill $client
+    sleep 1
+    if [ "$(echo CANCEL 3 | ./crack --connect daemon-35.sock)" != UNKNOWN ]; then
+	fail "FAILED - job of a client that hung up was not cancelled"
+    fi
+
+    # a running job can be cancelled from another connection
+    if [ "$(echo CANCEL 0 | ./crack --connect daemon-35.sock)" != OK ]; then
+	fail "FAILED - running daemon job could not be cancelled"
+    fi
+    wait $slow
+    if [ "$(tail -n 1 slow-35.txt)" != "CANCELLED 0" ]; then
+	fail "FAILED - cancelled daemon job did not report CANCELLED"
+    fi
+
+    # a reload picks up words added to the dictionary file
+    echo sunshine >> dictionary-35.txt
+    input=daemon-35.txt
+    args=(--connect daemon-35.sock)
+    runTest 35 0
+    wait
+    input=
+    rm -f dictionary-35.txt order-35.txt slow-35.txt hangup-35.txt
+    
+    args=(--markov model-36.txt $(for i in {1..65}; do echo shadow-05.txt; done))
+    runTest 36 1
+    
+    # a plan times SHA-crypt at its fewest rounds, however many a group asks for
+    echo "Test 37"
+    timeout 20 ./crack --plan dictionary-05.txt shadow-37.txt > plan-37.txt 2> /dev/null
+    if [ $? -ne 0 ]; then
+	fail "FAILED - plan for a group with many rounds did not finish promptly"
+    elif ! grep -q "SHA-512-crypt" plan-37.txt; then
+	fail "FAILED - plan does not list SHA-512-crypt"
+    fi
+    rm -f plan-37.txt
+    
+    # a kept shared dictionary outlives its publisher and is attached to later
+    rm -f /dev/shm/crack-38
+    args=(--shm-dict crack-38 --shm-keep dictionary-05.txt shadow-05.txt)
+    runTest 38 0
+    runTest 38 0
+    if [ ! -e /dev/shm/crack-38 ]; then
+	fail "FAILED - kept shared dictionary was removed"
+    fi
+
+    # it isn't used for a different file or a different word limit
+    cp dictionary-05.txt dictionary-39.txt
+    args=(--shm-dict crack-38 dictionary-39.txt shadow-05.txt)
+    runTest 39 0
+    rm -f dictionary-39.txt
+    args=(--shm-dict crack-38 --max-words 500 dictionary-05.txt shadow-05.txt)
+    runTest 40 0
+
+    # the last run to detach without --shm-keep removes it
+    args=(--shm-dict crack-38 dictionary-05.txt shadow-05.txt)
+    runTest 38 0
+    if [ -e /dev/shm/crack-38 ]; then
+	fail "FAILED - shared dictionary left behind after the last run"
+	rm -f /dev/shm/crack-38
+    fi
+    
+    args=(--threads 4294967297 dictionary-05.txt shadow-05.txt)
+    runTest 41 1
+    
 else
     fail "Since your program didn't compile, no tests were run."
 fi